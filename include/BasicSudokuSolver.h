@@ -0,0 +1,101 @@
+#pragma once
+
+#include "BoardGeometry.h"
+#include "ISudokuSolver.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace Sudoku
+{
+
+// --- Constants
+//! Search nodes the first run of a search gets before it starts over, for every slot of the board. Each run after it gets kRestartGrowthPercent more than the last
+#define kRestartSlotNodes 1
+#define kRestartGrowthPercent 50
+//! Seeds the choices of the runs after the first, so a puzzle is always searched the same way
+#define kRestartSeed 0x9E3779B97F4A7C15ull
+
+//! Backtracking solver for any size of board, BoxSize is the width of a group (2 for 4x4 boards up to 5 for 25x25 boards).
+//  Every table and loop bound comes from BoardGeometry, so each size is compiled into its own unrolled code. The 9x9 board has its own SIMD solver in SudokuSolver.
+//  On large boards one bad guess near the top of the search can leave it stuck under a subtree with no solution for a very long time. So the search starts over once
+//  a run uses up its nodes, breaking ties between branch slots and ordering the values at random, and every run gets more nodes than the last so a search still finishes.
+//  Boards larger than 9x9 also always run pointing and box/line before guessing, which the deduction pipeline only offers for 9x9 boards.
+template<int BoxSize>
+class BasicSudokuSolver : public ISudokuSolver
+{
+public:
+  typedef BoardGeometry<BoxSize> Geometry;
+  typedef typename Geometry::Mask Mask;
+  typedef typename Geometry::Index Index;
+
+  BasicSudokuSolver() {};
+  ~BasicSudokuSolver() {};
+
+  int GetValue(int row, int column) const override { return _values[(row * Geometry::kSize) + column]; }
+  int GetSize() const override { return Geometry::kSize; }
+
+  //! Only a 9x9 board can be loaded this way, any other size is left empty
+  void LoadPuzzle(const int values[kSudokuSize][kSudokuSize]) override;
+  void LoadPuzzleValues(const int* values) override;
+  bool SolvePuzzle() override;
+  uint64_t CountSolutions(uint64_t solution_limit) override;
+
+private:
+  //! The state of a slot before it was changed, used to undo changes when backtracking
+  struct TrailEntry
+  {
+    Index _slot;
+    int8_t _value;
+    Mask _possible_values;
+  };
+
+  //! Returns false if a value was placed twice in a unit, or an empty slot has no possible values
+  bool DeterminePossibleValues();
+  void ResetSearch();
+  //! Depth first search that branches on the empty slot with the fewest possible values, returns true once it should stop or the run is out of nodes
+  bool Search();
+  //! Returns the empty slot with the fewest possible values, the first one found looking from first_slot onwards, or Geometry::kSlots if every slot has been filled
+  int FindBranchSlot(int first_slot) const;
+  //! Next value of the generator behind the choices of randomized runs
+  uint32_t NextRandom();
+  //! Places every naked and hidden single until none are left, returns false if the puzzle became invalid.
+  //  Boards larger than 9x9 take away locked values too whenever the singles run out, see EliminateLockedValues
+  bool PropagateConstraints();
+  //! Pointing and box/line on every row and column. Sets made_progress if any value was taken away, returns false if a slot was left without any possible values
+  bool EliminateLockedValues(bool& made_progress);
+  //! Takes the values away from the slot's possible values for the strategy, returns false if it was left without any
+  bool RemoveValues(int slot, Mask values, uint32_t strategy);
+  //! Solves the slot and removes the value from its peers, returns false if a peer was left without any possible values
+  bool PlaceValue(int slot, int value);
+  //! Restores every slot recorded after the given trail position
+  void UndoTrail(size_t trail_mark);
+
+  //! The value of every slot row by row, kEmptySlot if it hasn't been solved
+  int8_t _values[Geometry::kSlots];
+  //! Bit (n - 1) is set if n is still a possible value for the slot, 0 once it's solved
+  Mask _possible_values[Geometry::kSlots];
+  //! Bitmask of the values already placed in each unit
+  Mask _unit_values[Geometry::kUnits];
+
+  //! Every slot change made while solving, in order
+  std::vector<TrailEntry> _trail;
+  //! Slots that were updated, and now only have 1 possible value
+  std::vector<Index> _newly_single_slots;
+
+  //! Stop searching after finding this many solutions, 0 to find all of them
+  uint64_t _solution_limit = 1;
+  uint64_t _solution_count = 0;
+  //! Guesses in effect at the current point of the search
+  int _search_depth = 0;
+  //! Node count the current run starts over at, and whether it did
+  uint64_t _restart_node_limit = UINT64_MAX;
+  bool _is_restarting = false;
+  //! Only the first run takes the slots and values in order
+  bool _is_randomized = false;
+  uint64_t _random_state = kRestartSeed;
+  //! The first solution found
+  int8_t _solution_values[Geometry::kSlots];
+};
+
+} // namespace Sudoku
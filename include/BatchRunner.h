@@ -0,0 +1,223 @@
+#pragma once
+
+#include "BinaryPuzzleFile.h"
+#include "BitSlicedSolver.h"
+#include "GridRenderer.h"
+#include "ISudokuSolver.h"
+#include "PuzzleCanonicalizer.h"
+#include "SolutionCache.h"
+#include "WorkStealingThreadPool.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace Sudoku
+{
+
+// --- Constants
+//! Number of characters in a 9x9 puzzle written on a single line
+#define kPuzzleLineLength (kSudokuSize * kSudokuSize)
+//! Number of characters in the largest puzzle written on a single line
+#define kMaxPuzzleLineLength (kMaxSudokuSize * kMaxSudokuSize)
+//! Size of the buffer used to stream puzzles in
+#define kBatchBufferSize (1 << 20)
+//! Most lines handed to a worker at once
+#define kBatchChunkLines 1024
+//! Only the puzzle and the character after it are needed to parse a line, so that's all a chunk keeps of each one
+#define kBatchStoredLineLength (kMaxPuzzleLineLength + 1)
+//! Characters a chunk holds for its lines, enough for kBatchChunkLines 9x9 puzzles. Chunks of larger puzzles hold fewer lines
+#define kBatchChunkDataSize (kBatchChunkLines * (kPuzzleLineLength + 1))
+//! A solution is as long as its line plus a newline, the other results of a puzzle are no longer than that and "Invalid puzzle" is shorter than 16 characters
+#define kBatchChunkOutputSize (kBatchChunkDataSize + (kBatchChunkLines * 16))
+//! A boxed grid is at most 5 times as long as its line, and every result is followed by a blank line
+#define kBatchChunkBoxedOutputSize ((kBatchChunkDataSize * 5) + (kBatchChunkLines * 17))
+//! Chunks in flight for each worker, enough to keep them busy while the oldest chunk is written out
+#define kBatchChunksPerThread 4
+
+//! Totals for a finished batch run
+struct BatchResults
+{
+  uint64_t _puzzle_count = 0;
+  uint64_t _solved_count = 0;
+  //! Lines that weren't a valid puzzle
+  uint64_t _invalid_count = 0;
+  //! Blank lines and lines starting with '#', which get nothing written for them
+  uint64_t _skipped_count = 0;
+  //! Puzzles found to have more than one solution, or givens that repeat a value in a unit. Only counted when checking uniqueness
+  uint64_t _multiple_solution_count = 0;
+  uint64_t _invalid_givens_count = 0;
+  //! Puzzles looked up in the solution cache, and those answered from it without a search
+  uint64_t _cache_lookup_count = 0;
+  uint64_t _cache_hit_count = 0;
+  //! Puzzles that ran out of budget and were solved again by the fallback engine, and those left unsolved without one
+  uint64_t _fallback_count = 0;
+  uint64_t _budget_exceeded_count = 0;
+  double _elapsed_seconds = 0.0;
+  //! Everything the solvers did across the batch, the max depth is the deepest of any puzzle
+  SolverStats _stats;
+};
+
+//! Streams puzzles written one per line (81 characters, '.', '0' or '*' for empty slots) through the solvers, writing the solutions out one per line.
+//  4x4, 16x16 and 25x25 puzzles are read the same way, using 'A' onwards for the values past 9, and always go to the backtracking engine.
+//  Lines are grouped into chunks which are solved on a work stealing thread pool, every worker owning its own solver.
+//  Finished chunks wait in a ring until every chunk before them has been written, so the output stays in input order.
+class BatchRunner
+{
+public:
+  //! A thread_count of 1 solves everything on the calling thread
+  BatchRunner(const char* engine_name, int thread_count, bool pin_threads);
+  ~BatchRunner();
+
+  //! Run
+  //  Solves every puzzle read from input and writes the results to output in the same order, returns false if writing failed.
+  //  Puzzles without a solution are written as "No solution", and lines that aren't a puzzle as "Invalid puzzle". Blank lines and lines starting with '#' are skipped
+  //  without writing anything, and counted in the results so the output can be lined back up with the input.
+  bool Run(FILE* input, FILE* output);
+  //! Run
+  //  Solves every puzzle in the given bytes, usually a memory mapped file, the same way as reading them from a FILE.
+  //  The lines are parsed where they are. Each chunk is handed a range of whole lines, which the worker splits into lines itself, so nothing reads the input centrally.
+  //  Data starting with a binary puzzle file header is read as its records instead, each one solved like a line and unpacked straight from the data.
+  bool Run(const char* data, size_t size, FILE* output);
+
+  const BatchResults& GetResults() const { return _results; }
+  //! SetStatsOutput
+  //  Writes what the solver did for every line to stats_output during the next runs, in the same order as the solutions, followed by the totals.
+  //  Written as JSON, or CSV with a header row and the totals on the last row. nullptr stops writing them.
+  void SetStatsOutput(FILE* stats_output, bool is_csv);
+  //! SetOutputFormat
+  //  Picks how solutions are written, kGridFormatCompact (one line each, the default), kGridFormatBoxed (a blank line after each one) or kGridFormatNone to skip writing results at all.
+  void SetOutputFormat(int output_format);
+  //! SetCheckingUniqueness
+  //  Makes the next runs reject every puzzle that doesn't have exactly one solution. The search stops at the second solution, written as "Multiple solutions",
+  //  and puzzles whose givens repeat a value in a group, column or row are written as "Invalid givens" without being searched.
+  void SetCheckingUniqueness(bool is_checking_uniqueness);
+  //! SetSolutionCacheSize
+  //  Keeps the results of up to entry_count 9x9 puzzles by their canonical form, so puzzles equivalent to one already solved are answered without a search.
+  //  The cache lasts across runs, 0 drops it. The bit sliced engine solves puzzles in groups and doesn't use it.
+  void SetSolutionCacheSize(size_t entry_count);
+  //! SetSolveBudget
+  //  Limits the search of every puzzle to node_limit nodes and time_limit microseconds, 0 for no limit. A puzzle that runs out is written as "Budget exceeded",
+  //  unless there's a fallback engine. Then it's put aside, and once the rest of its chunk is done the chunk goes back on the worker's deque to solve it again with
+  //  the fallback engine and no budget, so the chunks already waiting don't wait on it. The bit sliced engine searches its lanes together and isn't limited.
+  void SetSolveBudget(uint64_t node_limit, uint64_t time_limit, const char* fallback_engine_name);
+
+private:
+  //! A puzzle put aside for the fallback engine, and where its result goes in the output
+  struct DeferredLine
+  {
+    int _line;
+    size_t _output_offset;
+  };
+
+  struct Chunk
+  {
+    Chunk();
+
+    //! Lines read from a FILE are packed one after another here, lines of mapped input are left where they are
+    char _line_data[kBatchChunkDataSize];
+    //! Where each line starts and the part of it that's kept, sized for kBatchChunkLines. A range of mapped input with more lines grows them
+    std::vector<const char*> _line_starts;
+    std::vector<uint16_t> _line_lengths;
+    int _line_count = 0;
+    size_t _line_data_size = 0;
+    //! Mapped input still to be split into lines by the worker, nullptr once it has been or for input read from a FILE
+    const char* _range_begin = nullptr;
+    const char* _range_end = nullptr;
+
+    //! Sized for the output format
+    std::vector<char> _output;
+    size_t _output_size = 0;
+    //! How each line turned out, and what its solver did
+    std::vector<uint8_t> _line_status;
+    std::vector<SolverStats> _line_stats;
+    BatchResults _results;
+    std::atomic<bool> _is_solved;
+    //! Puzzles that ran out of budget, solved once the rest of the chunk is
+    std::vector<DeferredLine> _deferred_lines;
+    //! Only grown for a chunk that put puzzles aside, their results are spliced into the output here
+    std::vector<char> _spliced_output;
+  };
+
+  //! Resets everything for a new run, and starts the stats output
+  void StartRun(FILE* output);
+  //! Hands off the last chunk, waits for everything to be written and finishes the stats output
+  bool FinishRun();
+  void AddLine(const char* line, size_t length);
+  //! Splits a chunk's range of mapped input into its lines
+  void SplitRange(Chunk& chunk);
+  //! Returns the size of the board on a line, or 0 if it isn't laid out like a puzzle. Every whole record of a binary puzzle file has the size in its header
+  int GetLineSize(const Chunk& chunk, int line) const;
+  //! Reads the puzzle on a line into values row by row, unpacking it for a binary puzzle file, returns false if it isn't a puzzle of that size
+  bool ParseLine(const Chunk& chunk, int line, int size, int* values) const;
+  //! Hands the current chunk off to be solved, and waits for a free one if every chunk is in flight
+  void SubmitChunk();
+  void SolveChunk(int worker_index, Chunk& chunk);
+  void SolveChunk(int worker_index, ISudokuSolver& solver, Chunk& chunk);
+  void SolveChunk(int worker_index, BitSlicedSolver& solver, Chunk& chunk);
+  //! Solves the puzzles put aside with the fallback engine, splicing their results into the output in line order
+  void SolveDeferredLines(int worker_index, Chunk& chunk);
+  //! Solves a puzzle that doesn't go through the engine, because it isn't 9x9
+  void SolveLine(int worker_index, Chunk& chunk, int line, int size);
+  void SolvePuzzle(int worker_index, ISudokuSolver& solver, Chunk& chunk, int line, const int* values);
+  //! Writes the result cached for the canonical puzzle, mapped back onto the puzzle, returns false if there isn't one that answers it
+  bool SolveFromCache(Chunk& chunk, int line, const CanonicalPuzzle& puzzle);
+  //! Counts the line towards the chunk's results, and keeps its stats for the stats output
+  void RecordLine(Chunk& chunk, int line, uint8_t status, const SolverStats& stats);
+  //! Returns the worker's solver for puzzles of the given size that aren't 9x9, creating it the first time it's needed
+  ISudokuSolver& GetSizedSolver(int worker_index, int size);
+  void WriteSolution(Chunk& chunk, const int* values, int size);
+  void WriteOutput(Chunk& chunk, const char* data, size_t length);
+  //! Writes finished chunks in order, waiting on unfinished ones until fewer than max_in_flight remain
+  void WriteSolvedChunks(uint64_t max_in_flight);
+  void WriteLineStats(const Chunk& chunk);
+
+  //! One solver for each worker
+  std::vector<std::unique_ptr<ISudokuSolver>> _solvers;
+  //! Used instead of _solvers by the bit sliced engine
+  std::vector<std::unique_ptr<BitSlicedSolver>> _bit_sliced_solvers;
+  //! Backtracking solvers for the other sizes of board, kMaxBoxSize - kMinBoxSize + 1 for each worker
+  std::vector<std::unique_ptr<ISudokuSolver>> _sized_solvers;
+  std::unique_ptr<Utility::WorkStealingThreadPool<Chunk>> _thread_pool;
+  //! Unlimited solvers of the fallback engine for each worker, empty without one
+  std::vector<std::unique_ptr<ISudokuSolver>> _fallback_solvers;
+  //! nullptr unless caching solutions, with a canonicalizer for each worker
+  std::unique_ptr<SolutionCache> _solution_cache;
+  std::vector<std::unique_ptr<PuzzleCanonicalizer>> _canonicalizers;
+
+  std::unique_ptr<Chunk[]> _chunks;
+  int _chunk_count = 0;
+  //! The chunk being filled, its sequence is _next_sequence
+  Chunk* _current_chunk = nullptr;
+  uint64_t _next_sequence = 0;
+  uint64_t _next_write_sequence = 0;
+
+  std::mutex _solved_mutex;
+  std::condition_variable _solved_condition;
+
+  BatchResults _results;
+  std::chrono::steady_clock::time_point _start_time;
+  std::vector<char> _input_buffer;
+  //! Set for the run when the mapped input is a binary puzzle file, whose lines are its records
+  bool _is_binary_input = false;
+  BinaryPuzzleHeader _binary_header;
+  FILE* _output = nullptr;
+  bool _output_failed = false;
+  int _output_format = kGridFormatCompact;
+  bool _is_checking_uniqueness = false;
+  //! Budget given to every solver, 0 for no limit
+  uint64_t _node_budget = 0;
+  uint64_t _time_budget = 0;
+  FILE* _stats_output = nullptr;
+  bool _is_stats_csv = false;
+  //! Lines written to the stats output so far in this run
+  uint64_t _stats_line_count = 0;
+};
+
+} // namespace Sudoku
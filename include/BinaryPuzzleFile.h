@@ -0,0 +1,75 @@
+#pragma once
+
+#include "ISudokuSolver.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+
+namespace Sudoku
+{
+
+// --- Constants
+//! First bytes of every binary puzzle file
+#define kBinaryPuzzleMagic "SDKB"
+#define kBinaryPuzzleVersion 1
+#define kBinaryPuzzleHeaderSize 16
+//! Header flag set when every record carries a solution after its puzzle
+#define kBinaryPuzzleHasSolutions 0x01
+
+//! The header at the start of a binary puzzle file, stored little endian:
+//  magic (4 bytes), version, board size, bits per slot, flags (1 byte each), record size (4 bytes) and 4 reserved bytes.
+//  Fixed size records follow it, so record n starts at kBinaryPuzzleHeaderSize + (n * record size).
+struct BinaryPuzzleHeader
+{
+  int _size = kSudokuSize;
+  //! 4 for boards up to 9x9, 5 for 16x16 and 25x25
+  int _bits_per_slot = 4;
+  bool _has_solutions = false;
+  //! Bytes in a record, the packed puzzle plus the packed solution when there is one
+  size_t _record_size = 0;
+};
+
+//! Totals for a conversion
+struct ConvertResults
+{
+  uint64_t _record_count = 0;
+  //! Lines that weren't a puzzle, or were a puzzle of another size than the first one
+  uint64_t _skipped_count = 0;
+  //! Bytes of a partly written last record of a binary puzzle file, which is left out and counted as skipped
+  uint64_t _truncated_size = 0;
+};
+
+//! Compact binary container for puzzles. Every slot is packed into a few bits, 0 for empty and the value otherwise, so a 9x9 puzzle takes 41 bytes instead of an 82 byte line.
+//  Records are fixed size for random access, and can carry the solution of their puzzle, all 0 when it has none.
+class BinaryPuzzleFile
+{
+public:
+  //! MakeHeader
+  //  Returns the header for records of the given size of board.
+  static BinaryPuzzleHeader MakeHeader(int size, bool has_solutions);
+  //! ReadHeader
+  //  Reads the header at the start of data, returns false if data isn't a binary puzzle file this version can read.
+  static bool ReadHeader(const char* data, size_t data_size, BinaryPuzzleHeader& header);
+  static void WriteHeader(const BinaryPuzzleHeader& header, uint8_t bytes[kBinaryPuzzleHeaderSize]);
+
+  //! GetPackedSize
+  //  Returns the bytes one packed board takes.
+  static size_t GetPackedSize(int size, int bits_per_slot);
+  //! PackValues
+  //  Packs size x size values given row by row, kEmptySlot for empty slots.
+  static void PackValues(const int* values, int size, int bits_per_slot, uint8_t* packed);
+  //! UnpackValues
+  //  Unpacks a board into values row by row, returns false if a slot holds a value too large for the board.
+  static bool UnpackValues(const uint8_t* packed, int size, int bits_per_slot, int* values);
+
+  //! ConvertTextToBinary
+  //  Packs every puzzle line of the text into records. The board size comes from the first puzzle, and records carry solutions when that line has one after the puzzle.
+  //  Returns false if there were no puzzles, or writing failed.
+  static bool ConvertTextToBinary(const char* data, size_t data_size, FILE* output, ConvertResults& results);
+  //! ConvertBinaryToText
+  //  Writes every record as a puzzle line, followed by a space and its solution when it has one. Returns false if data isn't a binary puzzle file, or writing failed.
+  static bool ConvertBinaryToText(const char* data, size_t data_size, FILE* output, ConvertResults& results);
+};
+
+} // namespace Sudoku
@@ -0,0 +1,52 @@
+#pragma once
+
+#include "CandidateBoard.h"
+#include "ISudokuSolver.h"
+#include "SudokuSolver.h"
+
+#include <cstdint>
+
+namespace Sudoku
+{
+
+// --- Constants
+//! Puzzles propagated together, one per SIMD lane
+#define kBitSlicedLanes kCandidateLanes
+
+//! Throughput engine for batches, it runs constraint propagation on kBitSlicedLanes independent puzzles at once, one puzzle per SIMD lane.
+//  Most puzzles are finished by propagation alone. The few that need guessing go on to a regular SudokuSolver, starting from everything propagation placed.
+class BitSlicedSolver
+{
+public:
+  BitSlicedSolver();
+
+  //! SolvePuzzles
+  //  Solves up to kBitSlicedLanes puzzles, writing each solution over its values.
+  //  Returns a mask with the bit of every puzzle that was solved.
+  uint32_t SolvePuzzles(int puzzle_count, int values[][kSudokuSize][kSudokuSize]);
+  //! SetCheckingUniqueness
+  //  Makes SolvePuzzles look for a second solution to every puzzle that needs guessing. Puzzles propagation finishes only ever have one.
+  void SetCheckingUniqueness(bool is_checking_uniqueness) { _is_checking_uniqueness = is_checking_uniqueness; }
+  //! GetMultipleSolutionPuzzles
+  //  Returns a mask with the bit of every puzzle the last SolvePuzzles found more than one solution to, always 0 unless checking uniqueness.
+  //  They're counted as solved, with the first solution found written over their values.
+  uint32_t GetMultipleSolutionPuzzles() const { return _multiple_solution_puzzles; }
+
+  //! Puzzles that propagation couldn't finish, and were handed to the backtracking solver
+  uint64_t GetFallbackCount() const { return _fallback_count; }
+  //! GetLaneStats
+  //  Returns what the backtracking solver did for the puzzle in the lane during the last SolvePuzzles.
+  //  The shared propagation isn't counted per puzzle, so puzzles it finished report nothing.
+  const SolverStats& GetLaneStats(int lane) const { return _lane_stats[lane]; }
+
+private:
+  LaneBoard _boards;
+  SudokuSolver _fallback_solver;
+  uint64_t _fallback_count = 0;
+  bool _is_checking_uniqueness = false;
+  uint32_t _multiple_solution_puzzles = 0;
+  SolverStats _lane_stats[kBitSlicedLanes];
+  const CandidateKernels* _kernels;
+};
+
+} // namespace Sudoku
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstdint>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace Utility
+{
+
+//! PopCount
+//  Returns the number of set bits in the given mask.
+inline int PopCount(uint32_t mask)
+{
+#if defined(_MSC_VER)
+  return static_cast<int>(__popcnt(mask));
+#else
+  return __builtin_popcount(mask);
+#endif
+}
+
+//! LowestBitIndex
+//  Returns the index of the lowest set bit in the given mask. The mask must not be 0.
+inline int LowestBitIndex(uint32_t mask)
+{
+#if defined(_MSC_VER)
+  unsigned long index;
+  _BitScanForward(&index, mask);
+  return static_cast<int>(index);
+#else
+  return __builtin_ctz(mask);
+#endif
+}
+
+} // namespace Utility
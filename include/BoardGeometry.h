@@ -0,0 +1,109 @@
+#pragma once
+
+#include <cstdint>
+#include <type_traits>
+
+namespace Sudoku
+{
+
+// --- Constants
+//! Smallest and largest group sizes a board can be built from, 4x4 up to 25x25 boards
+#define kMinBoxSize 2
+#define kMaxBoxSize 5
+//! Side length of the largest board
+#define kMaxSudokuSize (kMaxBoxSize * kMaxBoxSize)
+
+//! Everything about the layout of a board made of BoxSize x BoxSize groups, worked out at compile time.
+//  Slots are indexed row by row. Units are the rows, then the columns, then the groups.
+template<int BoxSize>
+struct BoardGeometry
+{
+  static_assert(BoxSize >= kMinBoxSize && BoxSize <= kMaxBoxSize, "Boards are supported from 4x4 up to 25x25");
+
+  static constexpr int kBoxSize = BoxSize;
+  static constexpr int kSize = BoxSize * BoxSize;
+  static constexpr int kSlots = kSize * kSize;
+  static constexpr int kUnits = kSize * 3;
+  //! Every other slot in the row and column, plus the rest of the group that isn't in either
+  static constexpr int kPeerCount = ((kSize - 1) * 2) + ((BoxSize - 1) * (BoxSize - 1));
+
+  //! Bit (n - 1) is set if n is still a possible value
+  typedef typename std::conditional<kSize <= 16, uint16_t, uint32_t>::type Mask;
+  //! Big enough to hold any slot index
+  typedef typename std::conditional<kSlots <= 256, uint8_t, uint16_t>::type Index;
+
+  static constexpr Mask kAllValues = static_cast<Mask>((1ull << kSize) - 1);
+
+  struct Tables
+  {
+    //! The slots of every unit
+    Index _unit_slots[kUnits][kSize];
+    //! The row, column and group unit of every slot
+    uint8_t _slot_units[kSlots][3];
+    //! The slots sharing a unit with every slot
+    Index _peers[kSlots][kPeerCount];
+  };
+
+  static constexpr int GroupOf(int row, int column)
+  {
+    return ((row / BoxSize) * BoxSize) + (column / BoxSize);
+  }
+
+  static constexpr Tables BuildTables()
+  {
+    Tables tables = {};
+    for(int unit = 0; unit < kSize; ++unit)
+    {
+      for(int i = 0; i < kSize; ++i)
+      {
+        tables._unit_slots[unit][i] = static_cast<Index>((unit * kSize) + i);
+        tables._unit_slots[kSize + unit][i] = static_cast<Index>((i * kSize) + unit);
+        int row = ((unit / BoxSize) * BoxSize) + (i / BoxSize);
+        int column = ((unit % BoxSize) * BoxSize) + (i % BoxSize);
+        tables._unit_slots[(kSize * 2) + unit][i] = static_cast<Index>((row * kSize) + column);
+      }
+    }
+
+    for(int slot = 0; slot < kSlots; ++slot)
+    {
+      int row = slot / kSize;
+      int column = slot % kSize;
+      tables._slot_units[slot][0] = static_cast<uint8_t>(row);
+      tables._slot_units[slot][1] = static_cast<uint8_t>(kSize + column);
+      tables._slot_units[slot][2] = static_cast<uint8_t>((kSize * 2) + GroupOf(row, column));
+
+      int peer_count = 0;
+      for(int i = 0; i < kSize; ++i)
+      {
+        if(i != column)
+        {
+          tables._peers[slot][peer_count++] = static_cast<Index>((row * kSize) + i);
+        }
+        if(i != row)
+        {
+          tables._peers[slot][peer_count++] = static_cast<Index>((i * kSize) + column);
+        }
+      }
+
+      // The row and column already covered part of the group
+      int first_row = (row / BoxSize) * BoxSize;
+      int first_column = (column / BoxSize) * BoxSize;
+      for(int group_row = first_row; group_row < first_row + BoxSize; ++group_row)
+      {
+        for(int group_column = first_column; group_column < first_column + BoxSize; ++group_column)
+        {
+          if(group_row != row && group_column != column)
+          {
+            tables._peers[slot][peer_count++] = static_cast<Index>((group_row * kSize) + group_column);
+          }
+        }
+      }
+    }
+
+    return tables;
+  }
+
+  static constexpr Tables kTables = BuildTables();
+};
+
+} // namespace Sudoku
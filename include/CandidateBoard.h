@@ -0,0 +1,91 @@
+#pragma once
+
+#include "ISudokuSolver.h"
+
+#include <cstdint>
+
+namespace Sudoku
+{
+
+// --- Constants
+//! Candidate mask with every value (1-9) still possible
+#define kAllPossibleValues 0x1FF
+//! Converts a value (1-9) into its bit in a candidate mask
+#define ValueToMask(value) static_cast<uint16_t>(1 << ((value) - 1))
+//! Candidate masks per board row, enough to fill a 256 bit register
+#define kCandidateLanes 16
+//! Lane a column's candidate mask is kept in, each 3x3 group gets its own 4 lane quad so groups never straddle a 128 bit half
+#define ColumnToLane(column) ((column) + ((column) / 3))
+//! Column a lane holds, only valid for lanes returned by ColumnToLane
+#define LaneToColumn(lane) ((lane) - ((lane) / 4))
+//! Groups, columns and rows on the board
+#define kSudokuUnits (kSudokuSize * 3)
+//! Names accepted by SelectCandidateKernels
+#define kScalarKernelsName "scalar"
+#define kSse41KernelsName "sse4.1"
+#define kAvx2KernelsName "avx2"
+
+//! The board as one 16 bit mask per slot, laid out so a whole row fits one AVX2 register.
+//  Bit (n - 1) of a mask stands for the value n, lanes that don't map to a column are always 0.
+struct alignas(32) CandidateBoard
+{
+  uint16_t _cells[kSudokuSize][kCandidateLanes];
+};
+
+//! kCandidateLanes separate boards side by side, one per lane, so several puzzles can be propagated at once.
+//  Slots are indexed row by row, and a placed slot holds just the mask of its value.
+struct alignas(32) LaneBoard
+{
+  uint16_t _cells[kSudokuSize * kSudokuSize][kCandidateLanes];
+};
+
+//! Bitmask of the values already placed in every group, column and row
+struct UnitValues
+{
+  uint16_t _groups[kSudokuSize];
+  uint16_t _columns[kSudokuSize];
+  uint16_t _rows[kSudokuSize];
+};
+
+//! Whole board propagation kernels, one set per instruction set
+struct CandidateKernels
+{
+  const char* _name;
+
+  //! ComputeCandidates
+  //  From a board holding the mask of each placed value (0 for empty slots), fills in the possible values of every empty slot (0 for placed ones) and the values used by each unit.
+  //  Returns false if a value was placed twice in a unit, or an empty slot has nothing left to hold.
+  bool (*ComputeCandidates)(const CandidateBoard& placed, CandidateBoard& candidates, UnitValues& unit_values);
+
+  //! FindSingles
+  //  Finds every naked single (a slot with one possible value) and hidden single (the only slot in a unit that can hold a value) on the board at once.
+  //  singles gets the mask of the value each slot is forced to, and single_lanes a bit for each lane of a row with a single in it.
+  //  Returns false if a unit has no slot left for one of its missing values, or one slot is the only home for two different values.
+  bool (*FindSingles)(const CandidateBoard& candidates, const UnitValues& unit_values, CandidateBoard& singles, uint16_t single_lanes[kSudokuSize]);
+
+  //! PropagateLanes
+  //  Removes placed values from their peers and places hidden singles on every board at once, until none of them change.
+  //  solved_lanes gets a bit for each board that ended up filled in, and invalid_lanes one for each board that can't be solved.
+  void (*PropagateLanes)(LaneBoard& boards, uint16_t& solved_lanes, uint16_t& invalid_lanes);
+
+  //! DecodePuzzleLine
+  //  Reads the 81 characters of a 9x9 puzzle into values row by row, '1'-'9' for values and '.', '0' or '*' for empty slots (kEmptySlot).
+  //  Nothing past the 81st character is read. Returns false if any other character is found.
+  bool (*DecodePuzzleLine)(const char* line, int values[kSudokuSize * kSudokuSize]);
+};
+
+//! GetCandidateKernels
+//  Returns the kernels in use, by default the fastest ones this CPU supports.
+const CandidateKernels& GetCandidateKernels();
+
+//! SelectCandidateKernels
+//  Switches to the kernels with the given name, returns false if they're unknown or this CPU can't run them.
+//  Solvers pick up the kernels when they're created, so this should be called before creating any.
+bool SelectCandidateKernels(const char* name);
+
+//! Kernels for each instruction set, SSE4.1 and AVX2 are nullptr when they weren't compiled in
+const CandidateKernels& GetScalarCandidateKernels();
+const CandidateKernels* GetSse41CandidateKernels();
+const CandidateKernels* GetAvx2CandidateKernels();
+
+} // namespace Sudoku
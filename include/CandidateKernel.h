@@ -0,0 +1,305 @@
+#pragma once
+
+#include "CandidateBoard.h"
+
+#include <cstdint>
+
+namespace Sudoku
+{
+
+//! The propagation kernels are written once against a small vector interface, each instruction set supplies a Vector type with:
+//  Type, Load, Store, Zero, Set1, SetColumns, SetGroups, Or, And, AndNot, Sub1, CmpEq, IsZero, AllEqual, NonZeroLanes, FirstLane,
+//  RotateQuads1, RotateQuads2, SwapHalves64 and SwapHalves128.
+//  Units are reduced with a pair of masks, the values seen once or more and the values seen twice or more, so the values seen exactly once fall out as once & ~twice.
+//  Only include this from a file compiled for the Vector's instruction set.
+
+//! CompressLaneMask
+//  Turns a byte mask (2 bits for every 16 bit lane) into a mask with one bit per lane.
+template<typename Vector>
+inline uint16_t CompressLaneMask(uint32_t byte_mask)
+{
+  byte_mask &= 0x55555555;
+  byte_mask = (byte_mask | (byte_mask >> 1)) & 0x33333333;
+  byte_mask = (byte_mask | (byte_mask >> 2)) & 0x0F0F0F0F;
+  byte_mask = (byte_mask | (byte_mask >> 4)) & 0x00FF00FF;
+  byte_mask = (byte_mask | (byte_mask >> 8)) & 0x0000FFFF;
+  return static_cast<uint16_t>(byte_mask);
+}
+
+//! AccumulateCounts
+//  Adds one more slot's mask to the once/twice pair.
+template<typename Vector>
+inline void AccumulateCounts(typename Vector::Type& once, typename Vector::Type& twice, typename Vector::Type values)
+{
+  twice = Vector::Or(twice, Vector::And(once, values));
+  once = Vector::Or(once, values);
+}
+
+//! CombineCounts
+//  Merges the once/twice pair of a disjoint set of slots into this one.
+template<typename Vector>
+inline void CombineCounts(typename Vector::Type& once, typename Vector::Type& twice, typename Vector::Type other_once, typename Vector::Type other_twice)
+{
+  twice = Vector::Or(Vector::Or(twice, other_twice), Vector::And(once, other_once));
+  once = Vector::Or(once, other_once);
+}
+
+//! ReduceQuads
+//  Every lane ends up with the counts of its whole 4 lane quad, which is a 3 slot slice of a group.
+template<typename Vector>
+inline void ReduceQuads(typename Vector::Type& once, typename Vector::Type& twice)
+{
+  CombineCounts<Vector>(once, twice, Vector::RotateQuads1(once), Vector::RotateQuads1(twice));
+  CombineCounts<Vector>(once, twice, Vector::RotateQuads2(once), Vector::RotateQuads2(twice));
+}
+
+//! ReduceRow
+//  Every lane ends up with the counts of the whole row.
+template<typename Vector>
+inline void ReduceRow(typename Vector::Type& once, typename Vector::Type& twice)
+{
+  ReduceQuads<Vector>(once, twice);
+  CombineCounts<Vector>(once, twice, Vector::SwapHalves64(once), Vector::SwapHalves64(twice));
+  CombineCounts<Vector>(once, twice, Vector::SwapHalves128(once), Vector::SwapHalves128(twice));
+}
+
+template<typename Vector>
+bool ComputeCandidatesKernel(const CandidateBoard& placed, CandidateBoard& candidates, UnitValues& unit_values)
+{
+  typedef typename Vector::Type Type;
+
+  const Type zero = Vector::Zero();
+  const Type all_values = Vector::Set1(kAllPossibleValues);
+  // Lanes that map to a column are 0 here, and everything else 1
+  static const uint16_t kNoValues[kSudokuSize] = { 0 };
+  const Type column_lanes = Vector::CmpEq(Vector::SetColumns(kNoValues, 1), zero);
+  alignas(32) uint16_t lanes[kCandidateLanes];
+
+  Type rows[kSudokuSize];
+  for(int row = 0; row < kSudokuSize; ++row)
+  {
+    rows[row] = Vector::Load(placed._cells[row]);
+  }
+
+  // Anything seen twice in a unit was placed more than once
+  Type duplicates = zero;
+
+  Type column_values = zero;
+  Type twice = zero;
+  for(int row = 0; row < kSudokuSize; ++row)
+  {
+    AccumulateCounts<Vector>(column_values, twice, rows[row]);
+  }
+  duplicates = Vector::Or(duplicates, twice);
+  Vector::Store(lanes, column_values);
+  for(int col = 0; col < kSudokuSize; ++col)
+  {
+    unit_values._columns[col] = lanes[ColumnToLane(col)];
+  }
+
+  Type group_values[kSudokuSize / 3];
+  for(int band = 0; band < kSudokuSize / 3; ++band)
+  {
+    group_values[band] = zero;
+    twice = zero;
+    for(int row = band * 3; row < (band + 1) * 3; ++row)
+    {
+      AccumulateCounts<Vector>(group_values[band], twice, rows[row]);
+    }
+    ReduceQuads<Vector>(group_values[band], twice);
+    duplicates = Vector::Or(duplicates, twice);
+
+    Vector::Store(lanes, group_values[band]);
+    for(int stack = 0; stack < kSudokuSize / 3; ++stack)
+    {
+      unit_values._groups[band * 3 + stack] = lanes[stack * 4];
+    }
+  }
+
+  Type empty_without_candidates = zero;
+  for(int row = 0; row < kSudokuSize; ++row)
+  {
+    Type row_values = rows[row];
+    twice = zero;
+    ReduceRow<Vector>(row_values, twice);
+    duplicates = Vector::Or(duplicates, twice);
+    unit_values._rows[row] = Vector::FirstLane(row_values);
+
+    // Anything not used by the slot's group, column or row is still possible
+    Type used_values = Vector::Or(row_values, Vector::Or(column_values, group_values[row / 3]));
+    Type empty_slots = Vector::And(Vector::CmpEq(rows[row], zero), column_lanes);
+    Type possible_values = Vector::And(Vector::AndNot(used_values, all_values), empty_slots);
+    Vector::Store(candidates._cells[row], possible_values);
+
+    empty_without_candidates = Vector::Or(empty_without_candidates, Vector::And(empty_slots, Vector::CmpEq(possible_values, zero)));
+  }
+
+  return Vector::IsZero(duplicates) == true && Vector::IsZero(empty_without_candidates) == true;
+}
+
+template<typename Vector>
+bool FindSinglesKernel(const CandidateBoard& candidates, const UnitValues& unit_values, CandidateBoard& singles, uint16_t single_lanes[kSudokuSize])
+{
+  typedef typename Vector::Type Type;
+
+  const Type zero = Vector::Zero();
+  const Type all_values = Vector::Set1(kAllPossibleValues);
+
+  Type rows[kSudokuSize];
+  for(int row = 0; row < kSudokuSize; ++row)
+  {
+    rows[row] = Vector::Load(candidates._cells[row]);
+  }
+
+  // Every value a unit is missing needs at least one slot that can still hold it, the lanes outside the board are filled in so they always pass
+  Type once = zero;
+  Type twice = zero;
+  for(int row = 0; row < kSudokuSize; ++row)
+  {
+    AccumulateCounts<Vector>(once, twice, rows[row]);
+  }
+  if(Vector::AllEqual(Vector::Or(once, Vector::SetColumns(unit_values._columns, kAllPossibleValues)), all_values) == false)
+  {
+    return false;
+  }
+  Type column_unique = Vector::AndNot(twice, once);
+
+  Type group_unique[kSudokuSize / 3];
+  for(int band = 0; band < kSudokuSize / 3; ++band)
+  {
+    once = zero;
+    twice = zero;
+    for(int row = band * 3; row < (band + 1) * 3; ++row)
+    {
+      AccumulateCounts<Vector>(once, twice, rows[row]);
+    }
+    ReduceQuads<Vector>(once, twice);
+
+    const uint16_t* group_values = &unit_values._groups[band * 3];
+    if(Vector::AllEqual(Vector::Or(once, Vector::SetGroups(group_values[0], group_values[1], group_values[2], kAllPossibleValues)), all_values) == false)
+    {
+      return false;
+    }
+    group_unique[band] = Vector::AndNot(twice, once);
+  }
+
+  for(int row = 0; row < kSudokuSize; ++row)
+  {
+    once = rows[row];
+    twice = zero;
+    ReduceRow<Vector>(once, twice);
+    if(Vector::AllEqual(Vector::Or(once, Vector::Set1(unit_values._rows[row])), all_values) == false)
+    {
+      return false;
+    }
+
+    // A slot can't be the only home for two different values
+    Type hidden = Vector::And(rows[row], Vector::Or(Vector::AndNot(twice, once), Vector::Or(column_unique, group_unique[row / 3])));
+    if(Vector::IsZero(Vector::And(hidden, Vector::Sub1(hidden))) == false)
+    {
+      return false;
+    }
+
+    Type naked = Vector::AndNot(Vector::CmpEq(rows[row], zero), Vector::CmpEq(Vector::And(rows[row], Vector::Sub1(rows[row])), zero));
+    Type forced = Vector::Or(hidden, Vector::And(rows[row], naked));
+    Vector::Store(singles._cells[row], forced);
+    single_lanes[row] = Vector::NonZeroLanes(forced);
+  }
+
+  return true;
+}
+
+template<typename Vector>
+void PropagateLanesKernel(LaneBoard& boards, uint16_t& solved_lanes, uint16_t& invalid_lanes)
+{
+  typedef typename Vector::Type Type;
+
+  const Type zero = Vector::Zero();
+  const Type all_bits = Vector::Set1(0xFFFF);
+  const Type all_values = Vector::Set1(kAllPossibleValues);
+
+  // Every lane is its own board here, so units are reduced slot by slot instead of across lanes
+  Type singles[kSudokuSize * kSudokuSize];
+  Type solved_once[kSudokuUnits];
+  Type solved_twice[kSudokuUnits];
+  Type possible_once[kSudokuUnits];
+  Type possible_twice[kSudokuUnits];
+  // All bits set in the lanes of boards found to break the rules, once broken they stay broken
+  Type invalid = zero;
+
+  bool is_changed = true;
+  while(is_changed == true)
+  {
+    for(int unit = 0; unit < kSudokuUnits; ++unit)
+    {
+      solved_once[unit] = zero;
+      solved_twice[unit] = zero;
+      possible_once[unit] = zero;
+      possible_twice[unit] = zero;
+    }
+
+    for(int slot = 0; slot < kSudokuSize * kSudokuSize; ++slot)
+    {
+      Type values = Vector::Load(boards._cells[slot]);
+      Type is_single = Vector::AndNot(Vector::CmpEq(values, zero), Vector::CmpEq(Vector::And(values, Vector::Sub1(values)), zero));
+      singles[slot] = Vector::And(values, is_single);
+      invalid = Vector::Or(invalid, Vector::CmpEq(values, zero));
+
+      int row = slot / kSudokuSize;
+      int col = slot % kSudokuSize;
+      const int units[3] = { row, kSudokuSize + col, (kSudokuSize * 2) + ((row / 3) * 3) + (col / 3) };
+      for(int unit : units)
+      {
+        AccumulateCounts<Vector>(solved_once[unit], solved_twice[unit], singles[slot]);
+        AccumulateCounts<Vector>(possible_once[unit], possible_twice[unit], values);
+      }
+    }
+
+    for(int unit = 0; unit < kSudokuUnits; ++unit)
+    {
+      // A value placed twice, or a value with nowhere left to go
+      invalid = Vector::Or(invalid, Vector::AndNot(Vector::CmpEq(solved_twice[unit], zero), all_bits));
+      invalid = Vector::Or(invalid, Vector::AndNot(Vector::CmpEq(possible_once[unit], all_values), all_bits));
+      // From here on possible_once holds the values only one slot of the unit can hold
+      possible_once[unit] = Vector::AndNot(possible_twice[unit], possible_once[unit]);
+    }
+
+    Type removed = zero;
+    for(int slot = 0; slot < kSudokuSize * kSudokuSize; ++slot)
+    {
+      int row = slot / kSudokuSize;
+      int col = slot % kSudokuSize;
+      int group = (kSudokuSize * 2) + ((row / 3) * 3) + (col / 3);
+      col += kSudokuSize;
+
+      Type values = Vector::Load(boards._cells[slot]);
+      Type remaining = Vector::AndNot(Vector::Or(solved_once[row], Vector::Or(solved_once[col], solved_once[group])), values);
+      Type hidden = Vector::And(remaining, Vector::Or(possible_once[row], Vector::Or(possible_once[col], possible_once[group])));
+      // A slot can't be the only home for two different values
+      invalid = Vector::Or(invalid, Vector::AndNot(Vector::CmpEq(Vector::And(hidden, Vector::Sub1(hidden)), zero), all_bits));
+
+      Type has_hidden = Vector::AndNot(Vector::CmpEq(hidden, zero), all_bits);
+      remaining = Vector::Or(Vector::And(has_hidden, hidden), Vector::AndNot(has_hidden, remaining));
+
+      // Placed slots keep their value
+      Type is_unsolved = Vector::CmpEq(singles[slot], zero);
+      Type updated = Vector::Or(Vector::And(is_unsolved, remaining), Vector::AndNot(is_unsolved, values));
+      removed = Vector::Or(removed, Vector::AndNot(updated, values));
+      Vector::Store(boards._cells[slot], updated);
+    }
+
+    is_changed = Vector::IsZero(removed) == false;
+  }
+
+  // The last pass didn't change anything, so its checks hold for the final boards
+  Type unsolved = zero;
+  for(int slot = 0; slot < kSudokuSize * kSudokuSize; ++slot)
+  {
+    unsolved = Vector::Or(unsolved, Vector::CmpEq(singles[slot], zero));
+  }
+
+  invalid_lanes = Vector::NonZeroLanes(invalid);
+  solved_lanes = static_cast<uint16_t>(~(Vector::NonZeroLanes(unsolved) | invalid_lanes));
+}
+
+} // namespace Sudoku
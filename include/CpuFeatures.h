@@ -0,0 +1,14 @@
+#pragma once
+
+namespace Utility
+{
+
+//! HasSse41
+//  Returns true if the CPU supports SSE4.1.
+bool HasSse41();
+
+//! HasAvx2
+//  Returns true if the CPU and the operating system both support AVX2.
+bool HasAvx2();
+
+} // namespace Utility
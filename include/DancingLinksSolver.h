@@ -0,0 +1,76 @@
+#pragma once
+
+#include "ISudokuSolver.h"
+
+namespace Sudoku
+{
+
+// --- Constants
+//! One column for each slot, and one for each value in every row, column and 3x3 group
+#define kExactCoverColumns (4 * kSudokuSize * kSudokuSize)
+//! One row for every value each slot could hold
+#define kExactCoverRows (kSudokuSize * kSudokuSize * kSudokuSize)
+//! Every row covers exactly 4 columns
+#define kExactCoverNodesPerRow 4
+//! The column headers, followed by the root, followed by the nodes of every row
+#define kExactCoverNodes (kExactCoverColumns + 1 + kExactCoverRows * kExactCoverNodesPerRow)
+
+//! Solves puzzles as an exact cover problem using Knuth's Algorithm X with Dancing Links
+class DancingLinksSolver : public ISudokuSolver
+{
+public:
+  DancingLinksSolver();
+  ~DancingLinksSolver() {};
+
+  int GetValue(int row, int column) const override { return _values[row][column]; }
+
+  void LoadPuzzle(const int values[kSudokuSize][kSudokuSize]) override;
+  bool SolvePuzzle() override;
+  uint64_t CountSolutions(uint64_t solution_limit) override;
+
+private:
+  //! A node in the sparse exact cover matrix, links are indices into _nodes
+  struct Node
+  {
+    int _left;
+    int _right;
+    int _up;
+    int _down;
+    int _column;
+    //! The exact cover row this node belongs to, (slot index * kSudokuSize) + (value - 1)
+    int _row;
+  };
+
+  //! Links every node of the exact cover matrix, only needs to happen once
+  void BuildMatrix();
+  void CoverColumn(int column);
+  void UncoverColumn(int column);
+  //! Covers every column of the given row, returns false if one of them was already covered
+  bool SelectRow(int row);
+  void DeselectRow(int row);
+  //! Returns true once the search should stop
+  bool Search();
+
+  //! Every node of the matrix, preallocated so solving never allocates
+  Node _nodes[kExactCoverNodes];
+  //! The number of nodes currently linked into each column
+  int _column_sizes[kExactCoverColumns];
+  //! Whether each column has been covered
+  bool _column_covered[kExactCoverColumns];
+  //! The first node of each exact cover row
+  int _row_nodes[kExactCoverRows];
+
+  //! The rows selected by the search so far
+  int _solution_rows[kSudokuSize * kSudokuSize];
+  int _solution_depth = 0;
+  //! Rows selected from columns that had more than one row left
+  int _search_depth = 0;
+  //! Stop searching after finding this many solutions, 0 to find all of them
+  uint64_t _solution_limit = 1;
+  uint64_t _solution_count = 0;
+
+  //! The puzzle values, filled in with the solution once one is found
+  int _values[kSudokuSize][kSudokuSize];
+};
+
+} // namespace Sudoku
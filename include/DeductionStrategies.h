@@ -0,0 +1,46 @@
+#pragma once
+
+#include "ISudokuSolver.h"
+
+#include <cstdint>
+
+namespace Sudoku
+{
+
+// --- Constants
+//! Bits of the deduction strategies, in the order the pipeline runs them, cheapest first
+#define kStrategyPointing (1u << 0)
+#define kStrategyBoxLine (1u << 1)
+#define kStrategyNakedPairs (1u << 2)
+#define kStrategyHiddenPairs (1u << 3)
+#define kStrategyNakedTriples (1u << 4)
+#define kStrategyHiddenTriples (1u << 5)
+#define kStrategyXWing (1u << 6)
+#define kStrategySwordfish (1u << 7)
+#define kAllDeductionStrategies ((1u << kDeductionStrategyCount) - 1)
+
+//! One step of the deduction pipeline. It only ever takes possible values away, so the solver can record them for backtracking like any other change
+struct DeductionStrategy
+{
+  const char* _name;
+
+  //! Apply
+  //  From the possible values of every slot row by row (0 for placed slots), sets the bits of values that can be taken away from each slot in removed.
+  //  Returns true if it found any. removed has to start out as all 0.
+  bool (*Apply)(const uint16_t candidates[kSudokuSize * kSudokuSize], uint16_t removed[kSudokuSize * kSudokuSize]);
+};
+
+//! GetDeductionStrategy
+//  Returns the strategy with the given index, its bit is 1 << index.
+const DeductionStrategy& GetDeductionStrategy(int index);
+
+//! GetDeductionStrategies
+//  Returns the bits of the strategies in use, none by default so the solver only places singles before guessing.
+uint32_t GetDeductionStrategies();
+
+//! SelectDeductionStrategies
+//  Picks the strategies by name, "all", "none" or a comma separated list of names. Returns false if a name is unknown.
+//  Solvers pick up the strategies when they're created, so this should be called before creating any.
+bool SelectDeductionStrategies(const char* names);
+
+} // namespace Sudoku
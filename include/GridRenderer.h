@@ -0,0 +1,40 @@
+#pragma once
+
+#include "ISudokuSolver.h"
+
+#include <cstddef>
+
+namespace Sudoku
+{
+
+// --- Constants
+//! Ways a grid can be written out
+#define kGridFormatCompact 0
+#define kGridFormatBoxed 1
+//! Nothing is rendered at all
+#define kGridFormatNone 2
+
+// --- Macros
+//! Characters in a boxed grid, every row and box separator is 3 characters a slot plus 3 for each box boundary and a newline
+#define BoxedGridLength(size, box_size) (((size) + (box_size) - 1) * ((3 * (size)) + (3 * ((box_size) - 1)) + 1))
+#define kMaxBoxedGridLength BoxedGridLength(kMaxSudokuSize, kMaxBoxSize)
+//! Characters in a compact grid, every value on a single line
+#define CompactGridLength(size) (((size) * (size)) + 1)
+
+//! Formats whole grids into a caller's buffer, so they can be written out with a single call instead of one for every slot
+class GridRenderer
+{
+public:
+  //! RenderBoxed
+  //  Writes the size x size values, given row by row, as rows of "[v]" slots split into boxes, "[ ]" for an empty slot. Returns the characters written.
+  //  The buffer needs room for BoxedGridLength characters.
+  static size_t RenderBoxed(const int* values, int size, char* buffer);
+  //! RenderCompact
+  //  Writes the values on a single line followed by a newline, '.' for an empty slot. Returns the characters written.
+  static size_t RenderCompact(const int* values, int size, char* buffer);
+  //! Render
+  //  Writes the values in the given format, returns the characters written.
+  static size_t Render(int format, const int* values, int size, char* buffer);
+};
+
+} // namespace Sudoku
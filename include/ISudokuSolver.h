@@ -0,0 +1,173 @@
+#pragma once
+
+#include "BoardGeometry.h"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace Sudoku
+{
+
+// --- Constants
+#define kSudokuSize 9
+#define kEmptySlot -1
+//! Converts a value to the character it's written as, '1'-'9' and then 'A' onwards for the values of larger boards
+#define ValueToChar(value) static_cast<char>((value) <= 9 ? '0' + (value) : 'A' + ((value) - 10))
+
+//! Names accepted by CreateSolver
+#define kBacktrackingEngineName "backtracking"
+#define kDancingLinksEngineName "dlx"
+#define kParallelEngineName "parallel"
+//! Batch engine that propagates many puzzles at once, see BitSlicedSolver. A single puzzle is solved by the backtracking engine
+#define kBitSlicedEngineName "bitsliced"
+//! Strategies of the deduction pipeline, see DeductionStrategies.h
+#define kDeductionStrategyCount 8
+
+//! How a solve turned out, see ISudokuSolver::SolveWithStatus
+#define kSolveSolved 0
+#define kSolveUnsolvable 1
+//! Only found when checking uniqueness
+#define kSolveMultipleSolutions 2
+//! The search ran out of nodes or time before it could tell
+#define kSolveBudgetExceeded 3
+//! Search nodes between reads of the clock while a solve has a time limit
+#define kBudgetCheckNodes 64
+
+//! What the last solve did. Every engine counts nodes and backtracks, the other counters are filled in by the engines that take those steps
+struct SolverStats
+{
+  //! Search nodes visited
+  uint64_t _nodes = 0;
+  //! Values tried in a slot that had more than one possible value
+  uint64_t _guesses = 0;
+  //! Guesses that had to be undone
+  uint64_t _backtracks = 0;
+  //! Most guesses in effect at once
+  uint64_t _max_depth = 0;
+  //! Passes of constraint propagation over the board
+  uint64_t _propagation_rounds = 0;
+  //! Slots solved because they only had one possible value left
+  uint64_t _naked_singles = 0;
+  //! Slots solved because a value had nowhere else to go in their group, column or row
+  uint64_t _hidden_singles = 0;
+  //! Possible values taken away from slots by the values placed around them
+  uint64_t _eliminations = 0;
+  //! Possible values taken away by each deduction strategy, indexed like GetDeductionStrategy
+  uint64_t _strategy_eliminations[kDeductionStrategyCount] = {};
+
+  //! Adds the counters of another solve, keeping the deeper of the two max depths
+  void Add(const SolverStats& other);
+  //! Takes away the counters of an earlier point of the same solve, leaving what was counted since. The max depth is kept
+  void Subtract(const SolverStats& earlier);
+};
+
+//! Common interface for the solving engines, so the one being used can be picked at runtime
+class ISudokuSolver
+{
+public:
+  virtual ~ISudokuSolver() {};
+
+  //! LoadFromFile
+  //  Reads a puzzle laid out as GetSize() lines of GetSize() characters, anything that isn't a value on this size of board is treated as an empty slot.
+  //  A binary puzzle file is read too, loading its first record. Returns false if the file couldn't be read, its records are for another size of board, or the givens repeat a value in a group, column or row.
+  bool LoadFromFile(const char* file_path);
+  //! Solve
+  //  Solves the loaded puzzle and displays the result, returns how it turned out the same as SolveWithStatus.
+  int Solve(bool is_checking_uniqueness = false);
+  //! SolveWithStatus
+  //  Solves the loaded puzzle without displaying anything, returns kSolveSolved, kSolveUnsolvable, kSolveMultipleSolutions or kSolveBudgetExceeded.
+  //  When checking uniqueness the search goes on to look for a second solution, and a puzzle that has one isn't solved.
+  int SolveWithStatus(bool is_checking_uniqueness);
+
+  //! Load
+  //  Loads a puzzle written as GetSize() x GetSize() characters row by row, the same as a batch line. Nothing is displayed and nothing is allocated.
+  //  Returns false if a character isn't a value or an empty slot, or the givens repeat a value in a group, column or row.
+  bool Load(const char* grid);
+  //! Reset
+  //  Empties the board and clears the counters, keeping every buffer the solver has grown so the next puzzle doesn't allocate.
+  virtual void Reset();
+
+  //! LoadPuzzle
+  //  Loads the starting values of the puzzle, kEmptySlot for any slot that needs solving. Nothing is displayed, so this is safe to call for every puzzle of a batch.
+  virtual void LoadPuzzle(const int values[kSudokuSize][kSudokuSize]) = 0;
+  //! LoadPuzzleValues
+  //  Loads GetSize() x GetSize() starting values given row by row, for solvers that take more than one size of board.
+  virtual void LoadPuzzleValues(const int* values);
+  //! SolvePuzzle
+  //  Solves the loaded puzzle without displaying anything, returns false if it has no solution.
+  virtual bool SolvePuzzle() = 0;
+  //! CountSolutions
+  //  Searches the loaded puzzle for up to solution_limit solutions (0 for no limit) and returns how many were found. The first one found is left in the puzzle.
+  //  A search that runs out of budget stops with what it found so far.
+  virtual uint64_t CountSolutions(uint64_t solution_limit) = 0;
+
+  //! SetBudget
+  //  Limits every solve from now on to node_limit search nodes and time_limit microseconds, 0 for no limit. Both are checked as the search goes,
+  //  the node count on every node and the clock every kBudgetCheckNodes nodes, so a search that runs out stops within a few microseconds.
+  virtual void SetBudget(uint64_t node_limit, uint64_t time_limit);
+  //! IsBudgetExceeded
+  //  Returns true if the last solve ran out of budget, so it may have stopped before finding every solution it was asked for.
+  bool IsBudgetExceeded() const { return _is_budget_exceeded; }
+
+  //! GetValue
+  //  Returns the value of the given slot, or kEmptySlot if it hasn't been solved.
+  virtual int GetValue(int row, int column) const = 0;
+  //! GetSize
+  //  Returns the number of rows, and columns, of the puzzles this solver takes.
+  virtual int GetSize() const { return kSudokuSize; }
+
+  uint64_t GetNodeCount() const { return _stats._nodes; }
+  uint64_t GetBacktrackCount() const { return _stats._backtracks; }
+  //! GetStats
+  //  Returns the counters of the last solve.
+  const SolverStats& GetStats() const { return _stats; }
+
+protected:
+  void DisplayPuzzle() const;
+  //! StartBudget
+  //  Starts the budget of a solve, once the node count has been cleared.
+  void StartBudget();
+  //! IsOverBudget
+  //  Called for every search node, returns true once the solve has run out of budget. Without one set it's a single compare.
+  bool IsOverBudget() { return _stats._nodes >= _next_budget_check && CheckBudget() == true; }
+
+  SolverStats _stats;
+  uint64_t _node_limit = 0;
+  uint64_t _time_limit = 0;
+  bool _is_budget_exceeded = false;
+
+private:
+  //! Checks the node limit and the clock, and works out when they need checking next
+  bool CheckBudget();
+
+  std::chrono::steady_clock::time_point _deadline;
+  //! Node count the budget is checked at next
+  uint64_t _next_budget_check = UINT64_MAX;
+};
+
+//! CreateSolver
+//  Creates the solving engine with the given name for boards of the given size, returns nullptr if the name isn't recognized.
+//  Only the backtracking engine handles sizes other than 9x9 (4x4, 16x16 and 25x25).
+//  When solver_count solvers are made to run at once, like one per batch thread, the parallel engine's share of the hardware threads is split between them.
+std::unique_ptr<ISudokuSolver> CreateSolver(const char* engine_name, int size = kSudokuSize, int solver_count = 1);
+
+//! CharToValue
+//  Returns the value a character stands for on a board of the given size, kEmptySlot for '.', '0' or '*', or 0 if it isn't either.
+int CharToValue(char c, int size);
+
+//! GetPuzzleLineSize
+//  Returns the size of the board written on the line, from how many characters the puzzle takes up, or 0 if it isn't laid out like a puzzle.
+int GetPuzzleLineSize(const char* line, size_t length);
+
+//! ParsePuzzleLine
+//  Reads the first size x size characters of a line into values row by row, returns false if the line isn't a puzzle of that size.
+bool ParsePuzzleLine(const char* line, int size, int* values);
+
+//! HasValidGivens
+//  Returns false if a value is given twice in a group, column or row of the size x size values, given row by row with kEmptySlot for empty slots.
+//  Puzzles like that can't be solved, and this spots them in a single pass before any solving.
+bool HasValidGivens(const int* values, int size);
+
+} // namespace Sudoku
@@ -1,9 +1,29 @@
 #pragma once
 #include "pch.h"
 
+#include <atomic>
+#include <cstddef>
+
 namespace Sudoku
 {
 
+// --- Constants
+//! Log levels, a message is written when its level is at or below the current one
+#define kLogLevelError 0
+#define kLogLevelInfo 1
+#define kLogLevelDebug 2
+#define kLogLevelTrace 3
+
+// --- Macros
+//! The arguments are only evaluated when the level is enabled, so a disabled message costs a single branch
+#define LogAtLevel(level, ...) do { if(Sudoku::Logger::IsEnabled(level) == true) { Sudoku::Logger::WriteLine(__VA_ARGS__); } } while(false)
+//! What the solver sets up before searching
+#define LogDebugLine(...) LogAtLevel(kLogLevelDebug, __VA_ARGS__)
+//! Every step the solver takes, a lot of output
+#define LogTraceLine(...) LogAtLevel(kLogLevelTrace, __VA_ARGS__)
+
+//! Messages are formatted on the calling thread into a lock free ring, and a background thread writes them out in order.
+//  The writer starts with the first message, and at exit it's drained and stopped so nothing is lost. Anything logged after that is written straight away.
 class Logger
 {
 public:
@@ -13,6 +33,13 @@ public:
   //! WriteLine
   //  Formates the given message with the provided arguments, along with a newline at the end and then writes it to the console.
   static void WriteLine(const char* format, ...);
+  //! WriteText
+  //  Writes the given characters to the console as they are, with a single write however long they are.
+  static void WriteText(const char* text, size_t length);
+  //! WriteErrorLine
+  //  Formats the given message with the provided arguments, along with a newline at the end and then writes it to the error stream, keeping it out of any output piped from the console.
+  //  Errors are always written, and are flushed before returning.
+  static void WriteErrorLine(const char* format, ...);
 
   //! NewLine
   //  Writes a line break to the console.
@@ -20,6 +47,21 @@ public:
   //! NewLine
   //  Writes the given amount of line breaks to the console.
   static void NewLine(int count);
+
+  //! Flush
+  //  Waits until everything logged so far has been written out.
+  static void Flush();
+
+  //! SetLevel
+  //  Picks the most detailed level written, kLogLevelInfo by default. Console output is info, so kLogLevelError keeps only the errors.
+  static void SetLevel(int level) { _level.store(level, std::memory_order_relaxed); }
+  //! SetLevel
+  //  Picks the level by its name, "error", "info", "debug" or "trace". Returns false if the name isn't one of them.
+  static bool SetLevel(const char* level_name);
+  static bool IsEnabled(int level) { return level <= _level.load(std::memory_order_relaxed); }
+
+private:
+  static std::atomic<int> _level;
 };
 
 } // namespace Sudoku
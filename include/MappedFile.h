@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstddef>
+
+namespace Utility
+{
+
+//! A read only view of a whole file mapped into memory, so it can be parsed in place without reading it into buffers.
+//  Uses mmap on POSIX systems and a file mapping object on Windows.
+class MappedFile
+{
+public:
+  MappedFile() = default;
+  ~MappedFile();
+
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+
+  //! Open
+  //  Maps the whole file, returns false if it couldn't be opened or mapped. An empty file opens with no data.
+  bool Open(const char* file_path);
+  void Close();
+
+  const char* GetData() const { return _data; }
+  size_t GetSize() const { return _size; }
+
+  //! FindLineStart
+  //  Returns the start of the first line beginning at or after offset, or size if there are none.
+  //  Ranges split at these points hold whole lines, so each thread can be handed its own range to parse.
+  static size_t FindLineStart(const char* data, size_t size, size_t offset);
+
+private:
+  const char* _data = nullptr;
+  size_t _size = 0;
+#if defined(_WIN32)
+  void* _file_handle = nullptr;
+  void* _mapping_handle = nullptr;
+#else
+  int _file_descriptor = -1;
+#endif
+};
+
+} // namespace Utility
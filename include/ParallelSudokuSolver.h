@@ -0,0 +1,80 @@
+#pragma once
+
+#include "ISudokuSolver.h"
+#include "SudokuSolver.h"
+#include "WorkStealingThreadPool.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace Sudoku
+{
+
+// --- Constants
+//! The search tree is split until there are at least this many branches for each thread, so a thread finishing early has something to steal
+#define kSearchPathsPerThread 8
+//! Deepest the search tree gets split
+#define kMaxSplitDepth 6
+
+//! Runs the search of a single puzzle on several threads, for hard puzzles where latency matters.
+//  The top few branch points of the search tree are expanded into paths of guesses, which worker threads replay and search on their own SudokuSolver.
+//  When solving, the first thread to find a solution cancels the rest. When counting, every thread keeps its own count, which are summed at the end.
+//  A budget's node limit is shared out evenly between the threads, and the first one to run out of budget cancels the rest.
+//  With a single thread the branches are searched on the calling thread, so a batch thread's solver doesn't start another.
+class ParallelSudokuSolver : public ISudokuSolver
+{
+public:
+  ParallelSudokuSolver(int thread_count);
+  ~ParallelSudokuSolver();
+
+  int GetValue(int row, int column) const override { return _values[row][column]; }
+
+  void LoadPuzzle(const int values[kSudokuSize][kSudokuSize]) override;
+  bool SolvePuzzle() override;
+  uint64_t CountSolutions(uint64_t solution_limit) override;
+  void SetBudget(uint64_t node_limit, uint64_t time_limit) override;
+
+private:
+  //! Everything a worker thread touches, kept on its own cache line
+  struct alignas(64) Worker
+  {
+    std::unique_ptr<SudokuSolver> _solver;
+    //! The search the solver was last prepared for
+    uint64_t _search_id = 0;
+    bool _is_prepared = false;
+    //! The solver's counters once it was prepared, which repeat what the root solver counted
+    SolverStats _prepared_stats;
+    uint64_t _solution_count = 0;
+  };
+
+  void SearchBranch(int worker_index, SudokuSolver::SearchPath* search_path);
+
+  std::unique_ptr<Worker[]> _workers;
+  int _thread_count;
+  std::unique_ptr<Utility::WorkStealingThreadPool<SudokuSolver::SearchPath>> _thread_pool;
+
+  //! Used to split the search tree
+  SudokuSolver _root_solver;
+  std::vector<SudokuSolver::SearchPath> _search_paths;
+
+  uint64_t _search_id = 0;
+  uint64_t _solution_limit = 1;
+  //! Set once the solution limit has been reached or a worker ran out of budget, every worker checks it while searching
+  std::atomic<bool> _is_cancelled;
+  //! Solutions found so far across every worker, only used to decide when to cancel
+  std::atomic<uint64_t> _found_solution_count;
+  bool _has_solution = false;
+
+  std::mutex _search_mutex;
+  std::condition_variable _search_finished_condition;
+  size_t _remaining_path_count = 0;
+
+  //! The puzzle values, filled in with the solution once one is found
+  int _values[kSudokuSize][kSudokuSize];
+};
+
+} // namespace Sudoku
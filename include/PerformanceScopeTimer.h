@@ -1,23 +1,58 @@
 #pragma once
 
-#include <string>
+#include <cstdint>
 
 namespace Utility
 {
 
-typedef unsigned long long uint64_t;
+// Technology Defines
+//! Turn this off to compile every TimePerformanceScope away, rather than skipping them at runtime
+#define _PERFORMANCE_TIMERS 1
 
-//! Simple class for tracking how long certain scopes take to execute
+// --- Macros
+#define PerformanceScopeConcat(a, b) a##b
+#define PerformanceScopeVariable(line) PerformanceScopeConcat(performance_scope_timer_, line)
+
+#if _PERFORMANCE_TIMERS
+//! Times the rest of the enclosing scope under the given name, which has to be a string literal
+#define TimePerformanceScope(scope_name) Utility::PerformanceScopeTimer PerformanceScopeVariable(__LINE__)(scope_name)
+#else
+#define TimePerformanceScope(scope_name)
+#endif
+
+//! Times the scope it lives in, from construction to destruction, with nanosecond resolution.
+//  Scopes nest, every thread keeps its own tree of scope names so timing never takes a lock. Nothing is recorded until Enable is called,
+//  until then a timer costs a single flag check. At exit the trees of every thread are merged and the calls and times of each scope are written to stderr.
 class PerformanceScopeTimer
 {
 public:
-  PerformanceScopeTimer(const char* scope_name);
+  //! scope_name has to outlive the program, string literals are expected
+  explicit PerformanceScopeTimer(const char* scope_name);
+  ~PerformanceScopeTimer();
+
+  PerformanceScopeTimer(const PerformanceScopeTimer&) = delete;
+  PerformanceScopeTimer& operator=(const PerformanceScopeTimer&) = delete;
 
-  void ScopeComplete();
+  //! Enable
+  //  Starts recording every timed scope, and writes the summary at exit. If a trace file is given every scope is also kept as an event,
+  //  and written out at exit as a Chrome trace (chrome://tracing or Perfetto) showing the timeline of every thread.
+  static void Enable(const char* trace_file_path = nullptr);
+  static bool IsEnabled();
+
+  //! Everything one thread has recorded, defined in the source file
+  struct ThreadTimers;
 
 private:
-  std::string _scope_name;
-  uint64_t _start_time;
+  static ThreadTimers& GetThreadTimers();
+  //! Registered with atexit by Enable
+  static void WriteResults();
+  static void WriteSummary();
+  static bool WriteChromeTrace(const char* file_path);
+
+  //! nullptr if timers were disabled when the scope started
+  ThreadTimers* _thread_timers;
+  int _node_index;
+  uint64_t _start_ns;
 };
 
 } // namespace Utility
@@ -0,0 +1,85 @@
+#pragma once
+
+#include "ISudokuSolver.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace Sudoku
+{
+
+// --- Constants
+#define kCanonicalSlots (kSudokuSize * kSudokuSize)
+//! Most transforms followed while they're tied for the smallest pattern of givens, and column orders tried for the values.
+//  Puzzles with more, which takes givens laid out very regularly such as a full board, aren't canonicalized
+#define kMaxCanonicalCandidates 4096
+
+//! How a puzzle maps onto its canonical form
+struct CanonicalTransform
+{
+  //! The puzzle is transposed before its rows and columns are reordered
+  bool _is_transposed = false;
+  //! Canonical row i is row _rows[i] of the transposed or original puzzle, and the same for columns
+  uint8_t _rows[kSudokuSize] = {};
+  uint8_t _columns[kSudokuSize] = {};
+  //! The canonical value of each value of the puzzle, indexed by value
+  uint8_t _labels[kSudokuSize + 1] = {};
+};
+
+//! A 9x9 puzzle in canonical form, the same for every puzzle equivalent to it up to relabeling values, reordering bands, stacks, the rows within a band and
+//  the columns within a stack, and transposing
+struct CanonicalPuzzle
+{
+  //! Canonical values row by row, 0 for an empty slot
+  uint8_t _values[kCanonicalSlots];
+  uint64_t _hash;
+  CanonicalTransform _transform;
+};
+
+//! Works out canonical forms. The canonical form is the smallest of every equivalent puzzle, first by where its givens are and then by their values, read row by row
+//  with values relabeled 1 onwards in the order they first appear. The givens come first, so a row with givens sorts before an empty one.
+//  Where the givens are doesn't depend on the values, so the columns can simply be sorted as each row is picked and only the rows are searched. The values then pick
+//  between the few transforms left tied. Holds the buffers for those transforms, so each thread needs its own.
+class PuzzleCanonicalizer
+{
+public:
+  PuzzleCanonicalizer();
+  ~PuzzleCanonicalizer();
+
+  //! Canonicalize
+  //  Works out the canonical form of the puzzle, given row by row with kEmptySlot for empty slots, and the transform onto it.
+  //  Returns false if the givens repeat a value in a group, column or row, or too many transforms tie for it to be worked out, see kMaxCanonicalCandidates.
+  bool Canonicalize(const int values[kCanonicalSlots], CanonicalPuzzle& puzzle);
+
+  //! ToCanonical
+  //  Maps a board of the puzzle, such as its solution, onto the canonical form. Empty slots become 0.
+  static void ToCanonical(const CanonicalTransform& transform, const int values[kCanonicalSlots], uint8_t canonical_values[kCanonicalSlots]);
+  //! FromCanonical
+  //  Maps a board in canonical form back onto the puzzle, the inverse of ToCanonical.
+  static void FromCanonical(const CanonicalTransform& transform, const uint8_t canonical_values[kCanonicalSlots], int values[kCanonicalSlots]);
+
+private:
+  //! The rows picked so far for a transform tied for the smallest pattern of givens
+  struct Candidate
+  {
+    bool _is_transposed;
+    uint8_t _rows[kSudokuSize];
+    //! Bands the rows so far were taken from
+    uint8_t _used_bands;
+    //! For each column, a bit for every row picked so far set where it has a given, the first row in the highest bit
+    uint16_t _column_patterns[kSudokuSize];
+  };
+
+  //! Sorts the columns into the order that gives the smallest pattern, the stacks with the most givens first and the columns with givens first within each stack.
+  //  order gets the columns and stack_keys the pattern of each stack in that order, so ties can be found
+  static void SortColumns(const uint16_t column_patterns[kSudokuSize], int depth, uint8_t order[kSudokuSize], uint32_t stack_keys[3]);
+  //! Tries every column order of the candidate that gives the same pattern, keeping the transform with the smallest values in best. Returns false past kMaxCanonicalCandidates
+  bool PickValueOrder(const Candidate& candidate, const uint8_t* board, uint8_t best_values[kCanonicalSlots], bool& has_best, CanonicalTransform& best);
+
+  std::vector<Candidate> _candidates;
+  std::vector<Candidate> _next_candidates;
+  //! Column orders tried by PickValueOrder for the current puzzle
+  int _order_count = 0;
+};
+
+} // namespace Sudoku
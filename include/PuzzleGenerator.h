@@ -0,0 +1,130 @@
+#pragma once
+
+#include "ISudokuSolver.h"
+#include "SudokuSolver.h"
+#include "WorkStealingThreadPool.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <vector>
+
+namespace Sudoku
+{
+
+// --- Constants
+//! Which slots are removed together, so the givens of the puzzle keep the symmetry
+#define kSymmetryNone 0
+//! A slot and the one it lands on when the board is turned half way round
+#define kSymmetryRotational 1
+//! A slot and the one across the middle column from it
+#define kSymmetryMirror 2
+//! Names accepted by PuzzleGenerator::GetSymmetry, in the order of their values
+#define kSymmetryNames { "none", "rotational", "mirror" }
+//! Fewest givens a 9x9 puzzle with a single solution can have
+#define kMinClueCount 17
+//! Puzzles handed to a worker at once
+#define kGeneratorBlockPuzzles 64
+//! Blocks in flight for each worker, enough to keep them busy while the oldest block is written out
+#define kGeneratorBlocksPerThread 4
+
+//! Totals for a finished Generate
+struct GeneratorResults
+{
+  uint64_t _puzzle_count = 0;
+  //! Givens across every puzzle
+  uint64_t _clue_count = 0;
+  //! Puzzles that got down to the target clue count, the rest have no slot left that can be emptied without losing uniqueness
+  uint64_t _target_reached_count = 0;
+  //! Solution counts run while removing clues
+  uint64_t _uniqueness_checks = 0;
+  double _elapsed_seconds = 0.0;
+};
+
+//! Generates 9x9 puzzles that have a single solution. Each one starts from a random complete grid, and clues are emptied in a random order
+//  for as long as the puzzle still has one solution, until the target clue count is reached or no clue can go.
+//  Blocks of puzzles are generated on a work stealing thread pool, every worker owning its own solver and random number generator.
+//  Each puzzle is seeded from the seed and its index, so the same seed always generates the same puzzles, whatever the thread count.
+class PuzzleGenerator
+{
+public:
+  //! A thread_count of 1 generates everything on the calling thread
+  PuzzleGenerator(int thread_count, bool pin_threads);
+  ~PuzzleGenerator();
+
+  //! Generate
+  //  Generates puzzle_count puzzles and writes them to output, as lines or as a binary puzzle file. Returns false if writing failed.
+  bool Generate(uint64_t puzzle_count, FILE* output, bool is_binary);
+
+  const GeneratorResults& GetResults() const { return _results; }
+  //! SetClueCount
+  //  Clues are removed until this many are left, kMinClueCount by default which removes every clue it can.
+  void SetClueCount(int clue_count);
+  int GetClueCount() const { return _clue_count; }
+  //! SetSymmetry
+  //  Picks which slots are emptied together, kSymmetryNone by default.
+  void SetSymmetry(int symmetry) { _symmetry = symmetry; }
+  void SetSeed(uint64_t seed) { _seed = seed; }
+  //! SetWritingSolutions
+  //  Writes each puzzle's solution after it, separated by a space on lines, or as the record's solution in a binary puzzle file.
+  void SetWritingSolutions(bool is_writing_solutions) { _is_writing_solutions = is_writing_solutions; }
+
+  //! GetSymmetry
+  //  Returns the symmetry with the given name, or -1 if it isn't one of kSymmetryNames.
+  static int GetSymmetry(const char* symmetry_name);
+
+private:
+  struct Block
+  {
+    uint64_t _first_puzzle = 0;
+    int _puzzle_count = 0;
+    //! Sized for kGeneratorBlockPuzzles puzzles and their solutions written as lines
+    std::vector<char> _output;
+    size_t _output_size = 0;
+    GeneratorResults _results;
+    std::atomic<bool> _is_generated;
+  };
+
+  struct Worker
+  {
+    SudokuSolver _solver;
+    std::mt19937_64 _random;
+  };
+
+  void GenerateBlock(int worker_index, Block& block);
+  //! Fills puzzle with a puzzle that has a single solution, and solution with its solution. Returns the number of givens
+  int GeneratePuzzle(Worker& worker, int puzzle[kSudokuSize][kSudokuSize], int solution[kSudokuSize][kSudokuSize], uint64_t& uniqueness_checks);
+  //! Fills values with a random complete grid
+  void GenerateGrid(Worker& worker, int values[kSudokuSize][kSudokuSize]);
+  //! Hands the next block off to be generated, and writes out finished blocks until fewer than max_in_flight remain
+  void SubmitBlock(uint64_t first_puzzle, int puzzle_count);
+  void WriteGeneratedBlocks(uint64_t max_in_flight);
+
+  std::vector<std::unique_ptr<Worker>> _workers;
+  std::unique_ptr<Utility::WorkStealingThreadPool<Block>> _thread_pool;
+
+  std::unique_ptr<Block[]> _blocks;
+  int _block_count = 0;
+  uint64_t _next_sequence = 0;
+  uint64_t _next_write_sequence = 0;
+
+  std::mutex _generated_mutex;
+  std::condition_variable _generated_condition;
+
+  GeneratorResults _results;
+  FILE* _output = nullptr;
+  bool _output_failed = false;
+  bool _is_binary = false;
+  bool _is_writing_solutions = false;
+  int _clue_count = kMinClueCount;
+  int _symmetry = kSymmetryNone;
+  uint64_t _seed = 0;
+};
+
+} // namespace Sudoku
@@ -0,0 +1,79 @@
+#pragma once
+
+#include "PuzzleCanonicalizer.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace Sudoku
+{
+
+// --- Constants
+//! The cache is split into this many shards, each with its own lock, so workers rarely wait on each other
+#define kSolutionCacheShards 16
+
+//! What was found for a cached puzzle. A solution found without checking uniqueness doesn't say whether there are others
+#define kCachedSolution 1
+#define kCachedUniqueSolution 2
+#define kCachedMultipleSolutions 3
+#define kCachedNoSolution 4
+
+//! Results of solved 9x9 puzzles, kept by their canonical form so every puzzle equivalent to one already solved is answered without a search.
+//  Holds a fixed number of puzzles, dropping the least recently used one when a shard is full. Safe to use from any number of threads.
+class SolutionCache
+{
+public:
+  //! Room for entry_count puzzles, split evenly between the shards, which is all it ever allocates
+  SolutionCache(size_t entry_count);
+  ~SolutionCache();
+
+  //! Find
+  //  Looks the canonical puzzle up, copying what was found for it and its canonical solution out and making it the most recently used.
+  //  Returns false if it isn't cached. The solution is only copied for kCachedSolution and kCachedUniqueSolution.
+  bool Find(const CanonicalPuzzle& puzzle, uint8_t& status, uint8_t solution[kCanonicalSlots]);
+  //! Insert
+  //  Caches what was found for the canonical puzzle, replacing anything cached for it before. solution is the canonical solution, only read for
+  //  kCachedSolution and kCachedUniqueSolution.
+  void Insert(const CanonicalPuzzle& puzzle, uint8_t status, const uint8_t* solution);
+
+  size_t GetCapacity() const { return _shard_capacity * kSolutionCacheShards; }
+
+private:
+  struct Entry
+  {
+    uint64_t _hash;
+    uint8_t _puzzle[kCanonicalSlots];
+    uint8_t _solution[kCanonicalSlots];
+    uint8_t _status;
+    //! Neighbours in the shard's list from most to least recently used
+    uint32_t _previous;
+    uint32_t _next;
+  };
+
+  struct Shard
+  {
+    std::mutex _mutex;
+    std::vector<Entry> _entries;
+    //! Open addressing by hash, each slot holding an entry index plus 1 or 0 when it's free
+    std::vector<uint32_t> _index;
+    uint32_t _entry_count = 0;
+    uint32_t _head;
+    uint32_t _tail;
+  };
+
+  //! Returns the index slot holding the puzzle's entry, or the free slot it would go in
+  size_t FindIndexSlot(const Shard& shard, uint64_t hash, const uint8_t* puzzle) const;
+  //! Takes an entry out of the index, shifting the slots after it back so no lookup stops short
+  void RemoveFromIndex(Shard& shard, uint32_t entry_index);
+  void Unlink(Shard& shard, uint32_t entry_index);
+  void PushFront(Shard& shard, uint32_t entry_index);
+
+  std::unique_ptr<Shard[]> _shards;
+  size_t _shard_capacity = 0;
+  size_t _index_mask = 0;
+};
+
+} // namespace Sudoku
@@ -0,0 +1,219 @@
+#pragma once
+
+#include "BatchRunner.h"
+#include "SolverPool.h"
+#include "WorkStealingThreadPool.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace Sudoku
+{
+
+// --- Constants
+//! Most requests sent to a worker together
+#define kServiceBatchSize 64
+//! Batches in flight for each worker, once they're all taken reading requests waits for one to come back
+#define kServiceBatchesPerThread 4
+//! How long a request waits for its batch to fill by default, in microseconds
+#define kDefaultServiceLatencyCap 200
+//! Requests a client can have waiting on responses before its input stops being read
+#define kServiceMaxPendingRequests 4096
+//! Bucket i of the latency histogram counts requests answered in under 2^i microseconds, the last one everything slower
+#define kServiceLatencyBuckets 24
+//! The line that asks for the stats rather than a solve
+#define kServiceStatsCommand "stats"
+
+//! Totals since the service started
+struct ServiceStats
+{
+  uint64_t _client_count = 0;
+  //! Puzzle lines answered, and how each turned out
+  uint64_t _request_count = 0;
+  uint64_t _solved_count = 0;
+  uint64_t _no_solution_count = 0;
+  uint64_t _invalid_count = 0;
+  uint64_t _multiple_solution_count = 0;
+  uint64_t _invalid_givens_count = 0;
+  uint64_t _batch_count = 0;
+  //! From reading a request to its response being ready to write
+  uint64_t _latency_histogram[kServiceLatencyBuckets] = {};
+  uint64_t _total_latency_microseconds = 0;
+  uint64_t _max_latency_microseconds = 0;
+  double _elapsed_seconds = 0.0;
+};
+
+//! Long running service that solves 9x9 puzzles sent one per line, so clients don't pay for starting a process per puzzle.
+//  Lines are laid out like batch lines, and every puzzle gets a line back in the order they were sent, its solution or the result a batch would write.
+//  The line "stats" gets the service stats back as one line of JSON instead, counting exactly the requests the service read before it.
+//  A single thread reads and writes every client with epoll. Requests from all of them are gathered into batches, which go to the workers once kServiceBatchSize
+//  are waiting or the oldest has waited the latency cap, each worker checking a solver out of a SolverPool for its batch. Only available on Linux.
+class SolveService
+{
+public:
+  //! The engine has to be one CreateSolver recognizes, thread_count workers each get a solver
+  SolveService(const char* engine_name, int thread_count, bool pin_threads);
+  ~SolveService();
+
+  //! RunSocket
+  //  Serves every client that connects to a Unix domain socket created at socket_path until Stop is called, then removes it.
+  //  Returns false if the socket couldn't be set up, or on platforms other than Linux.
+  bool RunSocket(const char* socket_path);
+  //! RunStdio
+  //  Serves one client reading requests from stdin and writing the responses to stdout, until stdin ends or Stop is called.
+  //  Returns false if writing failed, or on platforms other than Linux.
+  bool RunStdio();
+  //! Stop
+  //  Makes the running service finish the requests it has read and return. Only writes an atomic flag and an eventfd, so it's safe to call from a signal handler.
+  void Stop();
+
+  //! SetLatencyCap
+  //  Longest a request waits for its batch to fill before it's sent anyway, in microseconds. At 0 batches only gather the requests read together.
+  void SetLatencyCap(int latency_cap) { _latency_cap = (latency_cap > 0) ? latency_cap : 0; }
+  //! SetCheckingUniqueness
+  //  Makes every puzzle that doesn't have exactly one solution get "Multiple solutions", or "Invalid givens" when a value repeats in a unit.
+  void SetCheckingUniqueness(bool is_checking_uniqueness) { _is_checking_uniqueness = is_checking_uniqueness; }
+
+  const ServiceStats& GetStats() const { return _stats; }
+  //! WriteStatsJson
+  //  Writes the stats as a single line of JSON, with throughput, latency percentiles from the histogram and the histogram itself, returns its length.
+  size_t WriteStatsJson(char* buffer, size_t size) const;
+
+private:
+  struct Client;
+
+  struct Request
+  {
+    Client* _client;
+    //! Which of the client's responses this fills
+    uint64_t _sequence;
+    char _line[kPuzzleLineLength + 1];
+    int _line_length;
+    std::chrono::steady_clock::time_point _read_time;
+    char _response[kPuzzleLineLength + 1];
+    int _response_length;
+    //! The batch line status the response is for
+    uint8_t _status;
+    //! How many puzzle lines the service read before this one, from every client
+    uint64_t _read_index;
+  };
+
+  struct Batch
+  {
+    Request _requests[kServiceBatchSize];
+    int _request_count = 0;
+  };
+
+  struct Response
+  {
+    char _text[kPuzzleLineLength + 1];
+    int _length = 0;
+    bool _is_ready = false;
+    //! Written out as the stats when it reaches the front
+    bool _is_stats = false;
+    //! The stats counting only the requests read before it, ready once they've all been answered
+    std::unique_ptr<ServiceStats> _stats;
+  };
+
+  //! A stats response still waiting for requests read before it
+  struct PendingStats
+  {
+    Client* _client;
+    uint64_t _sequence;
+    //! Requests with a lower _read_index are counted in its stats
+    uint64_t _read_count;
+    uint64_t _missing_count;
+  };
+
+  struct Client
+  {
+    int _input_handle = -1;
+    int _output_handle = -1;
+    bool _is_socket = false;
+    //! Regular files can't go in epoll, they're read every time round instead
+    bool _is_always_readable = false;
+    //! The part of the line being read that's kept, like a batch line only the puzzle and the character after it
+    char _line[kPuzzleLineLength + 1];
+    int _line_length = 0;
+    //! Responses still to be written, in request order. The one at the front is for request _first_sequence
+    std::deque<Response> _responses;
+    uint64_t _first_sequence = 0;
+    std::vector<char> _output;
+    size_t _output_offset = 0;
+    bool _is_input_closed = false;
+    //! Set once writing fails, the responses still to come are dropped
+    bool _is_failed = false;
+    bool _is_reading = false;
+    bool _is_writing = false;
+    //! In epoll, which is only while it's reading or writing, so a client that hung up doesn't keep waking it
+    bool _is_registered = false;
+  };
+
+  //! Sets up epoll, the wake and timer events, and runs until stopped or, with a stdio client, its input ends and everything is answered
+  bool RunLoop(Client* stdio_client);
+  void AcceptClients();
+  //! Reads what's waiting from the client and queues every line
+  void ReadClient(Client& client);
+  void HandleLine(Client& client, const char* line, int length);
+  //! Hands the current batch to the workers
+  void SubmitBatch();
+  //! Takes a free batch, collecting solved ones until there is one
+  Batch* TakeFreeBatch();
+  void SolveBatch(int worker_index, Batch& batch);
+  //! Copies the responses of solved batches to their clients, and counts them towards the stats
+  void CollectSolvedBatches();
+  //! Moves the ready responses at the front to the client's output and writes as much as it takes
+  void WriteClient(Client& client);
+  //! Picks which events epoll waits on for the client, from its pending requests and output
+  void UpdateClientEvents(Client& client);
+  //! Takes the client out of epoll and closes its socket once it's done and nothing it sent is still to be answered, returns true if it did
+  bool TryCloseClient(Client& client);
+  //! Sets the timer to go off after the given microseconds
+  void ArmBatchTimer(int64_t microseconds);
+  static size_t WriteStatsJson(const ServiceStats& stats, char* buffer, size_t size);
+
+  std::unique_ptr<SolverPool> _solver_pool;
+  std::unique_ptr<Utility::WorkStealingThreadPool<Batch>> _thread_pool;
+
+  std::unique_ptr<Batch[]> _batches;
+  int _batch_count = 0;
+  //! Only used by the service thread, like everything a client has
+  std::vector<Batch*> _free_batches;
+  Batch* _current_batch = nullptr;
+  int _batches_in_flight = 0;
+  std::vector<Client*> _clients;
+
+  //! Batches handed back by the workers
+  std::mutex _solved_mutex;
+  std::condition_variable _solved_condition;
+  std::vector<Batch*> _solved_batches;
+
+  //! When the current batch has to be sent by
+  std::chrono::steady_clock::time_point _batch_deadline;
+  //! Solved batches being collected, swapped with _solved_batches so the workers aren't held up
+  std::vector<Batch*> _collected_batches;
+
+  int _epoll_handle = -1;
+  //! -1 unless serving a socket. Epoll events point at these handles, or at a client
+  int _listen_handle = -1;
+  //! Written to wake the service thread when a batch is solved or it's stopped
+  int _wake_handle = -1;
+  int _timer_handle = -1;
+  std::atomic<bool> _is_stopping;
+  int _latency_cap = kDefaultServiceLatencyCap;
+  bool _is_checking_uniqueness = false;
+  ServiceStats _stats;
+  //! Puzzle lines read so far, from every client
+  uint64_t _read_request_count = 0;
+  std::vector<PendingStats> _pending_stats;
+  std::chrono::steady_clock::time_point _start_time;
+};
+
+} // namespace Sudoku
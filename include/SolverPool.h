@@ -0,0 +1,43 @@
+#pragma once
+
+#include "ISudokuSolver.h"
+
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace Sudoku
+{
+
+//! Preallocated 9x9 solvers that batch and service code check out for a puzzle and hand back, so once the pool is created no solver is built and nothing is allocated per puzzle.
+//  Load puzzles into a checked out solver with ISudokuSolver::Load, it's reset when it's returned.
+class SolverPool
+{
+public:
+  //! Creates solver_count solvers of the named engine, which has to be one CreateSolver recognizes, and solves an empty board with each so their buffers are already grown
+  SolverPool(const char* engine_name, int solver_count);
+  ~SolverPool();
+
+  //! Acquire
+  //  Checks out a solver, waiting for one to be returned if they're all in use.
+  ISudokuSolver& Acquire();
+  //! TryAcquire
+  //  Checks out a solver, returns nullptr rather than waiting if they're all in use.
+  ISudokuSolver* TryAcquire();
+  //! Release
+  //  Resets a solver checked out of this pool and returns it.
+  void Release(ISudokuSolver& solver);
+
+  int GetSolverCount() const { return static_cast<int>(_solvers.size()); }
+
+private:
+  std::vector<std::unique_ptr<ISudokuSolver>> _solvers;
+  //! Solvers that aren't checked out, used as a stack so the one returned last, with the warmest caches, goes out next
+  std::vector<ISudokuSolver*> _free_solvers;
+
+  std::mutex _mutex;
+  std::condition_variable _released_condition;
+};
+
+} // namespace Sudoku
@@ -1,58 +1,165 @@
 #pragma once
 
+#include "BoardGeometry.h"
+#include "CandidateBoard.h"
+#include "DeductionStrategies.h"
+#include "ISudokuSolver.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
 #include <vector>
 
 namespace Sudoku
 {
 
-// Technology Defines
-//! Turn this on to help visualize the data that gets setup and sorted
-#define _DEBUG_DATA 0
-//! Turn this on to help visualize how the data is being solved
-#define _DEBUG_SOLVING 0
-
 // --- Constants
-#define kSudokuSize 9
-#define kEmptySlot -1
+//! Most guesses a SearchPath can hold
+#define kMaxSearchPathLength 16
+//! How NextLogicalStep found its value
+#define kLogicalStepNakedSingle 0
+#define kLogicalStepHiddenSingle 1
 
-class SudokuSolver
+//! Solves puzzles with constraint propagation, falling back to a depth first search when that stalls
+class SudokuSolver : public ISudokuSolver
 {
 public:
-  SudokuSolver() {};
+  SudokuSolver() : _kernels(&GetCandidateKernels()), _strategies(GetDeductionStrategies()) {};
   ~SudokuSolver() {};
 
-  bool LoadFromFile(const char* file_path);
-  bool Solve();
+  int GetValue(int row, int column) const override { return _puzzle_slots[(row * kSudokuSize) + column]._value; }
+
+  void LoadPuzzle(const int values[kSudokuSize][kSudokuSize]) override;
+  bool SolvePuzzle() override;
+  uint64_t CountSolutions(uint64_t solution_limit) override;
+  void Reset() override;
+
+  //! The guesses leading from the propagated puzzle to one branch of the search tree
+  struct SearchPath
+  {
+    int _length = 0;
+    uint8_t _slot_indices[kMaxSearchPathLength];
+    uint8_t _values[kMaxSearchPathLength];
+  };
+
+  //! A value that can be placed without guessing, found by NextLogicalStep
+  struct LogicalStep
+  {
+    int _slot = 0;
+    int _value = 0;
+    //! kLogicalStepNakedSingle or kLogicalStepHiddenSingle
+    int _kind = kLogicalStepNakedSingle;
+    //! The last deduction strategy needed before the single showed up, -1 if it's on the board as is
+    int _strategy_index = -1;
+  };
+
+  //! StartEditing
+  //  Works out the possible values of the loaded puzzle so it can be changed one slot at a time. Returns false if the givens repeat a value in a group, column or row,
+  //  or leave an empty slot without any possible values.
+  //  Solving afterwards starts again from the values placed so far.
+  bool StartEditing();
+  //! SetCell
+  //  Places a value in the slot, replacing any value already there, and takes it away from the 20 slots sharing a group, column or row with it.
+  //  Returns false and leaves the board as it was if one of those slots already holds the value, or the slot or value is out of range.
+  bool SetCell(int slot, int value);
+  //! ClearCell
+  //  Empties the slot, working out the possible values of it and its 20 peers again from the values placed around them. Does nothing for a slot out of range.
+  void ClearCell(int slot);
+  //! GetCandidates
+  //  Returns the possible values of the slot while editing, bit (n - 1) is set if n is possible. A slot holding a value, or out of range, has none.
+  uint16_t GetCandidates(int slot) const;
+  //! NextLogicalStep
+  //  Finds a value that can be placed without guessing, without changing the board. Singles come first, then the deduction strategies in use are applied to a copy
+  //  of the possible values until a single shows up. Returns false if nothing can be placed without guessing.
+  bool NextLogicalStep(LogicalStep& step) const;
+
+  //! SetCancelFlag
+  //  The search stops as soon as the given flag is set, so another thread can cancel it. Pass nullptr to never cancel.
+  void SetCancelFlag(const std::atomic<bool>* cancel_flag) { _cancel_flag = cancel_flag; }
+  //! SetDeductionStrategies
+  //  Picks the strategies run once singles stall, as bits of DeductionStrategies.h. Starts out with the ones selected when the solver was created.
+  void SetDeductionStrategies(uint32_t strategies) { _strategies = strategies; }
+  //! PrepareSearch
+  //  Sets up the loaded puzzle and runs constraint propagation on it, returns false if the puzzle can't be solved.
+  bool PrepareSearch();
+  //! CollectSearchPaths
+  //  After PrepareSearch, lists every branch of the search tree that's depth guesses deep, or shallower if it was solved sooner.
+  void CollectSearchPaths(int depth, std::vector<SearchPath>& search_paths);
+  //! SearchFromPath
+  //  After PrepareSearch, replays the guesses of the path and searches the branch for up to solution_limit solutions (0 for no limit).
+  //  Returns the number found, the prepared puzzle is restored afterwards so another path can be searched.
+  uint64_t SearchFromPath(const SearchPath& search_path, uint64_t solution_limit);
+  //! CopySolution
+  //  Copies out the first solution found by the last search.
+  void CopySolution(int values[kSudokuSize][kSudokuSize]) const;
 
 private:
+  typedef BoardGeometry<3> Geometry;
+
+  //! Units and peers come from Geometry's tables, so a slot only needs its value and the board can be copied as is
   struct Slot
   {
-#if _DEBUG_SOLVING
-    int _grid_row;
-    int _grid_column;
-#endif
-    int _value = kEmptySlot;
-    std::vector<int> _possible_values;
-    std::vector<Slot*>* _group;
-    std::vector<Slot*>* _column;
-    std::vector<Slot*>* _row;
+    int8_t _value = kEmptySlot;
+  };
+
+  //! The state of a slot before it was changed, used to undo changes when backtracking
+  struct TrailEntry
+  {
+    uint8_t _slot;
+    int8_t _value;
+    uint16_t _possible_values;
   };
 
-  void DisplayPuzzle() const;
-  void SetupDataGroups();
   void VisualizeDataGroups() const;
-  void DeterminePossibleValues();
+  //! Returns false if a value was placed twice in a group, column or row, or an empty slot has no possible values
+  bool DeterminePossibleValues();
   void VisualizePossibleValues(int row, int column) const;
-  void FindSolution();
-
-  //! The Sudoku Puzzle in the form of a 2D array that matches how it gets displayed (rows and columns)
-  Slot _puzzle_slots[kSudokuSize][kSudokuSize];
-  //! The Sudoku Puzzle broken into the 3x3 groups (Only the solved slots)
-  std::vector<Slot*> _groups[kSudokuSize];
-  //! The Sudoku Puzzle broken into the individual vertical columns (Only the solved slots)
-  std::vector<Slot*> _columns[kSudokuSize];
-  //! The Sudoku Puzzle broken into the individual horizontal rows (Only the solved slots)
-  std::vector<Slot*> _rows[kSudokuSize];
+  //! Solves the puzzle, returns false if it has no solution
+  bool FindSolution();
+  void ResetSearch();
+  //! Depth first search that branches on the empty slot with the fewest possible values, returns true once it should stop
+  bool Search();
+  //! Returns the empty slot with the fewest possible values, or Geometry::kSlots if every slot has been filled
+  int FindBranchSlot() const;
+  void CollectSearchPaths(int depth, SearchPath& current_path, std::vector<SearchPath>& search_paths);
+  //! Places every naked and hidden single, and applies the deduction strategies, until nothing changes. Returns false if the puzzle became invalid
+  bool PropagateConstraints();
+  //! Runs the enabled deduction strategies until one takes values away, queueing any slot left with a single value.
+  //  made_progress is set if one did, returns false if a slot was left without any possible values
+  bool ApplyDeductionStrategies(bool& made_progress);
+  //! Solves the slot and removes the value from its 20 peers, returns false if a peer was left without any possible values
+  bool PlaceValue(int slot, int value);
+  void SetSlotValue(int slot, int value);
+  //! Returns the values not yet placed in the slot's group, column or row
+  uint16_t GetUnplacedValues(int slot) const;
+  //! Restores every slot recorded after the given trail position
+  void UndoTrail(size_t trail_mark);
+
+  //! The Sudoku Puzzle row by row, indexed by slot
+  Slot _puzzle_slots[Geometry::kSlots];
+  //! Bitmask of the values already placed in each 3x3 group, column and row
+  UnitValues _unit_values;
+  //! The possible values of every slot, laid out for the propagation kernels
+  CandidateBoard _candidate_board;
+  //! The value each slot is forced to, filled in by the propagation kernels
+  CandidateBoard _singles;
+  const CandidateKernels* _kernels;
+  //! Bits of the deduction strategies to run when singles stall
+  uint32_t _strategies;
+
+  //! Every slot change made while solving, in order
+  std::vector<TrailEntry> _trail;
+  //! Slots that were updated, and now only have 1 possible value
+  std::vector<uint8_t> _newly_single_slots;
+
+  //! Stop searching after finding this many solutions, 0 to find all of them
+  uint64_t _solution_limit = 1;
+  uint64_t _solution_count = 0;
+  //! Guesses in effect at the current point of the search
+  int _search_depth = 0;
+  //! The first solution found
+  int8_t _solution_values[Geometry::kSlots];
+  const std::atomic<bool>* _cancel_flag = nullptr;
 };
 
 } // namespace Sudoku
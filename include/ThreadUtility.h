@@ -0,0 +1,14 @@
+#pragma once
+
+namespace Utility
+{
+
+//! GetHardwareThreadCount
+//  Returns the number of threads the hardware can run at once, at least 1.
+int GetHardwareThreadCount();
+
+//! PinCurrentThread
+//  Restricts the calling thread to the given logical core, returns false if the platform refused or doesn't support it.
+bool PinCurrentThread(int core_index);
+
+} // namespace Utility
@@ -0,0 +1,181 @@
+#pragma once
+
+#include "ThreadUtility.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Utility
+{
+
+//! Thread pool where every worker owns a deque of tasks, and steals from the other workers once its own runs dry.
+//  Tasks are handed around as pointers, so queuing one never allocates. Deques are taken from the front, by owners and thieves alike,
+//  so the oldest work always finishes first, which keeps anything waiting on results in order from stalling.
+template<typename Task>
+class WorkStealingThreadPool
+{
+public:
+  typedef std::function<void(int worker_index, Task* task)> TaskHandler;
+
+  //! The deque of each worker can hold queue_capacity tasks, Submit must never queue more than that at once
+  WorkStealingThreadPool(int thread_count, int queue_capacity, bool pin_threads, TaskHandler task_handler);
+  ~WorkStealingThreadPool();
+
+  //! Submit
+  //  Queues the task on the next worker's deque, going round robin.
+  void Submit(Task* task);
+  //! SubmitTo
+  //  Queues the task at the back of the given worker's deque. Unlike Submit it can be called from any thread, such as a worker handing a task back to itself.
+  void SubmitTo(int worker_index, Task* task);
+
+  int GetThreadCount() const { return _thread_count; }
+
+private:
+  struct Deque
+  {
+    std::mutex _mutex;
+    std::vector<Task*> _tasks;
+    size_t _head = 0;
+    size_t _count = 0;
+  };
+
+  void WorkerLoop(int worker_index, bool pin_thread);
+  bool TryPopFront(Deque& deque, Task*& task);
+  //! Takes from the worker's own deque first, then tries every other worker's
+  bool TryGetTask(int worker_index, Task*& task);
+
+  int _thread_count;
+  TaskHandler _task_handler;
+  std::unique_ptr<Deque[]> _deques;
+  std::vector<std::thread> _threads;
+  int _next_deque = 0;
+
+  std::mutex _wake_mutex;
+  std::condition_variable _wake_condition;
+  //! Tasks that have been submitted but not taken by a worker yet
+  std::atomic<int> _queued_count;
+  bool _is_stopping = false;
+};
+
+template<typename Task>
+WorkStealingThreadPool<Task>::WorkStealingThreadPool(int thread_count, int queue_capacity, bool pin_threads, TaskHandler task_handler)
+  : _thread_count(thread_count)
+  , _task_handler(task_handler)
+  , _deques(new Deque[thread_count])
+  , _queued_count(0)
+{
+  for(int i = 0; i < _thread_count; ++i)
+  {
+    _deques[i]._tasks.resize(queue_capacity);
+  }
+
+  _threads.reserve(_thread_count);
+  for(int i = 0; i < _thread_count; ++i)
+  {
+    _threads.emplace_back(&WorkStealingThreadPool::WorkerLoop, this, i, pin_threads);
+  }
+}
+
+template<typename Task>
+WorkStealingThreadPool<Task>::~WorkStealingThreadPool()
+{
+  {
+    std::lock_guard<std::mutex> lock(_wake_mutex);
+    _is_stopping = true;
+  }
+  _wake_condition.notify_all();
+
+  for(std::thread& thread : _threads)
+  {
+    thread.join();
+  }
+}
+
+template<typename Task>
+void WorkStealingThreadPool<Task>::Submit(Task* task)
+{
+  int worker_index = _next_deque;
+  _next_deque = (_next_deque + 1) % _thread_count;
+  SubmitTo(worker_index, task);
+}
+
+template<typename Task>
+void WorkStealingThreadPool<Task>::SubmitTo(int worker_index, Task* task)
+{
+  Deque& deque = _deques[worker_index];
+  {
+    std::lock_guard<std::mutex> lock(deque._mutex);
+    deque._tasks[(deque._head + deque._count) % deque._tasks.size()] = task;
+    ++deque._count;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(_wake_mutex);
+    ++_queued_count;
+  }
+  _wake_condition.notify_one();
+}
+
+template<typename Task>
+void WorkStealingThreadPool<Task>::WorkerLoop(int worker_index, bool pin_thread)
+{
+  if(pin_thread == true)
+  {
+    PinCurrentThread(worker_index % GetHardwareThreadCount());
+  }
+
+  while(true)
+  {
+    Task* task = nullptr;
+    if(TryGetTask(worker_index, task) == true)
+    {
+      _task_handler(worker_index, task);
+      continue;
+    }
+
+    std::unique_lock<std::mutex> lock(_wake_mutex);
+    _wake_condition.wait(lock, [this]() { return _is_stopping == true || _queued_count > 0; });
+    if(_is_stopping == true && _queued_count == 0)
+    {
+      return;
+    }
+  }
+}
+
+template<typename Task>
+bool WorkStealingThreadPool<Task>::TryPopFront(Deque& deque, Task*& task)
+{
+  std::lock_guard<std::mutex> lock(deque._mutex);
+  if(deque._count == 0)
+  {
+    return false;
+  }
+
+  task = deque._tasks[deque._head];
+  deque._head = (deque._head + 1) % deque._tasks.size();
+  --deque._count;
+  --_queued_count;
+  return true;
+}
+
+template<typename Task>
+bool WorkStealingThreadPool<Task>::TryGetTask(int worker_index, Task*& task)
+{
+  for(int i = 0; i < _thread_count; ++i)
+  {
+    if(TryPopFront(_deques[(worker_index + i) % _thread_count], task) == true)
+    {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+} // namespace Utility
@@ -0,0 +1,507 @@
+#include "BasicSudokuSolver.h"
+
+#include "BitUtility.h"
+#include "DeductionStrategies.h"
+
+namespace Sudoku
+{
+
+// --- Macros
+//! Expects a value from 1 up to the size of the board, converts it to its bit in a Mask
+#define BoardValueToMask(value) static_cast<Mask>(1u << ((value) - 1))
+
+// --- Pubic Interface --- //
+template<int BoxSize>
+void BasicSudokuSolver<BoxSize>::LoadPuzzle(const int values[kSudokuSize][kSudokuSize])
+{
+  if constexpr(Geometry::kSize == kSudokuSize)
+  {
+    LoadPuzzleValues(&values[0][0]);
+  }
+  else
+  {
+    for(int slot = 0; slot < Geometry::kSlots; ++slot)
+    {
+      _values[slot] = kEmptySlot;
+    }
+  }
+}
+
+template<int BoxSize>
+void BasicSudokuSolver<BoxSize>::LoadPuzzleValues(const int* values)
+{
+  for(int slot = 0; slot < Geometry::kSlots; ++slot)
+  {
+    _values[slot] = static_cast<int8_t>((values[slot] >= 1 && values[slot] <= Geometry::kSize) ? values[slot] : kEmptySlot);
+  }
+}
+
+template<int BoxSize>
+bool BasicSudokuSolver<BoxSize>::SolvePuzzle()
+{
+  return CountSolutions(1) > 0;
+}
+
+template<int BoxSize>
+uint64_t BasicSudokuSolver<BoxSize>::CountSolutions(uint64_t solution_limit)
+{
+  ResetSearch();
+
+  _solution_limit = solution_limit;
+  _random_state = kRestartSeed;
+  _is_randomized = false;
+  uint64_t run_nodes = static_cast<uint64_t>(Geometry::kSlots) * kRestartSlotNodes;
+  bool is_valid = DeterminePossibleValues();
+  while(is_valid == true)
+  {
+    _restart_node_limit = _stats._nodes + run_nodes;
+    _is_restarting = false;
+    Search();
+    if(_is_restarting == false)
+    {
+      break;
+    }
+
+    // Start over from the givens, anything found so far is found again
+    UndoTrail(0);
+    _newly_single_slots.clear();
+    _search_depth = 0;
+    _solution_count = 0;
+    _is_randomized = true;
+    run_nodes += (run_nodes * kRestartGrowthPercent) / 100;
+    is_valid = DeterminePossibleValues();
+  }
+
+  if(_solution_count > 0)
+  {
+    // Counting more than one solution unwinds the search, so put the first one back
+    for(int slot = 0; slot < Geometry::kSlots; ++slot)
+    {
+      _values[slot] = _solution_values[slot];
+      _possible_values[slot] = 0;
+    }
+  }
+
+  return _solution_count;
+}
+
+// --- Private Interface --- //
+template<int BoxSize>
+bool BasicSudokuSolver<BoxSize>::DeterminePossibleValues()
+{
+  const typename Geometry::Tables& tables = Geometry::kTables;
+
+  // Mark the values that have already been placed, a value seen twice in a unit means the givens break the rules
+  for(int unit = 0; unit < Geometry::kUnits; ++unit)
+  {
+    _unit_values[unit] = 0;
+  }
+
+  for(int slot = 0; slot < Geometry::kSlots; ++slot)
+  {
+    if(_values[slot] == kEmptySlot)
+    {
+      continue;
+    }
+
+    Mask mask = BoardValueToMask(_values[slot]);
+    for(int i = 0; i < 3; ++i)
+    {
+      Mask& unit_values = _unit_values[tables._slot_units[slot][i]];
+      if((unit_values & mask) != 0)
+      {
+        return false;
+      }
+      unit_values = static_cast<Mask>(unit_values | mask);
+    }
+  }
+
+  // Anything not used by the slot's units is still possible
+  for(int slot = 0; slot < Geometry::kSlots; ++slot)
+  {
+    if(_values[slot] != kEmptySlot)
+    {
+      _possible_values[slot] = 0;
+      continue;
+    }
+
+    const uint8_t* units = tables._slot_units[slot];
+    _possible_values[slot] = static_cast<Mask>(Geometry::kAllValues & ~(_unit_values[units[0]] | _unit_values[units[1]] | _unit_values[units[2]]));
+    if(_possible_values[slot] == 0)
+    {
+      return false;
+    }
+    if(Utility::PopCount(_possible_values[slot]) == 1)
+    {
+      _newly_single_slots.push_back(static_cast<Index>(slot));
+    }
+  }
+
+  return true;
+}
+
+template<int BoxSize>
+void BasicSudokuSolver<BoxSize>::ResetSearch()
+{
+  // Every placement records itself plus at most every one of its peers
+  _trail.clear();
+  _trail.reserve(Geometry::kSlots * (Geometry::kPeerCount + 1));
+  _newly_single_slots.clear();
+  _newly_single_slots.reserve(Geometry::kSlots);
+  _stats = SolverStats();
+  _search_depth = 0;
+  _solution_count = 0;
+  StartBudget();
+}
+
+template<int BoxSize>
+bool BasicSudokuSolver<BoxSize>::Search()
+{
+  ++_stats._nodes;
+
+  if(IsOverBudget() == true)
+  {
+    // Stop searching, the same as if the solution limit was reached
+    return true;
+  }
+  if(_stats._nodes >= _restart_node_limit)
+  {
+    _is_restarting = true;
+    return true;
+  }
+
+  if(PropagateConstraints() == false)
+  {
+    return false;
+  }
+
+  int branch_slot = FindBranchSlot(_is_randomized ? static_cast<int>(NextRandom() % Geometry::kSlots) : 0);
+  if(branch_slot == Geometry::kSlots)
+  {
+    // Every slot has been filled
+    if(_solution_count == 0)
+    {
+      for(int slot = 0; slot < Geometry::kSlots; ++slot)
+      {
+        _solution_values[slot] = _values[slot];
+      }
+    }
+
+    ++_solution_count;
+    return _solution_limit != 0 && _solution_count >= _solution_limit;
+  }
+
+  // Randomized runs try the values from a random one upwards, then wrap round to the lower ones
+  Mask remaining_values = _possible_values[branch_slot];
+  Mask first_values = _is_randomized ? static_cast<Mask>(~((1ull << (NextRandom() % Geometry::kSize)) - 1)) : Geometry::kAllValues;
+  while(remaining_values != 0)
+  {
+    Mask next_values = static_cast<Mask>(remaining_values & first_values);
+    int value = Utility::LowestBitIndex((next_values != 0) ? next_values : remaining_values) + 1;
+    remaining_values = static_cast<Mask>(remaining_values & ~BoardValueToMask(value));
+
+    ++_stats._guesses;
+    ++_search_depth;
+    _stats._max_depth = (static_cast<uint64_t>(_search_depth) > _stats._max_depth) ? _search_depth : _stats._max_depth;
+
+    size_t trail_mark = _trail.size();
+    if(PlaceValue(branch_slot, value) == true && Search() == true)
+    {
+      return true;
+    }
+
+    UndoTrail(trail_mark);
+    _newly_single_slots.clear();
+    --_search_depth;
+    ++_stats._backtracks;
+  }
+
+  return false;
+}
+
+template<int BoxSize>
+int BasicSudokuSolver<BoxSize>::FindBranchSlot(int first_slot) const
+{
+  // Branch on the empty slot with the fewest possible values
+  int branch_slot = Geometry::kSlots;
+  int branch_count = Geometry::kSize + 1;
+  int slot = first_slot;
+  for(int i = 0; i < Geometry::kSlots; ++i, slot = (slot + 1 < Geometry::kSlots) ? slot + 1 : 0)
+  {
+    if(_values[slot] != kEmptySlot)
+    {
+      continue;
+    }
+
+    int count = Utility::PopCount(_possible_values[slot]);
+    if(count < branch_count)
+    {
+      branch_slot = slot;
+      branch_count = count;
+      if(count == 2)
+      {
+        // Can't do any better than this
+        break;
+      }
+    }
+  }
+
+  return branch_slot;
+}
+
+template<int BoxSize>
+uint32_t BasicSudokuSolver<BoxSize>::NextRandom()
+{
+  // xorshift64, plenty for picking branches
+  _random_state ^= _random_state << 13;
+  _random_state ^= _random_state >> 7;
+  _random_state ^= _random_state << 17;
+  return static_cast<uint32_t>(_random_state >> 32);
+}
+
+template<int BoxSize>
+bool BasicSudokuSolver<BoxSize>::PropagateConstraints()
+{
+  const typename Geometry::Tables& tables = Geometry::kTables;
+
+  bool is_valid = true;
+  bool made_progress = true;
+  while(is_valid == true && made_progress == true)
+  {
+    made_progress = false;
+    ++_stats._propagation_rounds;
+
+    // Handle any slots that were left with a single possible value
+    while(is_valid == true && _newly_single_slots.empty() == false)
+    {
+      int slot = _newly_single_slots.back();
+      _newly_single_slots.pop_back();
+
+      // This slot could have been solved, or lost its last value, after it was added
+      if(_values[slot] == kEmptySlot && Utility::PopCount(_possible_values[slot]) == 1)
+      {
+        is_valid = PlaceValue(slot, Utility::LowestBitIndex(_possible_values[slot]) + 1);
+        ++_stats._naked_singles;
+      }
+    }
+
+    // Look for values that only have one place left in a unit
+    for(int unit = 0; unit < Geometry::kUnits && is_valid == true; ++unit)
+    {
+      const Index* unit_slots = tables._unit_slots[unit];
+      Mask seen_once = 0;
+      Mask seen_twice = 0;
+      for(int i = 0; i < Geometry::kSize; ++i)
+      {
+        Mask possible_values = _possible_values[unit_slots[i]];
+        seen_twice = static_cast<Mask>(seen_twice | (seen_once & possible_values));
+        seen_once = static_cast<Mask>(seen_once | possible_values);
+      }
+
+      if(static_cast<Mask>(seen_once | _unit_values[unit]) != Geometry::kAllValues)
+      {
+        // A value that isn't placed has nowhere left to go
+        is_valid = false;
+        break;
+      }
+
+      Mask hidden_singles = static_cast<Mask>(seen_once & ~seen_twice);
+      for(int i = 0; i < Geometry::kSize && hidden_singles != 0 && is_valid == true; ++i)
+      {
+        int slot = unit_slots[i];
+        Mask single_value = static_cast<Mask>(_possible_values[slot] & hidden_singles);
+        if(single_value == 0)
+        {
+          continue;
+        }
+
+        // Two hidden singles in the same slot can't both be placed
+        hidden_singles = static_cast<Mask>(hidden_singles & ~single_value);
+        is_valid = Utility::PopCount(single_value) == 1 && PlaceValue(slot, Utility::LowestBitIndex(single_value) + 1);
+        ++_stats._hidden_singles;
+        made_progress = true;
+      }
+    }
+
+    if constexpr(Geometry::kSize > kSudokuSize)
+    {
+      // Large boards have so many slots to guess on that taking locked values away first cuts the search down a long way
+      if(is_valid == true && made_progress == false)
+      {
+        is_valid = EliminateLockedValues(made_progress);
+      }
+    }
+  }
+
+  if(is_valid == false)
+  {
+    _newly_single_slots.clear();
+  }
+
+  return is_valid;
+}
+
+template<int BoxSize>
+bool BasicSudokuSolver<BoxSize>::EliminateLockedValues(bool& made_progress)
+{
+  // A segment is where a line crosses a group. Rows go first, then columns, where the slot of position i on line l is the other way round
+  Mask segments[Geometry::kSize][BoxSize];
+  size_t trail_mark = _trail.size();
+  for(int is_column = 0; is_column < 2; ++is_column)
+  {
+    int line_stride = is_column ? 1 : Geometry::kSize;
+    int position_stride = is_column ? Geometry::kSize : 1;
+    for(int line = 0; line < Geometry::kSize; ++line)
+    {
+      for(int segment = 0; segment < BoxSize; ++segment)
+      {
+        Mask values = 0;
+        for(int i = 0; i < BoxSize; ++i)
+        {
+          values = static_cast<Mask>(values | _possible_values[(line * line_stride) + (((segment * BoxSize) + i) * position_stride)]);
+        }
+        segments[line][segment] = values;
+      }
+    }
+
+    for(int line = 0; line < Geometry::kSize; ++line)
+    {
+      int first_band_line = (line / BoxSize) * BoxSize;
+      for(int segment = 0; segment < BoxSize; ++segment)
+      {
+        Mask group_others = 0;
+        Mask line_others = 0;
+        for(int i = 0; i < BoxSize; ++i)
+        {
+          group_others = static_cast<Mask>(group_others | ((first_band_line + i != line) ? segments[first_band_line + i][segment] : 0));
+          line_others = static_cast<Mask>(line_others | ((i != segment) ? segments[line][i] : 0));
+        }
+
+        // Values the group only has on this line can't go anywhere else on the line
+        Mask pointing = static_cast<Mask>(segments[line][segment] & ~group_others);
+        for(int position = 0; position < Geometry::kSize && pointing != 0; ++position)
+        {
+          if(position / BoxSize != segment && RemoveValues((line * line_stride) + (position * position_stride), pointing, kStrategyPointing) == false)
+          {
+            return false;
+          }
+        }
+
+        // Values the line only has in this group can't go anywhere else in the group
+        Mask box_line = static_cast<Mask>(segments[line][segment] & ~line_others);
+        for(int i = 0; i < BoxSize && box_line != 0; ++i)
+        {
+          for(int position = segment * BoxSize; position < (segment + 1) * BoxSize && first_band_line + i != line; ++position)
+          {
+            if(RemoveValues(((first_band_line + i) * line_stride) + (position * position_stride), box_line, kStrategyBoxLine) == false)
+            {
+              return false;
+            }
+          }
+        }
+      }
+    }
+  }
+
+  made_progress = _trail.size() > trail_mark;
+  return true;
+}
+
+template<int BoxSize>
+bool BasicSudokuSolver<BoxSize>::RemoveValues(int slot, Mask values, uint32_t strategy)
+{
+  Mask removed = static_cast<Mask>(_possible_values[slot] & values);
+  if(removed == 0)
+  {
+    return true;
+  }
+
+  _trail.push_back({ static_cast<Index>(slot), _values[slot], _possible_values[slot] });
+  _possible_values[slot] = static_cast<Mask>(_possible_values[slot] & ~removed);
+  int removed_count = Utility::PopCount(removed);
+  _stats._eliminations += removed_count;
+  _stats._strategy_eliminations[Utility::LowestBitIndex(strategy)] += removed_count;
+  if(_possible_values[slot] == 0)
+  {
+    return false;
+  }
+  if(Utility::PopCount(_possible_values[slot]) == 1)
+  {
+    _newly_single_slots.push_back(static_cast<Index>(slot));
+  }
+
+  return true;
+}
+
+template<int BoxSize>
+bool BasicSudokuSolver<BoxSize>::PlaceValue(int slot, int value)
+{
+  const typename Geometry::Tables& tables = Geometry::kTables;
+
+  _trail.push_back({ static_cast<Index>(slot), _values[slot], _possible_values[slot] });
+  _values[slot] = static_cast<int8_t>(value);
+  _possible_values[slot] = 0;
+
+  Mask mask = BoardValueToMask(value);
+  for(int i = 0; i < 3; ++i)
+  {
+    Mask& unit_values = _unit_values[tables._slot_units[slot][i]];
+    unit_values = static_cast<Mask>(unit_values | mask);
+  }
+
+  // Remove that value from every slot that shares a unit with this one
+  bool is_valid = true;
+  const Index* peers = tables._peers[slot];
+  for(int i = 0; i < Geometry::kPeerCount; ++i)
+  {
+    int peer = peers[i];
+    if((_possible_values[peer] & mask) != 0)
+    {
+      _trail.push_back({ static_cast<Index>(peer), _values[peer], _possible_values[peer] });
+      _possible_values[peer] = static_cast<Mask>(_possible_values[peer] & ~mask);
+      ++_stats._eliminations;
+      if(_possible_values[peer] == 0)
+      {
+        is_valid = false;
+      }
+      else if(Utility::PopCount(_possible_values[peer]) == 1)
+      {
+        _newly_single_slots.push_back(static_cast<Index>(peer));
+      }
+    }
+  }
+
+  return is_valid;
+}
+
+template<int BoxSize>
+void BasicSudokuSolver<BoxSize>::UndoTrail(size_t trail_mark)
+{
+  const typename Geometry::Tables& tables = Geometry::kTables;
+
+  while(_trail.size() > trail_mark)
+  {
+    const TrailEntry& entry = _trail.back();
+    if(entry._value == kEmptySlot && _values[entry._slot] != kEmptySlot)
+    {
+      // The slot was solved after this entry, so its value is no longer placed
+      Mask mask = BoardValueToMask(_values[entry._slot]);
+      for(int i = 0; i < 3; ++i)
+      {
+        Mask& unit_values = _unit_values[tables._slot_units[entry._slot][i]];
+        unit_values = static_cast<Mask>(unit_values & ~mask);
+      }
+    }
+
+    _values[entry._slot] = entry._value;
+    _possible_values[entry._slot] = entry._possible_values;
+    _trail.pop_back();
+  }
+}
+
+// Every size CreateSolver makes is compiled here, so the template's code stays out of the header. 9x9 boards go to SudokuSolver
+template class BasicSudokuSolver<2>;
+template class BasicSudokuSolver<4>;
+template class BasicSudokuSolver<5>;
+
+} // namespace Sudoku
@@ -0,0 +1,961 @@
+#include "BatchRunner.h"
+
+#include "DeductionStrategies.h"
+#include "MappedFile.h"
+#include "PerformanceScopeTimer.h"
+
+#include <chrono>
+#include <cstring>
+
+namespace Sudoku
+{
+
+// --- Constants
+#define kNoSolutionLine "No solution\n"
+#define kInvalidPuzzleLine "Invalid puzzle\n"
+#define kMultipleSolutionsLine "Multiple solutions\n"
+#define kInvalidGivensLine "Invalid givens\n"
+#define kBudgetExceededLine "Budget exceeded\n"
+
+//! How a line turned out, kept for the stats output
+#define kLineSolved 0
+#define kLineNoSolution 1
+#define kLineInvalid 2
+//! Only used when checking uniqueness
+#define kLineMultipleSolutions 3
+#define kLineInvalidGivens 4
+//! Only without a fallback engine
+#define kLineBudgetExceeded 5
+
+//! Names of the line statuses, in the order of their values
+static const char* const kLineStatusNames[] = { "solved", "no_solution", "invalid", "multiple_solutions", "invalid_givens", "budget_exceeded" };
+
+//! Returns the part of a line that's kept, the puzzle and the character after it, or 0 if the line is skipped
+static size_t GetStoredLineLength(const char* line, size_t length)
+{
+  if(length > 0 && line[length - 1] == '\r')
+  {
+    --length;
+  }
+
+  if(length == 0 || line[0] == '#')
+  {
+    return 0;
+  }
+
+  return (length < kBatchStoredLineLength) ? length : kBatchStoredLineLength;
+}
+
+//! Writes the counters after the fields before them, as CSV columns or JSON members
+static void WriteStatsFields(FILE* file, bool is_csv, const SolverStats& stats)
+{
+  if(is_csv == true)
+  {
+    std::fprintf(file, ",%llu,%llu,%llu,%llu,%llu,%llu,%llu,%llu\n", static_cast<unsigned long long>(stats._nodes), static_cast<unsigned long long>(stats._guesses),
+      static_cast<unsigned long long>(stats._backtracks), static_cast<unsigned long long>(stats._max_depth), static_cast<unsigned long long>(stats._propagation_rounds),
+      static_cast<unsigned long long>(stats._naked_singles), static_cast<unsigned long long>(stats._hidden_singles), static_cast<unsigned long long>(stats._eliminations));
+  }
+  else
+  {
+    std::fprintf(file, ",\"nodes\":%llu,\"guesses\":%llu,\"backtracks\":%llu,\"max_depth\":%llu,\"propagation_rounds\":%llu,\"naked_singles\":%llu,\"hidden_singles\":%llu,\"eliminations\":%llu}",
+      static_cast<unsigned long long>(stats._nodes), static_cast<unsigned long long>(stats._guesses), static_cast<unsigned long long>(stats._backtracks),
+      static_cast<unsigned long long>(stats._max_depth), static_cast<unsigned long long>(stats._propagation_rounds), static_cast<unsigned long long>(stats._naked_singles),
+      static_cast<unsigned long long>(stats._hidden_singles), static_cast<unsigned long long>(stats._eliminations));
+  }
+}
+
+BatchRunner::BatchRunner(const char* engine_name, int thread_count, bool pin_threads)
+  : _input_buffer(kBatchBufferSize)
+{
+  if(thread_count < 1)
+  {
+    thread_count = 1;
+  }
+
+  bool is_bit_sliced = std::strcmp(engine_name, kBitSlicedEngineName) == 0;
+  for(int i = 0; i < thread_count; ++i)
+  {
+    if(is_bit_sliced == true)
+    {
+      _bit_sliced_solvers.emplace_back(new BitSlicedSolver());
+    }
+    else
+    {
+      _solvers.push_back(CreateSolver(engine_name, kSudokuSize, thread_count));
+    }
+  }
+
+  _sized_solvers.resize(thread_count * (kMaxBoxSize - kMinBoxSize + 1));
+
+  _chunk_count = (thread_count == 1) ? 1 : thread_count * kBatchChunksPerThread;
+  _chunks.reset(new Chunk[_chunk_count]);
+  SetOutputFormat(kGridFormatCompact);
+
+  if(thread_count > 1)
+  {
+    _thread_pool.reset(new Utility::WorkStealingThreadPool<Chunk>(thread_count, _chunk_count, pin_threads, [this](int worker_index, Chunk* chunk)
+    {
+      SolveChunk(worker_index, *chunk);
+      if(chunk->_deferred_lines.empty() == false)
+      {
+        // Back of this worker's deque, so the chunks already waiting aren't held up by the fallback engine. Any other worker can steal it
+        _thread_pool->SubmitTo(worker_index, chunk);
+        return;
+      }
+
+      {
+        std::lock_guard<std::mutex> lock(_solved_mutex);
+        chunk->_is_solved = true;
+      }
+      _solved_condition.notify_one();
+    }));
+  }
+}
+
+BatchRunner::~BatchRunner()
+{
+  // Stop the workers before the chunks and solvers they use go away
+  _thread_pool.reset();
+}
+
+// --- Pubic Interface --- //
+bool BatchRunner::Run(FILE* input, FILE* output)
+{
+  StartRun(output);
+
+  char* buffer = _input_buffer.data();
+  size_t buffered = 0;
+  // Set when a line didn't fit in the buffer, the rest of it gets thrown away
+  bool is_skipping_line = false;
+  bool is_end_of_input = false;
+  while(is_end_of_input == false)
+  {
+    size_t read_count = 0;
+    {
+      TimePerformanceScope("ReadInput");
+      read_count = std::fread(buffer + buffered, 1, kBatchBufferSize - buffered, input);
+    }
+    buffered += read_count;
+    is_end_of_input = (read_count == 0);
+
+    size_t line_start = 0;
+    while(line_start < buffered)
+    {
+      const char* line_end = static_cast<const char*>(std::memchr(buffer + line_start, '\n', buffered - line_start));
+      if(line_end == nullptr)
+      {
+        break;
+      }
+
+      size_t length = static_cast<size_t>(line_end - (buffer + line_start));
+      if(is_skipping_line == false)
+      {
+        AddLine(buffer + line_start, length);
+      }
+      is_skipping_line = false;
+      line_start += length + 1;
+    }
+
+    if(is_end_of_input == true)
+    {
+      // The last line may not end with a newline
+      if(line_start < buffered && is_skipping_line == false)
+      {
+        AddLine(buffer + line_start, buffered - line_start);
+      }
+      break;
+    }
+
+    // Move the partial line to the front so the next read completes it
+    buffered -= line_start;
+    std::memmove(buffer, buffer + line_start, buffered);
+
+    if(buffered == kBatchBufferSize)
+    {
+      // Nothing sensible is this long, only the start is needed to reject it
+      if(is_skipping_line == false)
+      {
+        AddLine(buffer, buffered);
+      }
+      is_skipping_line = true;
+      buffered = 0;
+    }
+  }
+
+  return FinishRun();
+}
+
+bool BatchRunner::Run(const char* data, size_t size, FILE* output)
+{
+  StartRun(output);
+
+  if(BinaryPuzzleFile::ReadHeader(data, size, _binary_header) == true)
+  {
+    // Records are fixed size, so ranges are cut at every kBatchChunkLines of them. A partly written last record still gets a line, written as "Invalid puzzle"
+    _is_binary_input = true;
+    size_t records_size = size - kBinaryPuzzleHeaderSize;
+    size_t record_count = (records_size + _binary_header._record_size - 1) / _binary_header._record_size;
+    const char* records = data + kBinaryPuzzleHeaderSize;
+    for(size_t record = 0; record < record_count; record += kBatchChunkLines)
+    {
+      size_t range_records = (record_count - record < kBatchChunkLines) ? record_count - record : kBatchChunkLines;
+      size_t range_size = range_records * _binary_header._record_size;
+      size_t range_offset = record * _binary_header._record_size;
+      _current_chunk->_range_begin = records + range_offset;
+      _current_chunk->_range_end = _current_chunk->_range_begin + ((range_size < records_size - range_offset) ? range_size : records_size - range_offset);
+      SubmitChunk();
+    }
+
+    return FinishRun();
+  }
+
+  // Ranges are cut at the first line start past a chunk's worth of bytes, only the bytes up to the next newline are looked at here
+  size_t range_begin = 0;
+  while(range_begin < size)
+  {
+    size_t range_end = Utility::MappedFile::FindLineStart(data, size, range_begin + kBatchChunkDataSize);
+    _current_chunk->_range_begin = data + range_begin;
+    _current_chunk->_range_end = data + range_end;
+    SubmitChunk();
+    range_begin = range_end;
+  }
+
+  return FinishRun();
+}
+
+void BatchRunner::SetStatsOutput(FILE* stats_output, bool is_csv)
+{
+  _stats_output = stats_output;
+  _is_stats_csv = is_csv;
+}
+
+void BatchRunner::SetCheckingUniqueness(bool is_checking_uniqueness)
+{
+  _is_checking_uniqueness = is_checking_uniqueness;
+  for(std::unique_ptr<BitSlicedSolver>& solver : _bit_sliced_solvers)
+  {
+    solver->SetCheckingUniqueness(is_checking_uniqueness);
+  }
+}
+
+void BatchRunner::SetSolutionCacheSize(size_t entry_count)
+{
+  _solution_cache.reset();
+  _canonicalizers.clear();
+  if(entry_count == 0 || _solvers.empty() == true)
+  {
+    return;
+  }
+
+  _solution_cache.reset(new SolutionCache(entry_count));
+  for(size_t i = 0; i < _solvers.size(); ++i)
+  {
+    _canonicalizers.emplace_back(new PuzzleCanonicalizer());
+  }
+}
+
+void BatchRunner::SetSolveBudget(uint64_t node_limit, uint64_t time_limit, const char* fallback_engine_name)
+{
+  _node_budget = node_limit;
+  _time_budget = time_limit;
+  for(std::unique_ptr<ISudokuSolver>& solver : _solvers)
+  {
+    solver->SetBudget(node_limit, time_limit);
+  }
+  for(std::unique_ptr<ISudokuSolver>& solver : _sized_solvers)
+  {
+    if(solver != nullptr)
+    {
+      solver->SetBudget(node_limit, time_limit);
+    }
+  }
+
+  _fallback_solvers.clear();
+  if(fallback_engine_name == nullptr || (node_limit == 0 && time_limit == 0))
+  {
+    return;
+  }
+
+  for(size_t i = 0; i < _solvers.size(); ++i)
+  {
+    _fallback_solvers.push_back(CreateSolver(fallback_engine_name, kSudokuSize, static_cast<int>(_solvers.size())));
+  }
+}
+
+void BatchRunner::SetOutputFormat(int output_format)
+{
+  _output_format = output_format;
+
+  size_t output_size = (output_format == kGridFormatBoxed) ? kBatchChunkBoxedOutputSize : kBatchChunkOutputSize;
+  for(int i = 0; i < _chunk_count; ++i)
+  {
+    _chunks[i]._output.resize(output_size);
+  }
+}
+
+// --- Private Interface --- //
+BatchRunner::Chunk::Chunk()
+  : _line_starts(kBatchChunkLines)
+  , _line_lengths(kBatchChunkLines)
+  , _line_status(kBatchChunkLines)
+  , _line_stats(kBatchChunkLines)
+{
+}
+
+void BatchRunner::StartRun(FILE* output)
+{
+  _results = BatchResults();
+  _output = output;
+  _output_failed = false;
+  _next_sequence = 0;
+  _next_write_sequence = 0;
+  _current_chunk = &_chunks[0];
+  _current_chunk->_line_count = 0;
+  _current_chunk->_line_data_size = 0;
+  _current_chunk->_range_begin = nullptr;
+  _stats_line_count = 0;
+  _is_binary_input = false;
+
+  if(_stats_output != nullptr)
+  {
+    if(_is_stats_csv == true)
+    {
+      std::fprintf(_stats_output, "line,status,nodes,guesses,backtracks,max_depth,propagation_rounds,naked_singles,hidden_singles,eliminations\n");
+    }
+    else
+    {
+      std::fprintf(_stats_output, "{\"lines\":[");
+    }
+  }
+
+  _start_time = std::chrono::steady_clock::now();
+}
+
+bool BatchRunner::FinishRun()
+{
+  if(_current_chunk->_line_count > 0)
+  {
+    SubmitChunk();
+  }
+  WriteSolvedChunks(0);
+
+  std::fflush(_output);
+
+  std::chrono::steady_clock::time_point end_time = std::chrono::steady_clock::now();
+  _results._elapsed_seconds = std::chrono::duration<double>(end_time - _start_time).count();
+
+  if(_stats_output != nullptr)
+  {
+    if(_is_stats_csv == true)
+    {
+      // The totals have no status of their own
+      std::fprintf(_stats_output, "total,");
+    }
+    else
+    {
+      std::fprintf(_stats_output, "\n],\"total\":{\"puzzles\":%llu,\"solved\":%llu,\"invalid\":%llu,\"skipped\":%llu,\"multiple_solutions\":%llu,\"invalid_givens\":%llu",
+        static_cast<unsigned long long>(_results._puzzle_count), static_cast<unsigned long long>(_results._solved_count), static_cast<unsigned long long>(_results._invalid_count),
+        static_cast<unsigned long long>(_results._skipped_count), static_cast<unsigned long long>(_results._multiple_solution_count),
+        static_cast<unsigned long long>(_results._invalid_givens_count));
+      std::fprintf(_stats_output, ",\"cache_lookups\":%llu,\"cache_hits\":%llu,\"cache_hit_rate\":%.4f", static_cast<unsigned long long>(_results._cache_lookup_count),
+        static_cast<unsigned long long>(_results._cache_hit_count), (_results._cache_lookup_count > 0) ? static_cast<double>(_results._cache_hit_count) / _results._cache_lookup_count : 0.0);
+      std::fprintf(_stats_output, ",\"fallbacks\":%llu,\"budget_exceeded\":%llu", static_cast<unsigned long long>(_results._fallback_count),
+        static_cast<unsigned long long>(_results._budget_exceeded_count));
+
+      // Values each deduction strategy took away, in pipeline order
+      std::fprintf(_stats_output, ",\"strategy_eliminations\":{");
+      for(int index = 0; index < kDeductionStrategyCount; ++index)
+      {
+        std::fprintf(_stats_output, "%s\"%s\":%llu", (index > 0) ? "," : "", GetDeductionStrategy(index)._name, static_cast<unsigned long long>(_results._stats._strategy_eliminations[index]));
+      }
+      std::fprintf(_stats_output, "}");
+    }
+    WriteStatsFields(_stats_output, _is_stats_csv, _results._stats);
+    if(_is_stats_csv == false)
+    {
+      std::fprintf(_stats_output, "}\n");
+    }
+    std::fflush(_stats_output);
+  }
+
+  return _output_failed == false;
+}
+
+void BatchRunner::AddLine(const char* line, size_t length)
+{
+  size_t stored_length = GetStoredLineLength(line, length);
+  if(stored_length == 0)
+  {
+    ++_results._skipped_count;
+    return;
+  }
+
+  if(_current_chunk->_line_data_size + stored_length > kBatchChunkDataSize)
+  {
+    SubmitChunk();
+  }
+
+  Chunk& chunk = *_current_chunk;
+  std::memcpy(chunk._line_data + chunk._line_data_size, line, stored_length);
+  chunk._line_starts[chunk._line_count] = chunk._line_data + chunk._line_data_size;
+  chunk._line_lengths[chunk._line_count] = static_cast<uint16_t>(stored_length);
+  chunk._line_data_size += stored_length;
+  ++chunk._line_count;
+
+  if(chunk._line_count == kBatchChunkLines)
+  {
+    SubmitChunk();
+  }
+}
+
+void BatchRunner::SplitRange(Chunk& chunk)
+{
+  TimePerformanceScope("SplitRange");
+
+  if(_is_binary_input == true)
+  {
+    // A range never holds more than kBatchChunkLines records. The output is bounded by the length of the records written as text
+    size_t text_length = static_cast<size_t>(_binary_header._size * _binary_header._size) + 1;
+    for(const char* record = chunk._range_begin; record < chunk._range_end; record += _binary_header._record_size)
+    {
+      // Only the last record of a file cut short is shorter, see GetLineSize
+      size_t record_length = static_cast<size_t>(chunk._range_end - record);
+      chunk._line_starts[chunk._line_count] = record;
+      chunk._line_lengths[chunk._line_count] = static_cast<uint16_t>((record_length < _binary_header._record_size) ? record_length : _binary_header._record_size);
+      chunk._line_data_size += text_length;
+      ++chunk._line_count;
+    }
+    chunk._range_end = chunk._range_begin;
+  }
+
+  const char* line = chunk._range_begin;
+  while(line < chunk._range_end)
+  {
+    const char* line_end = static_cast<const char*>(std::memchr(line, '\n', static_cast<size_t>(chunk._range_end - line)));
+    if(line_end == nullptr)
+    {
+      // The last line of the input may not end with a newline
+      line_end = chunk._range_end;
+    }
+
+    size_t stored_length = GetStoredLineLength(line, static_cast<size_t>(line_end - line));
+    if(stored_length > 0)
+    {
+      if(chunk._line_count == static_cast<int>(chunk._line_starts.size()))
+      {
+        // Only a range of unusually short lines gets here, and the chunk keeps the room for later runs
+        chunk._line_starts.resize(chunk._line_starts.size() * 2);
+        chunk._line_lengths.resize(chunk._line_starts.size());
+      }
+
+      chunk._line_starts[chunk._line_count] = line;
+      chunk._line_lengths[chunk._line_count] = static_cast<uint16_t>(stored_length);
+      chunk._line_data_size += stored_length;
+      ++chunk._line_count;
+    }
+    else
+    {
+      ++chunk._results._skipped_count;
+    }
+
+    line = line_end + 1;
+  }
+  chunk._range_begin = nullptr;
+
+  if(chunk._line_status.size() < chunk._line_starts.size())
+  {
+    chunk._line_status.resize(chunk._line_starts.size());
+    chunk._line_stats.resize(chunk._line_starts.size());
+  }
+
+  // Same bounds the fixed output sizes are worked out from
+  size_t output_size = (_output_format == kGridFormatBoxed) ? (chunk._line_data_size * 5) + (chunk._line_count * 17) : chunk._line_data_size + (chunk._line_count * 16);
+  if(chunk._output.size() < output_size)
+  {
+    chunk._output.resize(output_size);
+  }
+}
+
+int BatchRunner::GetLineSize(const Chunk& chunk, int line) const
+{
+  if(_is_binary_input == true)
+  {
+    // A record that was cut short isn't a puzzle
+    return (chunk._line_lengths[line] == _binary_header._record_size) ? _binary_header._size : 0;
+  }
+
+  return GetPuzzleLineSize(chunk._line_starts[line], chunk._line_lengths[line]);
+}
+
+bool BatchRunner::ParseLine(const Chunk& chunk, int line, int size, int* values) const
+{
+  if(_is_binary_input == true)
+  {
+    return BinaryPuzzleFile::UnpackValues(reinterpret_cast<const uint8_t*>(chunk._line_starts[line]), size, _binary_header._bits_per_slot, values);
+  }
+
+  return ParsePuzzleLine(chunk._line_starts[line], size, values);
+}
+
+void BatchRunner::SubmitChunk()
+{
+  Chunk* chunk = _current_chunk;
+  chunk->_output_size = 0;
+  chunk->_results = BatchResults();
+  chunk->_is_solved = false;
+
+  if(_thread_pool == nullptr)
+  {
+    SolveChunk(0, *chunk);
+    if(chunk->_deferred_lines.empty() == false)
+    {
+      SolveChunk(0, *chunk);
+    }
+    chunk->_is_solved = true;
+  }
+  else
+  {
+    _thread_pool->Submit(chunk);
+  }
+
+  // The next chunk reuses the slot of the chunk _chunk_count before it, which has to be written out first
+  ++_next_sequence;
+  WriteSolvedChunks(_chunk_count - 1);
+
+  _current_chunk = &_chunks[_next_sequence % _chunk_count];
+  _current_chunk->_line_count = 0;
+  _current_chunk->_line_data_size = 0;
+  _current_chunk->_range_begin = nullptr;
+}
+
+void BatchRunner::SolveChunk(int worker_index, Chunk& chunk)
+{
+  if(chunk._deferred_lines.empty() == false)
+  {
+    // Back for the puzzles that ran out of budget
+    SolveDeferredLines(worker_index, chunk);
+    return;
+  }
+
+  TimePerformanceScope("SolveChunk");
+
+  if(chunk._range_begin != nullptr)
+  {
+    SplitRange(chunk);
+  }
+
+  if(_bit_sliced_solvers.empty() == false)
+  {
+    SolveChunk(worker_index, *_bit_sliced_solvers[worker_index], chunk);
+  }
+  else
+  {
+    SolveChunk(worker_index, *_solvers[worker_index], chunk);
+  }
+}
+
+void BatchRunner::SolveChunk(int worker_index, ISudokuSolver& solver, Chunk& chunk)
+{
+  int values[kPuzzleLineLength];
+
+  for(int line = 0; line < chunk._line_count; ++line)
+  {
+    int size = GetLineSize(chunk, line);
+    if(size != kSudokuSize)
+    {
+      SolveLine(worker_index, chunk, line, size);
+      continue;
+    }
+
+    if(ParseLine(chunk, line, size, values) == false)
+    {
+      RecordLine(chunk, line, kLineInvalid, SolverStats());
+      WriteOutput(chunk, kInvalidPuzzleLine, sizeof(kInvalidPuzzleLine) - 1);
+      continue;
+    }
+
+    SolvePuzzle(worker_index, solver, chunk, line, values);
+  }
+}
+
+void BatchRunner::SolveChunk(int worker_index, BitSlicedSolver& solver, Chunk& chunk)
+{
+  int values[kBitSlicedLanes][kSudokuSize][kSudokuSize];
+
+  int line = 0;
+  while(line < chunk._line_count)
+  {
+    // Fill every lane with the next puzzles, skipping over lines that aren't puzzles and stopping at any other size of board
+    int first_line = line;
+    int puzzle_count = 0;
+    for(; line < chunk._line_count && puzzle_count < kBitSlicedLanes; ++line)
+    {
+      int size = GetLineSize(chunk, line);
+      if(size != kSudokuSize && size != 0)
+      {
+        break;
+      }
+
+      // Marks the lines that aren't puzzles until their results are recorded below
+      bool is_puzzle = size != 0 && ParseLine(chunk, line, size, &values[puzzle_count][0][0]) == true;
+      chunk._line_status[line] = is_puzzle ? kLineSolved : kLineInvalid;
+      if(is_puzzle == true && _is_checking_uniqueness == true && HasValidGivens(&values[puzzle_count][0][0], kSudokuSize) == false)
+      {
+        chunk._line_status[line] = kLineInvalidGivens;
+        is_puzzle = false;
+      }
+      if(is_puzzle == true)
+      {
+        ++puzzle_count;
+      }
+    }
+
+    uint32_t solved_puzzles = (puzzle_count > 0) ? solver.SolvePuzzles(puzzle_count, values) : 0;
+
+    int puzzle = 0;
+    for(int group_line = first_line; group_line < line; ++group_line)
+    {
+      if(chunk._line_status[group_line] == kLineInvalid)
+      {
+        RecordLine(chunk, group_line, kLineInvalid, SolverStats());
+        WriteOutput(chunk, kInvalidPuzzleLine, sizeof(kInvalidPuzzleLine) - 1);
+        continue;
+      }
+      if(chunk._line_status[group_line] == kLineInvalidGivens)
+      {
+        RecordLine(chunk, group_line, kLineInvalidGivens, SolverStats());
+        WriteOutput(chunk, kInvalidGivensLine, sizeof(kInvalidGivensLine) - 1);
+        continue;
+      }
+
+      if((solved_puzzles & (1u << puzzle)) == 0)
+      {
+        RecordLine(chunk, group_line, kLineNoSolution, solver.GetLaneStats(puzzle));
+        WriteOutput(chunk, kNoSolutionLine, sizeof(kNoSolutionLine) - 1);
+      }
+      else if((solver.GetMultipleSolutionPuzzles() & (1u << puzzle)) != 0)
+      {
+        RecordLine(chunk, group_line, kLineMultipleSolutions, solver.GetLaneStats(puzzle));
+        WriteOutput(chunk, kMultipleSolutionsLine, sizeof(kMultipleSolutionsLine) - 1);
+      }
+      else
+      {
+        RecordLine(chunk, group_line, kLineSolved, solver.GetLaneStats(puzzle));
+        WriteSolution(chunk, &values[puzzle][0][0], kSudokuSize);
+      }
+      ++puzzle;
+    }
+
+    if(line < chunk._line_count && line == first_line)
+    {
+      // The group stopped at a board of another size, which is solved on its own
+      SolveLine(worker_index, chunk, line, GetLineSize(chunk, line));
+      ++line;
+    }
+  }
+}
+
+void BatchRunner::SolveDeferredLines(int worker_index, Chunk& chunk)
+{
+  TimePerformanceScope("SolveDeferredLines");
+
+  // The output so far moves to the spare buffer, and is copied back a piece at a time between the results of the deferred lines
+  if(chunk._spliced_output.size() < chunk._output.size())
+  {
+    chunk._spliced_output.resize(chunk._output.size());
+  }
+  chunk._output.swap(chunk._spliced_output);
+  const char* skipped_output = chunk._spliced_output.data();
+  size_t skipped_size = chunk._output_size;
+  size_t copied_size = 0;
+  chunk._output_size = 0;
+
+  int values[kMaxPuzzleLineLength];
+  for(const DeferredLine& deferred : chunk._deferred_lines)
+  {
+    std::memcpy(chunk._output.data() + chunk._output_size, skipped_output + copied_size, deferred._output_offset - copied_size);
+    chunk._output_size += deferred._output_offset - copied_size;
+    copied_size = deferred._output_offset;
+
+    // The line parsed the first time round
+    int size = GetLineSize(chunk, deferred._line);
+    ParseLine(chunk, deferred._line, size, values);
+    ++chunk._results._fallback_count;
+    if(size == kSudokuSize)
+    {
+      SolvePuzzle(worker_index, *_fallback_solvers[worker_index], chunk, deferred._line, values);
+    }
+    else
+    {
+      // Only the backtracking engine solves the other sizes, so it goes again without the budget
+      ISudokuSolver& solver = GetSizedSolver(worker_index, size);
+      solver.SetBudget(0, 0);
+      SolvePuzzle(worker_index, solver, chunk, deferred._line, values);
+      solver.SetBudget(_node_budget, _time_budget);
+    }
+  }
+
+  std::memcpy(chunk._output.data() + chunk._output_size, skipped_output + copied_size, skipped_size - copied_size);
+  chunk._output_size += skipped_size - copied_size;
+  chunk._deferred_lines.clear();
+}
+
+void BatchRunner::SolveLine(int worker_index, Chunk& chunk, int line, int size)
+{
+  int values[kMaxPuzzleLineLength];
+  if(size == 0 || ParseLine(chunk, line, size, values) == false)
+  {
+    RecordLine(chunk, line, kLineInvalid, SolverStats());
+    WriteOutput(chunk, kInvalidPuzzleLine, sizeof(kInvalidPuzzleLine) - 1);
+    return;
+  }
+
+  SolvePuzzle(worker_index, GetSizedSolver(worker_index, size), chunk, line, values);
+}
+
+void BatchRunner::SolvePuzzle(int worker_index, ISudokuSolver& solver, Chunk& chunk, int line, const int* values)
+{
+  int size = solver.GetSize();
+  if(_is_checking_uniqueness == true && HasValidGivens(values, size) == false)
+  {
+    RecordLine(chunk, line, kLineInvalidGivens, SolverStats());
+    WriteOutput(chunk, kInvalidGivensLine, sizeof(kInvalidGivensLine) - 1);
+    return;
+  }
+
+  // Puzzles too regular to canonicalize are solved without the cache
+  CanonicalPuzzle canonical_puzzle;
+  bool is_cacheable = size == kSudokuSize && _solution_cache != nullptr && _canonicalizers[worker_index]->Canonicalize(values, canonical_puzzle) == true;
+  if(is_cacheable == true)
+  {
+    ++chunk._results._cache_lookup_count;
+    if(SolveFromCache(chunk, line, canonical_puzzle) == true)
+    {
+      ++chunk._results._cache_hit_count;
+      return;
+    }
+  }
+
+  // Uniqueness only needs the search to go on until it finds a second solution
+  solver.LoadPuzzleValues(values);
+  int status = solver.SolveWithStatus(_is_checking_uniqueness);
+  if(status == kSolveBudgetExceeded)
+  {
+    // Nothing is cached, a puzzle that runs out of budget says nothing about its solutions
+    if(_fallback_solvers.empty() == false)
+    {
+      // The nodes searched still count towards the totals, and the fallback engine looks the puzzle up again
+      chunk._deferred_lines.push_back(DeferredLine{ line, chunk._output_size });
+      chunk._results._stats.Add(solver.GetStats());
+      chunk._results._cache_lookup_count -= is_cacheable ? 1 : 0;
+      return;
+    }
+
+    RecordLine(chunk, line, kLineBudgetExceeded, solver.GetStats());
+    WriteOutput(chunk, kBudgetExceededLine, sizeof(kBudgetExceededLine) - 1);
+    return;
+  }
+  if(status == kSolveUnsolvable)
+  {
+    if(is_cacheable == true)
+    {
+      _solution_cache->Insert(canonical_puzzle, kCachedNoSolution, nullptr);
+    }
+    RecordLine(chunk, line, kLineNoSolution, solver.GetStats());
+    WriteOutput(chunk, kNoSolutionLine, sizeof(kNoSolutionLine) - 1);
+    return;
+  }
+  if(status == kSolveMultipleSolutions)
+  {
+    if(is_cacheable == true)
+    {
+      _solution_cache->Insert(canonical_puzzle, kCachedMultipleSolutions, nullptr);
+    }
+    RecordLine(chunk, line, kLineMultipleSolutions, solver.GetStats());
+    WriteOutput(chunk, kMultipleSolutionsLine, sizeof(kMultipleSolutionsLine) - 1);
+    return;
+  }
+
+  RecordLine(chunk, line, kLineSolved, solver.GetStats());
+  int solution[kMaxPuzzleLineLength];
+  for(int index = 0; index < size * size; ++index)
+  {
+    solution[index] = solver.GetValue(index / size, index % size);
+  }
+  if(is_cacheable == true)
+  {
+    uint8_t canonical_solution[kCanonicalSlots];
+    PuzzleCanonicalizer::ToCanonical(canonical_puzzle._transform, solution, canonical_solution);
+    _solution_cache->Insert(canonical_puzzle, _is_checking_uniqueness ? kCachedUniqueSolution : kCachedSolution, canonical_solution);
+  }
+  WriteSolution(chunk, solution, size);
+}
+
+bool BatchRunner::SolveFromCache(Chunk& chunk, int line, const CanonicalPuzzle& puzzle)
+{
+  uint8_t status = 0;
+  uint8_t canonical_solution[kCanonicalSlots];
+  if(_solution_cache->Find(puzzle, status, canonical_solution) == false)
+  {
+    return false;
+  }
+
+  // A solution found without checking uniqueness can't say there's only one, and more than one solution doesn't give one to write
+  if(status == (_is_checking_uniqueness ? kCachedSolution : kCachedMultipleSolutions))
+  {
+    return false;
+  }
+
+  if(status == kCachedNoSolution)
+  {
+    RecordLine(chunk, line, kLineNoSolution, SolverStats());
+    WriteOutput(chunk, kNoSolutionLine, sizeof(kNoSolutionLine) - 1);
+  }
+  else if(status == kCachedMultipleSolutions)
+  {
+    RecordLine(chunk, line, kLineMultipleSolutions, SolverStats());
+    WriteOutput(chunk, kMultipleSolutionsLine, sizeof(kMultipleSolutionsLine) - 1);
+  }
+  else
+  {
+    RecordLine(chunk, line, kLineSolved, SolverStats());
+    int solution[kCanonicalSlots];
+    PuzzleCanonicalizer::FromCanonical(puzzle._transform, canonical_solution, solution);
+    WriteSolution(chunk, solution, kSudokuSize);
+  }
+
+  return true;
+}
+
+void BatchRunner::RecordLine(Chunk& chunk, int line, uint8_t status, const SolverStats& stats)
+{
+  if(status == kLineInvalid)
+  {
+    ++chunk._results._invalid_count;
+  }
+  else
+  {
+    ++chunk._results._puzzle_count;
+    chunk._results._solved_count += (status == kLineSolved) ? 1 : 0;
+    chunk._results._multiple_solution_count += (status == kLineMultipleSolutions) ? 1 : 0;
+    chunk._results._invalid_givens_count += (status == kLineInvalidGivens) ? 1 : 0;
+    chunk._results._budget_exceeded_count += (status == kLineBudgetExceeded) ? 1 : 0;
+  }
+  chunk._results._stats.Add(stats);
+
+  chunk._line_status[line] = status;
+  chunk._line_stats[line] = stats;
+}
+
+ISudokuSolver& BatchRunner::GetSizedSolver(int worker_index, int size)
+{
+  int box_size = kMinBoxSize;
+  while(box_size * box_size < size)
+  {
+    ++box_size;
+  }
+
+  std::unique_ptr<ISudokuSolver>& solver = _sized_solvers[(worker_index * (kMaxBoxSize - kMinBoxSize + 1)) + (box_size - kMinBoxSize)];
+  if(solver == nullptr)
+  {
+    solver = CreateSolver(kBacktrackingEngineName, size);
+    solver->SetBudget(_node_budget, _time_budget);
+  }
+
+  return *solver;
+}
+
+void BatchRunner::WriteSolution(Chunk& chunk, const int* values, int size)
+{
+  if(_output_format == kGridFormatNone)
+  {
+    return;
+  }
+
+  // Rendered straight into the chunk's output
+  chunk._output_size += GridRenderer::Render(_output_format, values, size, chunk._output.data() + chunk._output_size);
+  if(_output_format == kGridFormatBoxed)
+  {
+    chunk._output[chunk._output_size++] = '\n';
+  }
+}
+
+void BatchRunner::WriteOutput(Chunk& chunk, const char* data, size_t length)
+{
+  if(_output_format == kGridFormatNone)
+  {
+    return;
+  }
+
+  std::memcpy(chunk._output.data() + chunk._output_size, data, length);
+  chunk._output_size += length;
+  if(_output_format == kGridFormatBoxed)
+  {
+    chunk._output[chunk._output_size++] = '\n';
+  }
+}
+
+void BatchRunner::WriteSolvedChunks(uint64_t max_in_flight)
+{
+  while(_next_write_sequence < _next_sequence)
+  {
+    Chunk& chunk = _chunks[_next_write_sequence % _chunk_count];
+    bool must_wait = (_next_sequence - _next_write_sequence) > max_in_flight;
+    if(chunk._is_solved == false)
+    {
+      if(must_wait == false)
+      {
+        return;
+      }
+
+      TimePerformanceScope("WaitForChunk");
+      std::unique_lock<std::mutex> lock(_solved_mutex);
+      _solved_condition.wait(lock, [&chunk]() { return chunk._is_solved == true; });
+    }
+
+    TimePerformanceScope("WriteOutput");
+    if(chunk._output_size > 0 && std::fwrite(chunk._output.data(), 1, chunk._output_size, _output) != chunk._output_size)
+    {
+      _output_failed = true;
+    }
+
+    _results._puzzle_count += chunk._results._puzzle_count;
+    _results._solved_count += chunk._results._solved_count;
+    _results._invalid_count += chunk._results._invalid_count;
+    _results._skipped_count += chunk._results._skipped_count;
+    _results._multiple_solution_count += chunk._results._multiple_solution_count;
+    _results._invalid_givens_count += chunk._results._invalid_givens_count;
+    _results._cache_lookup_count += chunk._results._cache_lookup_count;
+    _results._cache_hit_count += chunk._results._cache_hit_count;
+    _results._fallback_count += chunk._results._fallback_count;
+    _results._budget_exceeded_count += chunk._results._budget_exceeded_count;
+    _results._stats.Add(chunk._results._stats);
+
+    if(_stats_output != nullptr)
+    {
+      WriteLineStats(chunk);
+    }
+    ++_next_write_sequence;
+  }
+}
+
+void BatchRunner::WriteLineStats(const Chunk& chunk)
+{
+  // Lines are numbered the same as the lines of solutions
+  for(int line = 0; line < chunk._line_count; ++line)
+  {
+    ++_stats_line_count;
+    if(_is_stats_csv == true)
+    {
+      std::fprintf(_stats_output, "%llu,%s", static_cast<unsigned long long>(_stats_line_count), kLineStatusNames[chunk._line_status[line]]);
+    }
+    else
+    {
+      std::fprintf(_stats_output, "%s\n{\"line\":%llu,\"status\":\"%s\"", (_stats_line_count == 1) ? "" : ",", static_cast<unsigned long long>(_stats_line_count),
+        kLineStatusNames[chunk._line_status[line]]);
+    }
+    WriteStatsFields(_stats_output, _is_stats_csv, chunk._line_stats[line]);
+  }
+}
+
+} // namespace Sudoku
@@ -0,0 +1,252 @@
+#include "BinaryPuzzleFile.h"
+
+#include "BatchRunner.h"
+
+#include <cstring>
+#include <vector>
+
+namespace Sudoku
+{
+
+// --- Constants
+//! Largest board that packs into 4 bits a slot
+#define kMaxNibbleSize 15
+
+// --- Pubic Interface --- //
+BinaryPuzzleHeader BinaryPuzzleFile::MakeHeader(int size, bool has_solutions)
+{
+  BinaryPuzzleHeader header;
+  header._size = size;
+  header._bits_per_slot = (size <= kMaxNibbleSize) ? 4 : 5;
+  header._has_solutions = has_solutions;
+  header._record_size = GetPackedSize(size, header._bits_per_slot) * (has_solutions ? 2 : 1);
+  return header;
+}
+
+bool BinaryPuzzleFile::ReadHeader(const char* data, size_t data_size, BinaryPuzzleHeader& header)
+{
+  if(data_size < kBinaryPuzzleHeaderSize || std::memcmp(data, kBinaryPuzzleMagic, 4) != 0)
+  {
+    return false;
+  }
+
+  const uint8_t* bytes = reinterpret_cast<const uint8_t*>(data);
+  if(bytes[4] != kBinaryPuzzleVersion)
+  {
+    return false;
+  }
+
+  int size = bytes[5];
+  if(size != 4 && size != 9 && size != 16 && size != 25)
+  {
+    return false;
+  }
+
+  header = MakeHeader(size, (bytes[7] & kBinaryPuzzleHasSolutions) != 0);
+  size_t record_size = static_cast<size_t>(bytes[8]) | (static_cast<size_t>(bytes[9]) << 8) | (static_cast<size_t>(bytes[10]) << 16) | (static_cast<size_t>(bytes[11]) << 24);
+  return bytes[6] == header._bits_per_slot && record_size == header._record_size;
+}
+
+void BinaryPuzzleFile::WriteHeader(const BinaryPuzzleHeader& header, uint8_t bytes[kBinaryPuzzleHeaderSize])
+{
+  std::memset(bytes, 0, kBinaryPuzzleHeaderSize);
+  std::memcpy(bytes, kBinaryPuzzleMagic, 4);
+  bytes[4] = kBinaryPuzzleVersion;
+  bytes[5] = static_cast<uint8_t>(header._size);
+  bytes[6] = static_cast<uint8_t>(header._bits_per_slot);
+  bytes[7] = header._has_solutions ? kBinaryPuzzleHasSolutions : 0;
+  for(int i = 0; i < 4; ++i)
+  {
+    bytes[8 + i] = static_cast<uint8_t>(header._record_size >> (i * 8));
+  }
+}
+
+size_t BinaryPuzzleFile::GetPackedSize(int size, int bits_per_slot)
+{
+  return ((static_cast<size_t>(size * size) * bits_per_slot) + 7) / 8;
+}
+
+void BinaryPuzzleFile::PackValues(const int* values, int size, int bits_per_slot, uint8_t* packed)
+{
+  int slot_count = size * size;
+  std::memset(packed, 0, GetPackedSize(size, bits_per_slot));
+
+  // Slots fill each byte from its lowest bit up
+  for(int slot = 0; slot < slot_count; ++slot)
+  {
+    uint32_t value = (values[slot] > 0) ? static_cast<uint32_t>(values[slot]) : 0;
+    int bit = slot * bits_per_slot;
+    uint32_t shifted = value << (bit & 7);
+    packed[bit >> 3] = static_cast<uint8_t>(packed[bit >> 3] | shifted);
+    if((bit & 7) + bits_per_slot > 8)
+    {
+      packed[(bit >> 3) + 1] = static_cast<uint8_t>(packed[(bit >> 3) + 1] | (shifted >> 8));
+    }
+  }
+}
+
+bool BinaryPuzzleFile::UnpackValues(const uint8_t* packed, int size, int bits_per_slot, int* values)
+{
+  int slot_count = size * size;
+  uint32_t is_too_large = 0;
+  if(bits_per_slot == 4)
+  {
+    // Two slots a byte, the common case
+    for(int slot = 0; slot + 1 < slot_count; slot += 2)
+    {
+      uint32_t low = packed[slot >> 1] & 0x0F;
+      uint32_t high = packed[slot >> 1] >> 4;
+      values[slot] = (low != 0) ? static_cast<int>(low) : kEmptySlot;
+      values[slot + 1] = (high != 0) ? static_cast<int>(high) : kEmptySlot;
+      is_too_large |= (low > static_cast<uint32_t>(size)) | (high > static_cast<uint32_t>(size));
+    }
+    if((slot_count & 1) != 0)
+    {
+      uint32_t low = packed[slot_count >> 1] & 0x0F;
+      values[slot_count - 1] = (low != 0) ? static_cast<int>(low) : kEmptySlot;
+      is_too_large |= low > static_cast<uint32_t>(size);
+    }
+
+    return is_too_large == 0;
+  }
+
+  uint32_t mask = (1u << bits_per_slot) - 1;
+  for(int slot = 0; slot < slot_count; ++slot)
+  {
+    int bit = slot * bits_per_slot;
+    uint32_t bits = packed[bit >> 3];
+    if((bit & 7) + bits_per_slot > 8)
+    {
+      bits |= static_cast<uint32_t>(packed[(bit >> 3) + 1]) << 8;
+    }
+
+    uint32_t value = (bits >> (bit & 7)) & mask;
+    values[slot] = (value != 0) ? static_cast<int>(value) : kEmptySlot;
+    is_too_large |= value > static_cast<uint32_t>(size);
+  }
+
+  return is_too_large == 0;
+}
+
+bool BinaryPuzzleFile::ConvertTextToBinary(const char* data, size_t data_size, FILE* output, ConvertResults& results)
+{
+  results = ConvertResults();
+
+  BinaryPuzzleHeader header;
+  bool has_header = false;
+  int values[kMaxPuzzleLineLength];
+  std::vector<uint8_t> record;
+  bool is_written = true;
+
+  size_t line_start = 0;
+  while(line_start < data_size && is_written == true)
+  {
+    const char* line = data + line_start;
+    const char* line_end = static_cast<const char*>(std::memchr(line, '\n', data_size - line_start));
+    size_t length = (line_end != nullptr) ? static_cast<size_t>(line_end - line) : data_size - line_start;
+    line_start += length + 1;
+
+    if(length > 0 && line[length - 1] == '\r')
+    {
+      --length;
+    }
+    if(length == 0 || line[0] == '#')
+    {
+      continue;
+    }
+
+    int size = GetPuzzleLineSize(line, length);
+    if(size == 0 || (has_header == true && size != header._size) || ParsePuzzleLine(line, size, values) == false)
+    {
+      ++results._skipped_count;
+      continue;
+    }
+
+    // A solution is written after the puzzle, separated from it by a single character
+    size_t puzzle_length = static_cast<size_t>(size * size);
+    bool has_solution = length >= (puzzle_length * 2) + 1 && GetPuzzleLineSize(line + puzzle_length + 1, length - puzzle_length - 1) == size;
+    if(has_header == false)
+    {
+      header = MakeHeader(size, has_solution);
+      has_header = true;
+
+      uint8_t header_bytes[kBinaryPuzzleHeaderSize];
+      WriteHeader(header, header_bytes);
+      is_written = std::fwrite(header_bytes, 1, kBinaryPuzzleHeaderSize, output) == kBinaryPuzzleHeaderSize;
+      record.resize(header._record_size);
+    }
+
+    size_t packed_size = GetPackedSize(size, header._bits_per_slot);
+    PackValues(values, size, header._bits_per_slot, record.data());
+    if(header._has_solutions == true)
+    {
+      if(has_solution == false || ParsePuzzleLine(line + puzzle_length + 1, size, values) == false)
+      {
+        // Stored as all empty, the same as a puzzle without a solution
+        for(size_t slot = 0; slot < puzzle_length; ++slot)
+        {
+          values[slot] = kEmptySlot;
+        }
+      }
+      PackValues(values, size, header._bits_per_slot, record.data() + packed_size);
+    }
+
+    is_written = is_written == true && std::fwrite(record.data(), 1, record.size(), output) == record.size();
+    ++results._record_count;
+  }
+
+  return has_header == true && is_written == true;
+}
+
+bool BinaryPuzzleFile::ConvertBinaryToText(const char* data, size_t data_size, FILE* output, ConvertResults& results)
+{
+  results = ConvertResults();
+
+  BinaryPuzzleHeader header;
+  if(ReadHeader(data, data_size, header) == false)
+  {
+    return false;
+  }
+
+  int size = header._size;
+  size_t packed_size = GetPackedSize(size, header._bits_per_slot);
+  size_t record_count = (data_size - kBinaryPuzzleHeaderSize) / header._record_size;
+  results._truncated_size = (data_size - kBinaryPuzzleHeaderSize) % header._record_size;
+  results._skipped_count += (results._truncated_size > 0) ? 1 : 0;
+  int values[kMaxPuzzleLineLength];
+  char line[(kMaxPuzzleLineLength + 1) * 2];
+  bool is_written = true;
+  for(size_t record = 0; record < record_count && is_written == true; ++record)
+  {
+    const uint8_t* packed = reinterpret_cast<const uint8_t*>(data + kBinaryPuzzleHeaderSize + (record * header._record_size));
+    if(UnpackValues(packed, size, header._bits_per_slot, values) == false)
+    {
+      ++results._skipped_count;
+      continue;
+    }
+
+    size_t length = 0;
+    for(int slot = 0; slot < size * size; ++slot)
+    {
+      line[length++] = (values[slot] > 0) ? ValueToChar(values[slot]) : '.';
+    }
+
+    // Records without a solution have it stored as all empty
+    if(header._has_solutions == true && UnpackValues(packed + packed_size, size, header._bits_per_slot, values) == true && values[0] > 0)
+    {
+      line[length++] = ' ';
+      for(int slot = 0; slot < size * size; ++slot)
+      {
+        line[length++] = (values[slot] > 0) ? ValueToChar(values[slot]) : '.';
+      }
+    }
+    line[length++] = '\n';
+
+    is_written = std::fwrite(line, 1, length, output) == length;
+    ++results._record_count;
+  }
+
+  return is_written == true;
+}
+
+} // namespace Sudoku
@@ -0,0 +1,81 @@
+#include "BitSlicedSolver.h"
+
+#include "BitUtility.h"
+#include "PerformanceScopeTimer.h"
+
+namespace Sudoku
+{
+
+BitSlicedSolver::BitSlicedSolver()
+  : _kernels(&GetCandidateKernels())
+{
+}
+
+// --- Pubic Interface --- //
+uint32_t BitSlicedSolver::SolvePuzzles(int puzzle_count, int values[][kSudokuSize][kSudokuSize])
+{
+  // Unused lanes are left without any possible values, so they're dropped as invalid straight away
+  for(int slot = 0; slot < kSudokuSize * kSudokuSize; ++slot)
+  {
+    int row = slot / kSudokuSize;
+    int col = slot % kSudokuSize;
+    for(int lane = 0; lane < kBitSlicedLanes; ++lane)
+    {
+      uint16_t mask = 0;
+      if(lane < puzzle_count)
+      {
+        mask = (values[lane][row][col] == kEmptySlot) ? static_cast<uint16_t>(kAllPossibleValues) : ValueToMask(values[lane][row][col]);
+      }
+      _boards._cells[slot][lane] = mask;
+    }
+  }
+
+  uint16_t solved_lanes = 0;
+  uint16_t invalid_lanes = 0;
+  {
+    TimePerformanceScope("PropagateLanes");
+    _kernels->PropagateLanes(_boards, solved_lanes, invalid_lanes);
+  }
+
+  uint32_t solved_puzzles = 0;
+  _multiple_solution_puzzles = 0;
+  for(int lane = 0; lane < puzzle_count; ++lane)
+  {
+    uint16_t lane_bit = static_cast<uint16_t>(1 << lane);
+    _lane_stats[lane] = SolverStats();
+    if((invalid_lanes & lane_bit) != 0)
+    {
+      continue;
+    }
+
+    // Every placed value is a single bit, the rest are left for the backtracking solver
+    for(int slot = 0; slot < kSudokuSize * kSudokuSize; ++slot)
+    {
+      uint16_t mask = _boards._cells[slot][lane];
+      values[lane][slot / kSudokuSize][slot % kSudokuSize] = (Utility::PopCount(mask) == 1) ? Utility::LowestBitIndex(mask) + 1 : kEmptySlot;
+    }
+
+    if((solved_lanes & lane_bit) == 0)
+    {
+      TimePerformanceScope("FallbackSolve");
+      ++_fallback_count;
+      _fallback_solver.LoadPuzzle(values[lane]);
+      uint64_t solution_count = _fallback_solver.CountSolutions(_is_checking_uniqueness ? 2 : 1);
+      _lane_stats[lane] = _fallback_solver.GetStats();
+      if(solution_count == 0)
+      {
+        continue;
+      }
+
+      _multiple_solution_puzzles |= (solution_count > 1) ? lane_bit : 0;
+
+      _fallback_solver.CopySolution(values[lane]);
+    }
+
+    solved_puzzles |= lane_bit;
+  }
+
+  return solved_puzzles;
+}
+
+} // namespace Sudoku
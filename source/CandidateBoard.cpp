@@ -0,0 +1,280 @@
+#include "CandidateBoard.h"
+
+#include "CandidateKernel.h"
+#include "CpuFeatures.h"
+
+#include <cstring>
+
+namespace Sudoku
+{
+
+//! Plain C++ stand in for a vector register, used when the CPU has neither AVX2 nor SSE4.1
+struct ScalarVector
+{
+  struct Type
+  {
+    uint16_t _lanes[kCandidateLanes];
+  };
+
+  static Type Load(const uint16_t* values)
+  {
+    Type result;
+    std::memcpy(result._lanes, values, sizeof(result._lanes));
+    return result;
+  }
+
+  static void Store(uint16_t* values, const Type& vector)
+  {
+    std::memcpy(values, vector._lanes, sizeof(vector._lanes));
+  }
+
+  static Type Zero()
+  {
+    return Set1(0);
+  }
+
+  static Type Set1(uint16_t value)
+  {
+    Type result;
+    for(int lane = 0; lane < kCandidateLanes; ++lane)
+    {
+      result._lanes[lane] = value;
+    }
+    return result;
+  }
+
+  //! Puts each column's value in its lane, and pad in every other lane
+  static Type SetColumns(const uint16_t values[kSudokuSize], uint16_t pad)
+  {
+    Type result = Set1(pad);
+    for(int col = 0; col < kSudokuSize; ++col)
+    {
+      result._lanes[ColumnToLane(col)] = values[col];
+    }
+    return result;
+  }
+
+  //! Fills the quad of each group in a band with its value, and the unused quad with pad
+  static Type SetGroups(uint16_t first, uint16_t second, uint16_t third, uint16_t pad)
+  {
+    Type result;
+    for(int lane = 0; lane < 4; ++lane)
+    {
+      result._lanes[lane] = first;
+      result._lanes[lane + 4] = second;
+      result._lanes[lane + 8] = third;
+      result._lanes[lane + 12] = pad;
+    }
+    return result;
+  }
+
+  static Type Or(const Type& a, const Type& b)
+  {
+    Type result;
+    for(int lane = 0; lane < kCandidateLanes; ++lane)
+    {
+      result._lanes[lane] = a._lanes[lane] | b._lanes[lane];
+    }
+    return result;
+  }
+
+  static Type And(const Type& a, const Type& b)
+  {
+    Type result;
+    for(int lane = 0; lane < kCandidateLanes; ++lane)
+    {
+      result._lanes[lane] = a._lanes[lane] & b._lanes[lane];
+    }
+    return result;
+  }
+
+  //! ~a & b, matching the SIMD instructions
+  static Type AndNot(const Type& a, const Type& b)
+  {
+    Type result;
+    for(int lane = 0; lane < kCandidateLanes; ++lane)
+    {
+      result._lanes[lane] = static_cast<uint16_t>(~a._lanes[lane] & b._lanes[lane]);
+    }
+    return result;
+  }
+
+  static Type Sub1(const Type& a)
+  {
+    Type result;
+    for(int lane = 0; lane < kCandidateLanes; ++lane)
+    {
+      result._lanes[lane] = static_cast<uint16_t>(a._lanes[lane] - 1);
+    }
+    return result;
+  }
+
+  //! All bits set in the lanes that are equal
+  static Type CmpEq(const Type& a, const Type& b)
+  {
+    Type result;
+    for(int lane = 0; lane < kCandidateLanes; ++lane)
+    {
+      result._lanes[lane] = a._lanes[lane] == b._lanes[lane] ? 0xFFFF : 0;
+    }
+    return result;
+  }
+
+  static bool IsZero(const Type& a)
+  {
+    uint16_t bits = 0;
+    for(int lane = 0; lane < kCandidateLanes; ++lane)
+    {
+      bits |= a._lanes[lane];
+    }
+    return bits == 0;
+  }
+
+  static bool AllEqual(const Type& a, const Type& b)
+  {
+    return std::memcmp(a._lanes, b._lanes, sizeof(a._lanes)) == 0;
+  }
+
+  static uint16_t NonZeroLanes(const Type& a)
+  {
+    uint16_t lanes = 0;
+    for(int lane = 0; lane < kCandidateLanes; ++lane)
+    {
+      if(a._lanes[lane] != 0)
+      {
+        lanes |= static_cast<uint16_t>(1 << lane);
+      }
+    }
+    return lanes;
+  }
+
+  static uint16_t FirstLane(const Type& a)
+  {
+    return a._lanes[0];
+  }
+
+  //! Rotates the lanes of every quad by shift
+  static Type RotateQuads(const Type& a, int shift)
+  {
+    Type result;
+    for(int lane = 0; lane < kCandidateLanes; ++lane)
+    {
+      result._lanes[lane] = a._lanes[(lane & ~3) | ((lane + shift) & 3)];
+    }
+    return result;
+  }
+
+  static Type RotateQuads1(const Type& a)
+  {
+    return RotateQuads(a, 1);
+  }
+
+  static Type RotateQuads2(const Type& a)
+  {
+    return RotateQuads(a, 2);
+  }
+
+  //! Swaps the two quads of each 128 bit half
+  static Type SwapHalves64(const Type& a)
+  {
+    Type result;
+    for(int lane = 0; lane < kCandidateLanes; ++lane)
+    {
+      result._lanes[lane] = a._lanes[lane ^ 4];
+    }
+    return result;
+  }
+
+  static Type SwapHalves128(const Type& a)
+  {
+    Type result;
+    for(int lane = 0; lane < kCandidateLanes; ++lane)
+    {
+      result._lanes[lane] = a._lanes[lane ^ 8];
+    }
+    return result;
+  }
+};
+
+static bool DecodePuzzleLineScalar(const char* line, int values[kSudokuSize * kSudokuSize])
+{
+  for(int index = 0; index < kSudokuSize * kSudokuSize; ++index)
+  {
+    char c = line[index];
+    if(c >= '1' && c <= '9')
+    {
+      values[index] = c - '0';
+    }
+    else if(c == '.' || c == '0' || c == '*')
+    {
+      values[index] = kEmptySlot;
+    }
+    else
+    {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+// --- Pubic Interface --- //
+const CandidateKernels& GetScalarCandidateKernels()
+{
+  static const CandidateKernels kernels = { kScalarKernelsName, &ComputeCandidatesKernel<ScalarVector>, &FindSinglesKernel<ScalarVector>, &PropagateLanesKernel<ScalarVector>, &DecodePuzzleLineScalar };
+  return kernels;
+}
+
+//! The fastest kernels this CPU supports
+static const CandidateKernels* DetectCandidateKernels()
+{
+  if(GetAvx2CandidateKernels() != nullptr && Utility::HasAvx2() == true)
+  {
+    return GetAvx2CandidateKernels();
+  }
+
+  if(GetSse41CandidateKernels() != nullptr && Utility::HasSse41() == true)
+  {
+    return GetSse41CandidateKernels();
+  }
+
+  return &GetScalarCandidateKernels();
+}
+
+static const CandidateKernels*& SelectedCandidateKernels()
+{
+  static const CandidateKernels* selected_kernels = DetectCandidateKernels();
+  return selected_kernels;
+}
+
+const CandidateKernels& GetCandidateKernels()
+{
+  return *SelectedCandidateKernels();
+}
+
+bool SelectCandidateKernels(const char* name)
+{
+  const CandidateKernels* kernels = nullptr;
+  if(std::strcmp(name, kScalarKernelsName) == 0)
+  {
+    kernels = &GetScalarCandidateKernels();
+  }
+  else if(std::strcmp(name, kSse41KernelsName) == 0 && Utility::HasSse41() == true)
+  {
+    kernels = GetSse41CandidateKernels();
+  }
+  else if(std::strcmp(name, kAvx2KernelsName) == 0 && Utility::HasAvx2() == true)
+  {
+    kernels = GetAvx2CandidateKernels();
+  }
+
+  if(kernels == nullptr)
+  {
+    return false;
+  }
+
+  SelectedCandidateKernels() = kernels;
+  return true;
+}
+
+} // namespace Sudoku
@@ -0,0 +1,192 @@
+#include "CandidateBoard.h"
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+
+#include <immintrin.h>
+
+// The rest of this file is compiled for AVX2, it's only called once the CPU has been checked for it
+#if defined(__clang__)
+#pragma clang attribute push (__attribute__((target("avx2"))), apply_to = function)
+#elif defined(__GNUC__)
+#pragma GCC push_options
+#pragma GCC target("avx2")
+#endif
+
+#include "CandidateKernel.h"
+
+namespace Sudoku
+{
+
+//! A whole row of the board in one 256 bit register
+struct Avx2Vector
+{
+  typedef __m256i Type;
+
+  static Type Load(const uint16_t* values)
+  {
+    return _mm256_load_si256(reinterpret_cast<const __m256i*>(values));
+  }
+
+  static void Store(uint16_t* values, Type vector)
+  {
+    _mm256_store_si256(reinterpret_cast<__m256i*>(values), vector);
+  }
+
+  static Type Zero()
+  {
+    return _mm256_setzero_si256();
+  }
+
+  static Type Set1(uint16_t value)
+  {
+    return _mm256_set1_epi16(static_cast<short>(value));
+  }
+
+  static Type SetColumns(const uint16_t values[kSudokuSize], uint16_t pad)
+  {
+    const short p = static_cast<short>(pad);
+    return _mm256_setr_epi16(static_cast<short>(values[0]), static_cast<short>(values[1]), static_cast<short>(values[2]), p,
+                             static_cast<short>(values[3]), static_cast<short>(values[4]), static_cast<short>(values[5]), p,
+                             static_cast<short>(values[6]), static_cast<short>(values[7]), static_cast<short>(values[8]), p,
+                             p, p, p, p);
+  }
+
+  static Type SetGroups(uint16_t first, uint16_t second, uint16_t third, uint16_t pad)
+  {
+    const short a = static_cast<short>(first);
+    const short b = static_cast<short>(second);
+    const short c = static_cast<short>(third);
+    const short p = static_cast<short>(pad);
+    return _mm256_setr_epi16(a, a, a, a, b, b, b, b, c, c, c, c, p, p, p, p);
+  }
+
+  static Type Or(Type a, Type b)
+  {
+    return _mm256_or_si256(a, b);
+  }
+
+  static Type And(Type a, Type b)
+  {
+    return _mm256_and_si256(a, b);
+  }
+
+  static Type AndNot(Type a, Type b)
+  {
+    return _mm256_andnot_si256(a, b);
+  }
+
+  static Type Sub1(Type a)
+  {
+    return _mm256_sub_epi16(a, _mm256_set1_epi16(1));
+  }
+
+  static Type CmpEq(Type a, Type b)
+  {
+    return _mm256_cmpeq_epi16(a, b);
+  }
+
+  static bool IsZero(Type a)
+  {
+    return _mm256_testz_si256(a, a) != 0;
+  }
+
+  static bool AllEqual(Type a, Type b)
+  {
+    return _mm256_movemask_epi8(_mm256_cmpeq_epi16(a, b)) == -1;
+  }
+
+  static uint16_t NonZeroLanes(Type a)
+  {
+    uint32_t zero_bytes = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi16(a, _mm256_setzero_si256())));
+    return CompressLaneMask<Avx2Vector>(~zero_bytes);
+  }
+
+  static uint16_t FirstLane(Type a)
+  {
+    return static_cast<uint16_t>(_mm_extract_epi16(_mm256_castsi256_si128(a), 0));
+  }
+
+  static Type RotateQuads1(Type a)
+  {
+    return _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(a, _MM_SHUFFLE(0, 3, 2, 1)), _MM_SHUFFLE(0, 3, 2, 1));
+  }
+
+  static Type RotateQuads2(Type a)
+  {
+    return _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(a, _MM_SHUFFLE(1, 0, 3, 2)), _MM_SHUFFLE(1, 0, 3, 2));
+  }
+
+  static Type SwapHalves64(Type a)
+  {
+    return _mm256_shuffle_epi32(a, _MM_SHUFFLE(1, 0, 3, 2));
+  }
+
+  static Type SwapHalves128(Type a)
+  {
+    return _mm256_permute2x128_si256(a, a, 0x01);
+  }
+};
+
+//! Decodes 32 characters into values, returns false if one of them isn't a value or an empty slot
+static bool DecodeCharacters(const char* characters, int* values)
+{
+  const __m256i chars = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(characters));
+  const __m256i digits = _mm256_sub_epi8(chars, _mm256_set1_epi8('0'));
+  // Anything below '0' wraps around, so only '0'-'9' are 9 or less
+  const __m256i is_digit = _mm256_cmpeq_epi8(_mm256_min_epu8(digits, _mm256_set1_epi8(9)), digits);
+  const __m256i is_blank = _mm256_or_si256(_mm256_cmpeq_epi8(chars, _mm256_set1_epi8('.')), _mm256_cmpeq_epi8(chars, _mm256_set1_epi8('*')));
+  if(_mm256_movemask_epi8(_mm256_or_si256(is_digit, is_blank)) != -1)
+  {
+    return false;
+  }
+
+  // Empty slots become all bits set, which sign extends to kEmptySlot
+  const __m256i is_empty = _mm256_or_si256(is_blank, _mm256_cmpeq_epi8(digits, _mm256_setzero_si256()));
+  const __m256i bytes = _mm256_or_si256(digits, is_empty);
+  const __m128i low = _mm256_castsi256_si128(bytes);
+  const __m128i high = _mm256_extracti128_si256(bytes, 1);
+  _mm256_storeu_si256(reinterpret_cast<__m256i*>(values), _mm256_cvtepi8_epi32(low));
+  _mm256_storeu_si256(reinterpret_cast<__m256i*>(values + 8), _mm256_cvtepi8_epi32(_mm_srli_si128(low, 8)));
+  _mm256_storeu_si256(reinterpret_cast<__m256i*>(values + 16), _mm256_cvtepi8_epi32(high));
+  _mm256_storeu_si256(reinterpret_cast<__m256i*>(values + 24), _mm256_cvtepi8_epi32(_mm_srli_si128(high, 8)));
+  return true;
+}
+
+static bool DecodePuzzleLineAvx2(const char* line, int values[kSudokuSize * kSudokuSize])
+{
+  // The last block overlaps the one before it, so nothing past the puzzle is read
+  return DecodeCharacters(line, values) == true && DecodeCharacters(line + 32, values + 32) == true && DecodeCharacters(line + 49, values + 49) == true;
+}
+
+} // namespace Sudoku
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#elif defined(__GNUC__)
+#pragma GCC pop_options
+#endif
+
+namespace Sudoku
+{
+
+const CandidateKernels* GetAvx2CandidateKernels()
+{
+  static const CandidateKernels kernels = { kAvx2KernelsName, &ComputeCandidatesKernel<Avx2Vector>, &FindSinglesKernel<Avx2Vector>, &PropagateLanesKernel<Avx2Vector>, &DecodePuzzleLineAvx2 };
+  return &kernels;
+}
+
+} // namespace Sudoku
+
+#else
+
+namespace Sudoku
+{
+
+const CandidateKernels* GetAvx2CandidateKernels()
+{
+  return nullptr;
+}
+
+} // namespace Sudoku
+
+#endif
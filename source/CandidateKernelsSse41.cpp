@@ -0,0 +1,197 @@
+#include "CandidateBoard.h"
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+
+#include <smmintrin.h>
+
+// The rest of this file is compiled for SSE4.1, it's only called once the CPU has been checked for it
+#if defined(__clang__)
+#pragma clang attribute push (__attribute__((target("sse4.1"))), apply_to = function)
+#elif defined(__GNUC__)
+#pragma GCC push_options
+#pragma GCC target("sse4.1")
+#endif
+
+#include "CandidateKernel.h"
+
+namespace Sudoku
+{
+
+//! A row of the board split over two 128 bit registers, the high one only has the first group's quad in use
+struct Sse41Vector
+{
+  struct Type
+  {
+    __m128i _low;
+    __m128i _high;
+  };
+
+  static Type Load(const uint16_t* values)
+  {
+    return { _mm_load_si128(reinterpret_cast<const __m128i*>(values)), _mm_load_si128(reinterpret_cast<const __m128i*>(values + 8)) };
+  }
+
+  static void Store(uint16_t* values, Type vector)
+  {
+    _mm_store_si128(reinterpret_cast<__m128i*>(values), vector._low);
+    _mm_store_si128(reinterpret_cast<__m128i*>(values + 8), vector._high);
+  }
+
+  static Type Zero()
+  {
+    return { _mm_setzero_si128(), _mm_setzero_si128() };
+  }
+
+  static Type Set1(uint16_t value)
+  {
+    __m128i result = _mm_set1_epi16(static_cast<short>(value));
+    return { result, result };
+  }
+
+  static Type SetColumns(const uint16_t values[kSudokuSize], uint16_t pad)
+  {
+    const short p = static_cast<short>(pad);
+    return { _mm_setr_epi16(static_cast<short>(values[0]), static_cast<short>(values[1]), static_cast<short>(values[2]), p, static_cast<short>(values[3]), static_cast<short>(values[4]), static_cast<short>(values[5]), p),
+             _mm_setr_epi16(static_cast<short>(values[6]), static_cast<short>(values[7]), static_cast<short>(values[8]), p, p, p, p, p) };
+  }
+
+  static Type SetGroups(uint16_t first, uint16_t second, uint16_t third, uint16_t pad)
+  {
+    return { _mm_unpacklo_epi64(_mm_set1_epi16(static_cast<short>(first)), _mm_set1_epi16(static_cast<short>(second))),
+             _mm_unpacklo_epi64(_mm_set1_epi16(static_cast<short>(third)), _mm_set1_epi16(static_cast<short>(pad))) };
+  }
+
+  static Type Or(Type a, Type b)
+  {
+    return { _mm_or_si128(a._low, b._low), _mm_or_si128(a._high, b._high) };
+  }
+
+  static Type And(Type a, Type b)
+  {
+    return { _mm_and_si128(a._low, b._low), _mm_and_si128(a._high, b._high) };
+  }
+
+  static Type AndNot(Type a, Type b)
+  {
+    return { _mm_andnot_si128(a._low, b._low), _mm_andnot_si128(a._high, b._high) };
+  }
+
+  static Type Sub1(Type a)
+  {
+    const __m128i one = _mm_set1_epi16(1);
+    return { _mm_sub_epi16(a._low, one), _mm_sub_epi16(a._high, one) };
+  }
+
+  static Type CmpEq(Type a, Type b)
+  {
+    return { _mm_cmpeq_epi16(a._low, b._low), _mm_cmpeq_epi16(a._high, b._high) };
+  }
+
+  static bool IsZero(Type a)
+  {
+    __m128i bits = _mm_or_si128(a._low, a._high);
+    return _mm_testz_si128(bits, bits) != 0;
+  }
+
+  static bool AllEqual(Type a, Type b)
+  {
+    return _mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi16(a._low, b._low), _mm_cmpeq_epi16(a._high, b._high))) == 0xFFFF;
+  }
+
+  static uint16_t NonZeroLanes(Type a)
+  {
+    const __m128i zero = _mm_setzero_si128();
+    uint32_t zero_bytes = static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi16(a._low, zero))) | (static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi16(a._high, zero))) << 16);
+    return CompressLaneMask<Sse41Vector>(~zero_bytes);
+  }
+
+  static uint16_t FirstLane(Type a)
+  {
+    return static_cast<uint16_t>(_mm_extract_epi16(a._low, 0));
+  }
+
+  static Type RotateQuads1(Type a)
+  {
+    return { _mm_shufflehi_epi16(_mm_shufflelo_epi16(a._low, _MM_SHUFFLE(0, 3, 2, 1)), _MM_SHUFFLE(0, 3, 2, 1)),
+             _mm_shufflehi_epi16(_mm_shufflelo_epi16(a._high, _MM_SHUFFLE(0, 3, 2, 1)), _MM_SHUFFLE(0, 3, 2, 1)) };
+  }
+
+  static Type RotateQuads2(Type a)
+  {
+    return { _mm_shufflehi_epi16(_mm_shufflelo_epi16(a._low, _MM_SHUFFLE(1, 0, 3, 2)), _MM_SHUFFLE(1, 0, 3, 2)),
+             _mm_shufflehi_epi16(_mm_shufflelo_epi16(a._high, _MM_SHUFFLE(1, 0, 3, 2)), _MM_SHUFFLE(1, 0, 3, 2)) };
+  }
+
+  static Type SwapHalves64(Type a)
+  {
+    return { _mm_shuffle_epi32(a._low, _MM_SHUFFLE(1, 0, 3, 2)), _mm_shuffle_epi32(a._high, _MM_SHUFFLE(1, 0, 3, 2)) };
+  }
+
+  static Type SwapHalves128(Type a)
+  {
+    return { a._high, a._low };
+  }
+};
+
+//! Decodes 16 characters into values, returns false if one of them isn't a value or an empty slot
+static bool DecodeCharacters(const char* characters, int* values)
+{
+  const __m128i chars = _mm_loadu_si128(reinterpret_cast<const __m128i*>(characters));
+  const __m128i digits = _mm_sub_epi8(chars, _mm_set1_epi8('0'));
+  // Anything below '0' wraps around, so only '0'-'9' are 9 or less
+  const __m128i is_digit = _mm_cmpeq_epi8(_mm_min_epu8(digits, _mm_set1_epi8(9)), digits);
+  const __m128i is_blank = _mm_or_si128(_mm_cmpeq_epi8(chars, _mm_set1_epi8('.')), _mm_cmpeq_epi8(chars, _mm_set1_epi8('*')));
+  if(_mm_movemask_epi8(_mm_or_si128(is_digit, is_blank)) != 0xFFFF)
+  {
+    return false;
+  }
+
+  // Empty slots become all bits set, which sign extends to kEmptySlot
+  const __m128i is_empty = _mm_or_si128(is_blank, _mm_cmpeq_epi8(digits, _mm_setzero_si128()));
+  const __m128i bytes = _mm_or_si128(digits, is_empty);
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(values), _mm_cvtepi8_epi32(bytes));
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(values + 4), _mm_cvtepi8_epi32(_mm_srli_si128(bytes, 4)));
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(values + 8), _mm_cvtepi8_epi32(_mm_srli_si128(bytes, 8)));
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(values + 12), _mm_cvtepi8_epi32(_mm_srli_si128(bytes, 12)));
+  return true;
+}
+
+static bool DecodePuzzleLineSse41(const char* line, int values[kSudokuSize * kSudokuSize])
+{
+  // The last block overlaps the one before it, so nothing past the puzzle is read
+  return DecodeCharacters(line, values) == true && DecodeCharacters(line + 16, values + 16) == true && DecodeCharacters(line + 32, values + 32) == true &&
+    DecodeCharacters(line + 48, values + 48) == true && DecodeCharacters(line + 64, values + 64) == true && DecodeCharacters(line + 65, values + 65) == true;
+}
+
+} // namespace Sudoku
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#elif defined(__GNUC__)
+#pragma GCC pop_options
+#endif
+
+namespace Sudoku
+{
+
+const CandidateKernels* GetSse41CandidateKernels()
+{
+  static const CandidateKernels kernels = { kSse41KernelsName, &ComputeCandidatesKernel<Sse41Vector>, &FindSinglesKernel<Sse41Vector>, &PropagateLanesKernel<Sse41Vector>, &DecodePuzzleLineSse41 };
+  return &kernels;
+}
+
+} // namespace Sudoku
+
+#else
+
+namespace Sudoku
+{
+
+const CandidateKernels* GetSse41CandidateKernels()
+{
+  return nullptr;
+}
+
+} // namespace Sudoku
+
+#endif
@@ -0,0 +1,61 @@
+#include "CpuFeatures.h"
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#include <immintrin.h>
+#endif
+
+namespace Utility
+{
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+
+bool HasSse41()
+{
+  int registers[4];
+  __cpuid(registers, 1);
+  return (registers[2] & (1 << 19)) != 0;
+}
+
+bool HasAvx2()
+{
+  int registers[4];
+  __cpuid(registers, 1);
+  // AVX and OSXSAVE, then make sure the OS saves the YMM registers
+  bool has_avx = (registers[2] & (1 << 28)) != 0 && (registers[2] & (1 << 27)) != 0;
+  if(has_avx == false || (_xgetbv(0) & 0x6) != 0x6)
+  {
+    return false;
+  }
+
+  __cpuidex(registers, 7, 0);
+  return (registers[1] & (1 << 5)) != 0;
+}
+
+#elif (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+
+bool HasSse41()
+{
+  return __builtin_cpu_supports("sse4.1") != 0;
+}
+
+bool HasAvx2()
+{
+  return __builtin_cpu_supports("avx2") != 0;
+}
+
+#else
+
+bool HasSse41()
+{
+  return false;
+}
+
+bool HasAvx2()
+{
+  return false;
+}
+
+#endif
+
+} // namespace Utility
@@ -0,0 +1,315 @@
+#include "DancingLinksSolver.h"
+
+#include "PerformanceScopeTimer.h"
+
+namespace Sudoku
+{
+
+// --- Constants
+//! The root node sits right after the column headers
+#define kRootNode kExactCoverColumns
+//! Offsets of the 4 constraint column blocks
+#define kSlotColumnsOffset 0
+#define kRowColumnsOffset (kSudokuSize * kSudokuSize)
+#define kColumnColumnsOffset (2 * kSudokuSize * kSudokuSize)
+#define kGroupColumnsOffset (3 * kSudokuSize * kSudokuSize)
+
+// --- Macros
+//! Expects an exact cover row, returns the slot index it places a value in
+#define ExactCoverRowToSlot(row) ((row) / kSudokuSize)
+//! Expects an exact cover row, returns the value (1-9) it places
+#define ExactCoverRowToValue(row) (((row) % kSudokuSize) + 1)
+
+DancingLinksSolver::DancingLinksSolver()
+{
+  BuildMatrix();
+}
+
+// --- Pubic Interface --- //
+void DancingLinksSolver::LoadPuzzle(const int values[kSudokuSize][kSudokuSize])
+{
+  for(int row = 0; row < kSudokuSize; ++row)
+  {
+    for(int col = 0; col < kSudokuSize; ++col)
+    {
+      _values[row][col] = values[row][col];
+    }
+  }
+}
+
+bool DancingLinksSolver::SolvePuzzle()
+{
+  return CountSolutions(1) > 0;
+}
+
+uint64_t DancingLinksSolver::CountSolutions(uint64_t solution_limit)
+{
+  _stats = SolverStats();
+  StartBudget();
+  _solution_depth = 0;
+  _search_depth = 0;
+  _solution_limit = solution_limit;
+  _solution_count = 0;
+
+  // Select the rows for the starting values, any clash means the puzzle can't be solved
+  int given_rows[kSudokuSize * kSudokuSize];
+  int given_count = 0;
+  bool is_valid = true;
+  for(int slot = 0; slot < kSudokuSize * kSudokuSize && is_valid == true; ++slot)
+  {
+    int value = _values[slot / kSudokuSize][slot % kSudokuSize];
+    if(value == kEmptySlot)
+    {
+      continue;
+    }
+
+    int row = (slot * kSudokuSize) + (value - 1);
+    is_valid = SelectRow(row);
+    if(is_valid == true)
+    {
+      given_rows[given_count++] = row;
+    }
+  }
+
+  if(is_valid == true)
+  {
+    TimePerformanceScope("ExactCoverSearch");
+    Search();
+  }
+
+  // Restore the matrix so the next puzzle can reuse it
+  while(given_count > 0)
+  {
+    DeselectRow(given_rows[--given_count]);
+  }
+
+  return _solution_count;
+}
+
+// --- Private Interface --- //
+void DancingLinksSolver::BuildMatrix()
+{
+  // Column headers are linked in a circle with the root
+  for(int column = 0; column <= kRootNode; ++column)
+  {
+    Node& header = _nodes[column];
+    header._left = (column == 0) ? kRootNode : column - 1;
+    header._right = (column == kRootNode) ? 0 : column + 1;
+    header._up = column;
+    header._down = column;
+    header._column = column;
+    header._row = -1;
+  }
+
+  for(int column = 0; column < kExactCoverColumns; ++column)
+  {
+    _column_sizes[column] = 0;
+    _column_covered[column] = false;
+  }
+
+  int next_node = kRootNode + 1;
+  for(int row = 0; row < kExactCoverRows; ++row)
+  {
+    int slot = ExactCoverRowToSlot(row);
+    int value_index = ExactCoverRowToValue(row) - 1;
+    int grid_row = slot / kSudokuSize;
+    int grid_column = slot % kSudokuSize;
+    int group = ((grid_row / 3) * 3) + (grid_column / 3);
+
+    int columns[kExactCoverNodesPerRow] =
+    {
+      kSlotColumnsOffset + slot,
+      kRowColumnsOffset + (grid_row * kSudokuSize) + value_index,
+      kColumnColumnsOffset + (grid_column * kSudokuSize) + value_index,
+      kGroupColumnsOffset + (group * kSudokuSize) + value_index
+    };
+
+    int first_node = next_node;
+    _row_nodes[row] = first_node;
+    for(int i = 0; i < kExactCoverNodesPerRow; ++i)
+    {
+      int index = next_node++;
+      Node& node = _nodes[index];
+      Node& header = _nodes[columns[i]];
+
+      // Link horizontally within the row
+      node._left = (i == 0) ? first_node + kExactCoverNodesPerRow - 1 : index - 1;
+      node._right = (i == kExactCoverNodesPerRow - 1) ? first_node : index + 1;
+
+      // Link vertically at the bottom of the column
+      node._column = columns[i];
+      node._row = row;
+      node._up = header._up;
+      node._down = columns[i];
+      _nodes[header._up]._down = index;
+      header._up = index;
+      ++_column_sizes[columns[i]];
+    }
+  }
+}
+
+void DancingLinksSolver::CoverColumn(int column)
+{
+  Node& header = _nodes[column];
+  _nodes[header._right]._left = header._left;
+  _nodes[header._left]._right = header._right;
+  _column_covered[column] = true;
+
+  for(int row_node = header._down; row_node != column; row_node = _nodes[row_node]._down)
+  {
+    for(int node = _nodes[row_node]._right; node != row_node; node = _nodes[node]._right)
+    {
+      _nodes[_nodes[node]._down]._up = _nodes[node]._up;
+      _nodes[_nodes[node]._up]._down = _nodes[node]._down;
+      --_column_sizes[_nodes[node]._column];
+    }
+  }
+}
+
+void DancingLinksSolver::UncoverColumn(int column)
+{
+  Node& header = _nodes[column];
+  for(int row_node = header._up; row_node != column; row_node = _nodes[row_node]._up)
+  {
+    for(int node = _nodes[row_node]._left; node != row_node; node = _nodes[node]._left)
+    {
+      ++_column_sizes[_nodes[node]._column];
+      _nodes[_nodes[node]._down]._up = node;
+      _nodes[_nodes[node]._up]._down = node;
+    }
+  }
+
+  _column_covered[column] = false;
+  _nodes[header._right]._left = column;
+  _nodes[header._left]._right = column;
+}
+
+bool DancingLinksSolver::SelectRow(int row)
+{
+  int first_node = _row_nodes[row];
+  int node = first_node;
+  do {
+    if(_column_covered[_nodes[node]._column] == true)
+    {
+      return false;
+    }
+    node = _nodes[node]._right;
+  } while(node != first_node);
+
+  do {
+    CoverColumn(_nodes[node]._column);
+    node = _nodes[node]._right;
+  } while(node != first_node);
+
+  return true;
+}
+
+void DancingLinksSolver::DeselectRow(int row)
+{
+  // Uncover in the opposite order the columns were covered in
+  int first_node = _row_nodes[row];
+  int node = first_node;
+  do {
+    node = _nodes[node]._left;
+    UncoverColumn(_nodes[node]._column);
+  } while(node != first_node);
+}
+
+bool DancingLinksSolver::Search()
+{
+  ++_stats._nodes;
+
+  if(_nodes[kRootNode]._right == kRootNode)
+  {
+    // Every constraint is satisfied, write the selected rows of the first solution into the puzzle
+    if(_solution_count == 0)
+    {
+      for(int i = 0; i < _solution_depth; ++i)
+      {
+        int slot = ExactCoverRowToSlot(_solution_rows[i]);
+        _values[slot / kSudokuSize][slot % kSudokuSize] = ExactCoverRowToValue(_solution_rows[i]);
+      }
+    }
+
+    ++_solution_count;
+    return _solution_limit != 0 && _solution_count >= _solution_limit;
+  }
+
+  if(IsOverBudget() == true)
+  {
+    // Stop searching, the same as if the solution limit was reached
+    return true;
+  }
+
+  // Branch on the column with the fewest rows left
+  int branch_column = _nodes[kRootNode]._right;
+  for(int column = _nodes[branch_column]._right; column != kRootNode; column = _nodes[column]._right)
+  {
+    if(_column_sizes[column] < _column_sizes[branch_column])
+    {
+      branch_column = column;
+      if(_column_sizes[column] <= 1)
+      {
+        break;
+      }
+    }
+  }
+
+  if(_column_sizes[branch_column] == 0)
+  {
+    return false;
+  }
+
+  // A column with one row left is a forced move, a slot column is a naked single and any other is a value with one place left in a unit
+  bool is_guess = _column_sizes[branch_column] > 1;
+  if(is_guess == false)
+  {
+    if(branch_column < kRowColumnsOffset)
+    {
+      ++_stats._naked_singles;
+    }
+    else
+    {
+      ++_stats._hidden_singles;
+    }
+  }
+
+  CoverColumn(branch_column);
+
+  bool is_finished = false;
+  for(int row_node = _nodes[branch_column]._down; row_node != branch_column && is_finished == false; row_node = _nodes[row_node]._down)
+  {
+    _solution_rows[_solution_depth++] = _nodes[row_node]._row;
+    if(is_guess == true)
+    {
+      ++_stats._guesses;
+      ++_search_depth;
+      _stats._max_depth = (static_cast<uint64_t>(_search_depth) > _stats._max_depth) ? _search_depth : _stats._max_depth;
+    }
+    for(int node = _nodes[row_node]._right; node != row_node; node = _nodes[node]._right)
+    {
+      CoverColumn(_nodes[node]._column);
+    }
+
+    is_finished = Search();
+
+    // Always unwind, even when finished, so the matrix is left intact
+    for(int node = _nodes[row_node]._left; node != row_node; node = _nodes[node]._left)
+    {
+      UncoverColumn(_nodes[node]._column);
+    }
+    --_solution_depth;
+    // Only guesses count as backtracks, a forced column's rows failing just unwinds the guess above it
+    if(is_guess == true)
+    {
+      --_search_depth;
+      _stats._backtracks += (is_finished == false) ? 1 : 0;
+    }
+  }
+
+  UncoverColumn(branch_column);
+
+  return is_finished;
+}
+
+} // namespace Sudoku
@@ -0,0 +1,407 @@
+#include "DeductionStrategies.h"
+
+#include "BitUtility.h"
+#include "BoardGeometry.h"
+
+#include <cstring>
+
+namespace Sudoku
+{
+
+// --- Constants
+//! Where each kind of unit starts in the unit tables
+#define kRowUnits 0
+#define kColumnUnits kSudokuSize
+#define kGroupUnits (kSudokuSize * 2)
+
+typedef BoardGeometry<3> Geometry;
+
+//! Calls visit with the indices of every subset of subset_size (2 or 3) out of item_count items, returns true if any visit did
+template<typename Visit>
+static bool VisitSubsets(int item_count, int subset_size, Visit visit)
+{
+  bool is_found = false;
+  for(int a = 0; a < item_count; ++a)
+  {
+    for(int b = a + 1; b < item_count; ++b)
+    {
+      if(subset_size == 2)
+      {
+        int subset[2] = { a, b };
+        is_found = visit(subset) == true || is_found == true;
+        continue;
+      }
+
+      for(int c = b + 1; c < item_count; ++c)
+      {
+        int subset[3] = { a, b, c };
+        is_found = visit(subset) == true || is_found == true;
+      }
+    }
+  }
+
+  return is_found;
+}
+
+//! Takes the values away from the slot, returns true if any of them were still possible there and not already taken away
+static bool RemoveValues(const uint16_t* candidates, uint16_t* removed, int slot, uint16_t values)
+{
+  uint16_t new_values = candidates[slot] & values & ~removed[slot];
+  removed[slot] |= new_values;
+  return new_values != 0;
+}
+
+//! subset_size slots of a unit that only have subset_size values between them hold those values, so no other slot of the unit can
+static bool FindNakedSubsets(int subset_size, const uint16_t* candidates, uint16_t* removed)
+{
+  bool is_found = false;
+  for(int unit = 0; unit < Geometry::kUnits; ++unit)
+  {
+    const Geometry::Index* slots = Geometry::kTables._unit_slots[unit];
+    int subset_slots[kSudokuSize];
+    int slot_count = 0;
+    for(int i = 0; i < kSudokuSize; ++i)
+    {
+      int count = Utility::PopCount(candidates[slots[i]]);
+      if(count >= 2 && count <= subset_size)
+      {
+        subset_slots[slot_count++] = slots[i];
+      }
+    }
+
+    is_found = VisitSubsets(slot_count, subset_size, [&](const int* subset)
+    {
+      uint16_t values = 0;
+      for(int k = 0; k < subset_size; ++k)
+      {
+        values |= candidates[subset_slots[subset[k]]];
+      }
+      if(Utility::PopCount(values) != subset_size)
+      {
+        return false;
+      }
+
+      bool is_removed = false;
+      for(int i = 0; i < kSudokuSize; ++i)
+      {
+        bool is_in_subset = false;
+        for(int k = 0; k < subset_size; ++k)
+        {
+          is_in_subset = is_in_subset == true || subset_slots[subset[k]] == slots[i];
+        }
+        if(is_in_subset == false)
+        {
+          is_removed = RemoveValues(candidates, removed, slots[i], values) == true || is_removed == true;
+        }
+      }
+      return is_removed;
+    }) == true || is_found == true;
+  }
+
+  return is_found;
+}
+
+//! subset_size values of a unit that only fit in subset_size slots between them have to go in those slots, so nothing else can
+static bool FindHiddenSubsets(int subset_size, const uint16_t* candidates, uint16_t* removed)
+{
+  bool is_found = false;
+  for(int unit = 0; unit < Geometry::kUnits; ++unit)
+  {
+    const Geometry::Index* slots = Geometry::kTables._unit_slots[unit];
+
+    // Which slots of the unit each value can still go in
+    uint16_t positions[kSudokuSize] = {};
+    for(int i = 0; i < kSudokuSize; ++i)
+    {
+      for(uint16_t values = candidates[slots[i]]; values != 0; values &= values - 1)
+      {
+        positions[Utility::LowestBitIndex(values)] |= static_cast<uint16_t>(1 << i);
+      }
+    }
+
+    // Values with a single position are hidden singles, which are placed before any strategy runs
+    int subset_values[kSudokuSize];
+    int value_count = 0;
+    for(int value_index = 0; value_index < kSudokuSize; ++value_index)
+    {
+      int count = Utility::PopCount(positions[value_index]);
+      if(count >= 2 && count <= subset_size)
+      {
+        subset_values[value_count++] = value_index;
+      }
+    }
+
+    is_found = VisitSubsets(value_count, subset_size, [&](const int* subset)
+    {
+      uint16_t subset_positions = 0;
+      uint16_t values = 0;
+      for(int k = 0; k < subset_size; ++k)
+      {
+        subset_positions |= positions[subset_values[subset[k]]];
+        values |= static_cast<uint16_t>(1 << subset_values[subset[k]]);
+      }
+      if(Utility::PopCount(subset_positions) != subset_size)
+      {
+        return false;
+      }
+
+      bool is_removed = false;
+      for(; subset_positions != 0; subset_positions &= subset_positions - 1)
+      {
+        is_removed = RemoveValues(candidates, removed, slots[Utility::LowestBitIndex(subset_positions)], static_cast<uint16_t>(~values)) == true || is_removed == true;
+      }
+      return is_removed;
+    }) == true || is_found == true;
+  }
+
+  return is_found;
+}
+
+//! A value that can only go in one row or column of a group can't go anywhere else in that row or column
+static bool ApplyPointing(const uint16_t candidates[kSudokuSize * kSudokuSize], uint16_t removed[kSudokuSize * kSudokuSize])
+{
+  bool is_found = false;
+  for(int group = 0; group < kSudokuSize; ++group)
+  {
+    const Geometry::Index* slots = Geometry::kTables._unit_slots[kGroupUnits + group];
+    for(int value_index = 0; value_index < kSudokuSize; ++value_index)
+    {
+      uint16_t value = static_cast<uint16_t>(1 << value_index);
+      uint16_t rows = 0;
+      uint16_t columns = 0;
+      for(int i = 0; i < kSudokuSize; ++i)
+      {
+        if((candidates[slots[i]] & value) != 0)
+        {
+          rows |= static_cast<uint16_t>(1 << (slots[i] / kSudokuSize));
+          columns |= static_cast<uint16_t>(1 << (slots[i] % kSudokuSize));
+        }
+      }
+
+      if(Utility::PopCount(rows) == 1)
+      {
+        int row = Utility::LowestBitIndex(rows);
+        for(int column = 0; column < kSudokuSize; ++column)
+        {
+          if(Geometry::GroupOf(row, column) != group)
+          {
+            is_found = RemoveValues(candidates, removed, (row * kSudokuSize) + column, value) == true || is_found == true;
+          }
+        }
+      }
+      if(Utility::PopCount(columns) == 1)
+      {
+        int column = Utility::LowestBitIndex(columns);
+        for(int row = 0; row < kSudokuSize; ++row)
+        {
+          if(Geometry::GroupOf(row, column) != group)
+          {
+            is_found = RemoveValues(candidates, removed, (row * kSudokuSize) + column, value) == true || is_found == true;
+          }
+        }
+      }
+    }
+  }
+
+  return is_found;
+}
+
+//! A value that can only go in one group along a row or column can't go anywhere else in that group
+static bool ApplyBoxLine(const uint16_t candidates[kSudokuSize * kSudokuSize], uint16_t removed[kSudokuSize * kSudokuSize])
+{
+  bool is_found = false;
+  for(int unit = kRowUnits; unit < kGroupUnits; ++unit)
+  {
+    const Geometry::Index* slots = Geometry::kTables._unit_slots[unit];
+    for(int value_index = 0; value_index < kSudokuSize; ++value_index)
+    {
+      uint16_t value = static_cast<uint16_t>(1 << value_index);
+      uint16_t groups = 0;
+      for(int i = 0; i < kSudokuSize; ++i)
+      {
+        if((candidates[slots[i]] & value) != 0)
+        {
+          groups |= static_cast<uint16_t>(1 << Geometry::GroupOf(slots[i] / kSudokuSize, slots[i] % kSudokuSize));
+        }
+      }
+      if(Utility::PopCount(groups) != 1)
+      {
+        continue;
+      }
+
+      const Geometry::Index* group_slots = Geometry::kTables._unit_slots[kGroupUnits + Utility::LowestBitIndex(groups)];
+      for(int i = 0; i < kSudokuSize; ++i)
+      {
+        int slot = group_slots[i];
+        bool is_in_line = (unit < kColumnUnits) ? slot / kSudokuSize == unit : slot % kSudokuSize == unit - kColumnUnits;
+        if(is_in_line == false)
+        {
+          is_found = RemoveValues(candidates, removed, slot, value) == true || is_found == true;
+        }
+      }
+    }
+  }
+
+  return is_found;
+}
+
+//! fish_size rows where a value only fits in the same fish_size columns between them take that value in every one of those columns,
+//  so it can't go in those columns on any other row. The same goes with rows and columns swapped
+static bool FindFish(int fish_size, const uint16_t* candidates, uint16_t* removed)
+{
+  bool is_found = false;
+  for(int value_index = 0; value_index < kSudokuSize; ++value_index)
+  {
+    uint16_t value = static_cast<uint16_t>(1 << value_index);
+    for(int is_column_based = 0; is_column_based < 2; ++is_column_based)
+    {
+      // Where the value can go along each base line
+      uint16_t covers[kSudokuSize] = {};
+      int base_lines[kSudokuSize];
+      int line_count = 0;
+      for(int line = 0; line < kSudokuSize; ++line)
+      {
+        for(int i = 0; i < kSudokuSize; ++i)
+        {
+          int slot = (is_column_based == 0) ? (line * kSudokuSize) + i : (i * kSudokuSize) + line;
+          covers[line] |= ((candidates[slot] & value) != 0) ? static_cast<uint16_t>(1 << i) : 0;
+        }
+
+        int count = Utility::PopCount(covers[line]);
+        if(count >= 2 && count <= fish_size)
+        {
+          base_lines[line_count++] = line;
+        }
+      }
+
+      is_found = VisitSubsets(line_count, fish_size, [&](const int* subset)
+      {
+        uint16_t cover = 0;
+        uint16_t subset_lines = 0;
+        for(int k = 0; k < fish_size; ++k)
+        {
+          cover |= covers[base_lines[subset[k]]];
+          subset_lines |= static_cast<uint16_t>(1 << base_lines[subset[k]]);
+        }
+        if(Utility::PopCount(cover) != fish_size)
+        {
+          return false;
+        }
+
+        bool is_removed = false;
+        for(int line = 0; line < kSudokuSize; ++line)
+        {
+          if((subset_lines & (1 << line)) != 0)
+          {
+            continue;
+          }
+
+          for(uint16_t cover_lines = cover; cover_lines != 0; cover_lines &= cover_lines - 1)
+          {
+            int i = Utility::LowestBitIndex(cover_lines);
+            int slot = (is_column_based == 0) ? (line * kSudokuSize) + i : (i * kSudokuSize) + line;
+            is_removed = RemoveValues(candidates, removed, slot, value) == true || is_removed == true;
+          }
+        }
+        return is_removed;
+      }) == true || is_found == true;
+    }
+  }
+
+  return is_found;
+}
+
+static bool ApplyNakedPairs(const uint16_t candidates[kSudokuSize * kSudokuSize], uint16_t removed[kSudokuSize * kSudokuSize])
+{
+  return FindNakedSubsets(2, candidates, removed);
+}
+
+static bool ApplyHiddenPairs(const uint16_t candidates[kSudokuSize * kSudokuSize], uint16_t removed[kSudokuSize * kSudokuSize])
+{
+  return FindHiddenSubsets(2, candidates, removed);
+}
+
+static bool ApplyNakedTriples(const uint16_t candidates[kSudokuSize * kSudokuSize], uint16_t removed[kSudokuSize * kSudokuSize])
+{
+  return FindNakedSubsets(3, candidates, removed);
+}
+
+static bool ApplyHiddenTriples(const uint16_t candidates[kSudokuSize * kSudokuSize], uint16_t removed[kSudokuSize * kSudokuSize])
+{
+  return FindHiddenSubsets(3, candidates, removed);
+}
+
+static bool ApplyXWing(const uint16_t candidates[kSudokuSize * kSudokuSize], uint16_t removed[kSudokuSize * kSudokuSize])
+{
+  return FindFish(2, candidates, removed);
+}
+
+static bool ApplySwordfish(const uint16_t candidates[kSudokuSize * kSudokuSize], uint16_t removed[kSudokuSize * kSudokuSize])
+{
+  return FindFish(3, candidates, removed);
+}
+
+//! In the order of their bits
+static const DeductionStrategy kDeductionStrategies[kDeductionStrategyCount] =
+{
+  { "pointing", ApplyPointing },
+  { "box_line", ApplyBoxLine },
+  { "naked_pairs", ApplyNakedPairs },
+  { "hidden_pairs", ApplyHiddenPairs },
+  { "naked_triples", ApplyNakedTriples },
+  { "hidden_triples", ApplyHiddenTriples },
+  { "x_wing", ApplyXWing },
+  { "swordfish", ApplySwordfish },
+};
+
+static uint32_t& SelectedDeductionStrategies()
+{
+  static uint32_t selected_strategies = 0;
+  return selected_strategies;
+}
+
+// --- Pubic Interface --- //
+const DeductionStrategy& GetDeductionStrategy(int index)
+{
+  return kDeductionStrategies[index];
+}
+
+uint32_t GetDeductionStrategies()
+{
+  return SelectedDeductionStrategies();
+}
+
+bool SelectDeductionStrategies(const char* names)
+{
+  if(std::strcmp(names, "all") == 0 || std::strcmp(names, "none") == 0)
+  {
+    SelectedDeductionStrategies() = (names[0] == 'a') ? kAllDeductionStrategies : 0;
+    return true;
+  }
+
+  uint32_t strategies = 0;
+  const char* name = names;
+  while(*name != '\0')
+  {
+    const char* name_end = std::strchr(name, ',');
+    size_t name_length = (name_end != nullptr) ? static_cast<size_t>(name_end - name) : std::strlen(name);
+
+    int index = 0;
+    while(index < kDeductionStrategyCount && (std::strlen(kDeductionStrategies[index]._name) != name_length || std::strncmp(kDeductionStrategies[index]._name, name, name_length) != 0))
+    {
+      ++index;
+    }
+    if(index == kDeductionStrategyCount)
+    {
+      return false;
+    }
+
+    strategies |= 1u << index;
+    name += name_length + ((name_end != nullptr) ? 1 : 0);
+  }
+
+  SelectedDeductionStrategies() = strategies;
+  return true;
+}
+
+} // namespace Sudoku
@@ -0,0 +1,80 @@
+#include "GridRenderer.h"
+
+#include <cstring>
+
+namespace Sudoku
+{
+
+// --- Pubic Interface --- //
+size_t GridRenderer::RenderBoxed(const int* values, int size, char* buffer)
+{
+  int box_size = 1;
+  while(box_size * box_size < size)
+  {
+    ++box_size;
+  }
+
+  char* output = buffer;
+  for(int row = 0; row < size; ++row)
+  {
+    if(row != 0 && row % box_size == 0)
+    {
+      for(int col = 0; col < size; ++col)
+      {
+        if(col != 0 && col % box_size == 0)
+        {
+          std::memcpy(output, " | ", 3);
+          output += 3;
+        }
+        std::memcpy(output, " - ", 3);
+        output += 3;
+      }
+      *output++ = '\n';
+    }
+
+    const int* row_values = values + (row * size);
+    for(int col = 0; col < size; ++col)
+    {
+      if(col != 0 && col % box_size == 0)
+      {
+        std::memcpy(output, " | ", 3);
+        output += 3;
+      }
+
+      output[0] = '[';
+      output[1] = (row_values[col] > 0) ? ValueToChar(row_values[col]) : ' ';
+      output[2] = ']';
+      output += 3;
+    }
+    *output++ = '\n';
+  }
+
+  return static_cast<size_t>(output - buffer);
+}
+
+size_t GridRenderer::RenderCompact(const int* values, int size, char* buffer)
+{
+  int slot_count = size * size;
+  for(int slot = 0; slot < slot_count; ++slot)
+  {
+    buffer[slot] = (values[slot] > 0) ? ValueToChar(values[slot]) : '.';
+  }
+  buffer[slot_count] = '\n';
+
+  return static_cast<size_t>(slot_count) + 1;
+}
+
+size_t GridRenderer::Render(int format, const int* values, int size, char* buffer)
+{
+  switch(format)
+  {
+  case kGridFormatCompact:
+    return RenderCompact(values, size, buffer);
+  case kGridFormatBoxed:
+    return RenderBoxed(values, size, buffer);
+  default:
+    return 0;
+  }
+}
+
+} // namespace Sudoku
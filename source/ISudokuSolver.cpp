@@ -0,0 +1,365 @@
+#include "ISudokuSolver.h"
+
+#include "BasicSudokuSolver.h"
+#include "BinaryPuzzleFile.h"
+#include "CandidateBoard.h"
+#include "DancingLinksSolver.h"
+#include "DeductionStrategies.h"
+#include "GridRenderer.h"
+#include "Logger.h"
+#include "MappedFile.h"
+#include "ParallelSudokuSolver.h"
+#include "SudokuSolver.h"
+#include "ThreadUtility.h"
+
+#include <cstring>
+
+namespace Sudoku
+{
+
+// --- Pubic Interface --- //
+bool ISudokuSolver::LoadFromFile(const char* file_path)
+{
+  Utility::MappedFile file;
+  if(file.Open(file_path) == false)
+  {
+    // Couldn't open the file
+    return false;
+  }
+
+  // The lines are read where they are in the mapped file
+  const char* data = file.GetData();
+  size_t file_size = file.GetSize();
+  size_t line_start = 0;
+  int size = GetSize();
+  int values[kMaxSudokuSize * kMaxSudokuSize];
+
+  BinaryPuzzleHeader header;
+  if(BinaryPuzzleFile::ReadHeader(data, file_size, header) == true)
+  {
+    // The first record of a binary puzzle file, which has to be for a board of this size
+    if(header._size != size || file_size < kBinaryPuzzleHeaderSize + header._record_size
+      || BinaryPuzzleFile::UnpackValues(reinterpret_cast<const uint8_t*>(data + kBinaryPuzzleHeaderSize), size, header._bits_per_slot, values) == false)
+    {
+      return false;
+    }
+  }
+  else
+  {
+    for(int line = 0; line < size; ++line)
+    {
+      size_t line_end = Utility::MappedFile::FindLineStart(data, file_size, line_start + 1);
+      size_t input_length = line_end - line_start;
+      for(int index = 0; index < size; ++index)
+      {
+        int value = (static_cast<size_t>(index) < input_length) ? CharToValue(data[line_start + index], size) : kEmptySlot;
+        values[(line * size) + index] = (value > 0) ? value : kEmptySlot;
+      }
+      line_start = line_end;
+    }
+  }
+
+  LoadPuzzleValues(values);
+
+  DisplayPuzzle();
+
+  // Givens that break the rules are caught here, rather than by searching for a solution that can't exist
+  return HasValidGivens(values, size);
+}
+
+bool ISudokuSolver::Load(const char* grid)
+{
+  int size = GetSize();
+  int values[kMaxSudokuSize * kMaxSudokuSize];
+  if(ParsePuzzleLine(grid, size, values) == false)
+  {
+    return false;
+  }
+
+  LoadPuzzleValues(values);
+  return HasValidGivens(values, size);
+}
+
+void ISudokuSolver::Reset()
+{
+  int values[kMaxSudokuSize * kMaxSudokuSize];
+  for(int index = 0; index < GetSize() * GetSize(); ++index)
+  {
+    values[index] = kEmptySlot;
+  }
+
+  LoadPuzzleValues(values);
+  _stats = SolverStats();
+}
+
+int ISudokuSolver::Solve(bool is_checking_uniqueness)
+{
+  int status = SolveWithStatus(is_checking_uniqueness);
+
+  Logger::NewLine();
+  Logger::WriteLine((status == kSolveBudgetExceeded) ? "Puzzle ran out of budget, as far as it got:" : (status == kSolveUnsolvable) ? "Puzzle has no solution:" :
+    (status == kSolveMultipleSolutions) ? "Puzzle has more than one solution, the first one found:" : "Puzzle Solved:");
+  Logger::NewLine();
+  DisplayPuzzle();
+  Logger::WriteLine("Search Nodes: %llu, Backtracks: %llu", static_cast<unsigned long long>(_stats._nodes), static_cast<unsigned long long>(_stats._backtracks));
+  Logger::WriteLine("Naked Singles: %llu, Hidden Singles: %llu, Guesses: %llu, Max Depth: %llu, Propagation Rounds: %llu", static_cast<unsigned long long>(_stats._naked_singles),
+    static_cast<unsigned long long>(_stats._hidden_singles), static_cast<unsigned long long>(_stats._guesses), static_cast<unsigned long long>(_stats._max_depth),
+    static_cast<unsigned long long>(_stats._propagation_rounds));
+  for(int index = 0; index < kDeductionStrategyCount; ++index)
+  {
+    if(_stats._strategy_eliminations[index] > 0)
+    {
+      Logger::WriteLine("Values taken away by %s: %llu", GetDeductionStrategy(index)._name, static_cast<unsigned long long>(_stats._strategy_eliminations[index]));
+    }
+  }
+
+  return status;
+}
+
+int ISudokuSolver::SolveWithStatus(bool is_checking_uniqueness)
+{
+  // Finding a second solution is enough to know it isn't unique
+  uint64_t solution_limit = is_checking_uniqueness ? 2 : 1;
+  uint64_t solution_count = CountSolutions(solution_limit);
+  if(solution_count >= solution_limit)
+  {
+    return (solution_count > 1) ? kSolveMultipleSolutions : kSolveSolved;
+  }
+
+  // Running out of budget leaves it unknown whether there's a solution, or a second one
+  if(_is_budget_exceeded == true)
+  {
+    return kSolveBudgetExceeded;
+  }
+
+  return (solution_count == 0) ? kSolveUnsolvable : kSolveSolved;
+}
+
+void ISudokuSolver::SetBudget(uint64_t node_limit, uint64_t time_limit)
+{
+  _node_limit = node_limit;
+  _time_limit = time_limit;
+}
+
+void SolverStats::Add(const SolverStats& other)
+{
+  _nodes += other._nodes;
+  _guesses += other._guesses;
+  _backtracks += other._backtracks;
+  _max_depth = (other._max_depth > _max_depth) ? other._max_depth : _max_depth;
+  _propagation_rounds += other._propagation_rounds;
+  _naked_singles += other._naked_singles;
+  _hidden_singles += other._hidden_singles;
+  _eliminations += other._eliminations;
+  for(int index = 0; index < kDeductionStrategyCount; ++index)
+  {
+    _strategy_eliminations[index] += other._strategy_eliminations[index];
+  }
+}
+
+void SolverStats::Subtract(const SolverStats& earlier)
+{
+  _nodes -= earlier._nodes;
+  _guesses -= earlier._guesses;
+  _backtracks -= earlier._backtracks;
+  _propagation_rounds -= earlier._propagation_rounds;
+  _naked_singles -= earlier._naked_singles;
+  _hidden_singles -= earlier._hidden_singles;
+  _eliminations -= earlier._eliminations;
+  for(int index = 0; index < kDeductionStrategyCount; ++index)
+  {
+    _strategy_eliminations[index] -= earlier._strategy_eliminations[index];
+  }
+}
+
+void ISudokuSolver::LoadPuzzleValues(const int* values)
+{
+  int puzzle[kSudokuSize][kSudokuSize];
+  for(int index = 0; index < kSudokuSize * kSudokuSize; ++index)
+  {
+    puzzle[index / kSudokuSize][index % kSudokuSize] = values[index];
+  }
+
+  LoadPuzzle(puzzle);
+}
+
+std::unique_ptr<ISudokuSolver> CreateSolver(const char* engine_name, int size, int solver_count)
+{
+  if(size != kSudokuSize)
+  {
+    if(std::strcmp(engine_name, kBacktrackingEngineName) != 0)
+    {
+      return nullptr;
+    }
+
+    switch(size)
+    {
+    case 4:
+      return std::unique_ptr<ISudokuSolver>(new BasicSudokuSolver<2>());
+    case 16:
+      return std::unique_ptr<ISudokuSolver>(new BasicSudokuSolver<4>());
+    case 25:
+      return std::unique_ptr<ISudokuSolver>(new BasicSudokuSolver<5>());
+    default:
+      return nullptr;
+    }
+  }
+
+  if(std::strcmp(engine_name, kBacktrackingEngineName) == 0 || std::strcmp(engine_name, kBitSlicedEngineName) == 0)
+  {
+    return std::unique_ptr<ISudokuSolver>(new SudokuSolver());
+  }
+
+  if(std::strcmp(engine_name, kDancingLinksEngineName) == 0)
+  {
+    return std::unique_ptr<ISudokuSolver>(new DancingLinksSolver());
+  }
+
+  if(std::strcmp(engine_name, kParallelEngineName) == 0)
+  {
+    // Solvers running side by side share the hardware threads rather than each starting a thread for every one
+    int thread_count = Utility::GetHardwareThreadCount() / ((solver_count > 0) ? solver_count : 1);
+    return std::unique_ptr<ISudokuSolver>(new ParallelSudokuSolver((thread_count > 0) ? thread_count : 1));
+  }
+
+  return nullptr;
+}
+
+int CharToValue(char c, int size)
+{
+  if(c == '.' || c == '0' || c == '*')
+  {
+    return kEmptySlot;
+  }
+
+  int value = 0;
+  if(c >= '1' && c <= '9')
+  {
+    value = c - '0';
+  }
+  else if(c >= 'A' && c <= 'Z')
+  {
+    value = c - 'A' + 10;
+  }
+  else if(c >= 'a' && c <= 'z')
+  {
+    value = c - 'a' + 10;
+  }
+
+  return (value <= size) ? value : 0;
+}
+
+int GetPuzzleLineSize(const char* line, size_t length)
+{
+  for(int box_size = kMinBoxSize; box_size <= kMaxBoxSize; ++box_size)
+  {
+    size_t puzzle_length = static_cast<size_t>(box_size * box_size * box_size * box_size);
+    if(length < puzzle_length)
+    {
+      break;
+    }
+
+    // Anything after the puzzle has to be separated from it, so longer rows of values aren't mistaken for a smaller puzzle
+    if(length == puzzle_length || line[puzzle_length] == ' ' || line[puzzle_length] == '\t' || line[puzzle_length] == ',' || line[puzzle_length] == '\r')
+    {
+      return box_size * box_size;
+    }
+  }
+
+  return 0;
+}
+
+bool ParsePuzzleLine(const char* line, int size, int* values)
+{
+  if(size == kSudokuSize)
+  {
+    // The common size is decoded with SIMD compares
+    return GetCandidateKernels().DecodePuzzleLine(line, values);
+  }
+
+  for(int index = 0; index < size * size; ++index)
+  {
+    values[index] = CharToValue(line[index], size);
+    if(values[index] == 0)
+    {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+bool HasValidGivens(const int* values, int size)
+{
+  // Values used by every row, column and group so far
+  uint32_t row_values[kMaxSudokuSize] = {};
+  uint32_t column_values[kMaxSudokuSize] = {};
+  uint32_t group_values[kMaxSudokuSize] = {};
+  int box_size = (size == 4) ? 2 : (size == 9) ? 3 : (size == 16) ? 4 : 5;
+
+  uint32_t repeated_values = 0;
+  for(int index = 0; index < size * size; ++index)
+  {
+    if(values[index] == kEmptySlot)
+    {
+      continue;
+    }
+
+    int row = index / size;
+    int column = index % size;
+    int group = ((row / box_size) * box_size) + (column / box_size);
+    uint32_t mask = 1u << (values[index] - 1);
+    repeated_values |= (row_values[row] | column_values[column] | group_values[group]) & mask;
+    row_values[row] |= mask;
+    column_values[column] |= mask;
+    group_values[group] |= mask;
+  }
+
+  return repeated_values == 0;
+}
+
+// --- Protected Interface --- //
+void ISudokuSolver::DisplayPuzzle() const
+{
+  // Quiet runs skip rendering entirely
+  if(Logger::IsEnabled(kLogLevelInfo) == false)
+  {
+    return;
+  }
+
+  int size = GetSize();
+  int values[kMaxSudokuSize * kMaxSudokuSize];
+  for(int index = 0; index < size * size; ++index)
+  {
+    values[index] = GetValue(index / size, index % size);
+  }
+
+  char grid[kMaxBoxedGridLength];
+  Logger::WriteText(grid, GridRenderer::RenderBoxed(values, size, grid));
+}
+
+void ISudokuSolver::StartBudget()
+{
+  _is_budget_exceeded = false;
+  _next_budget_check = (_node_limit != 0) ? _node_limit : UINT64_MAX;
+  if(_time_limit != 0)
+  {
+    _deadline = std::chrono::steady_clock::now() + std::chrono::microseconds(_time_limit);
+    _next_budget_check = (_next_budget_check < kBudgetCheckNodes) ? _next_budget_check : kBudgetCheckNodes;
+  }
+}
+
+bool ISudokuSolver::CheckBudget()
+{
+  // Once out of budget the check stays due, so every node after it stops too
+  if(_is_budget_exceeded == false)
+  {
+    _is_budget_exceeded = (_node_limit != 0 && _stats._nodes >= _node_limit) || (_time_limit != 0 && std::chrono::steady_clock::now() >= _deadline);
+    _next_budget_check = _stats._nodes + kBudgetCheckNodes;
+    _next_budget_check = (_node_limit != 0 && _node_limit < _next_budget_check) ? _node_limit : _next_budget_check;
+  }
+
+  return _is_budget_exceeded;
+}
+
+} // namespace Sudoku
@@ -1,45 +1,313 @@
 #include "Logger.h"
 
+#include <condition_variable>
 #include <cstdarg>
-#include <iostream>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <thread>
+#include <vector>
 
 namespace Sudoku
 {
 // --- Constants
-#define BUFFER_SIZE 1024
+//! Messages waiting to be written, a power of 2
+#define kLogRingEntries 1024
+//! Longest message an entry holds, longer ones wait for the ring to drain and are written straight away
+#define kLogEntryTextSize 240
 
-// --- Macros
-#define LogToConsole(message) std::cout << message;
+//! One formatted message, its sequence says whether it's waiting to be filled, waiting to be written, or free for the next lap of the ring
+struct LogEntry
+{
+  std::atomic<uint64_t> _sequence;
+  FILE* _stream;
+  size_t _length;
+  char _text[kLogEntryTextSize];
+};
+
+std::atomic<int> Logger::_level(kLogLevelInfo);
+
+static LogEntry s_entries[kLogRingEntries];
+//! Next position a message will be claimed at
+static std::atomic<uint64_t> s_write_position(0);
+//! Only touched by the writer
+static uint64_t s_read_position = 0;
+//! Every message before this position has been written out
+static std::atomic<uint64_t> s_written_position(0);
+
+static std::once_flag s_writer_started;
+static std::thread s_writer_thread;
+static std::mutex s_writer_mutex;
+static std::condition_variable s_writer_condition;
+static std::atomic<bool> s_is_writer_waiting(false);
+static std::atomic<bool> s_is_stopping(false);
+//! Set once the writer has been stopped at exit
+static std::atomic<bool> s_is_stopped(false);
+
+static bool IsRingEmpty()
+{
+  return s_entries[s_read_position & (kLogRingEntries - 1)]._sequence.load(std::memory_order_acquire) != s_read_position + 1;
+}
+
+static void WakeWriter()
+{
+  // Pairs with the fence in the writer, either it sees the new message or this sees that it's waiting
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if(s_is_writer_waiting.load(std::memory_order_relaxed) == true)
+  {
+    std::lock_guard<std::mutex> lock(s_writer_mutex);
+    s_writer_condition.notify_one();
+  }
+}
 
-#define LogFormatToConsole(format)\
-        va_list arguments;\
-        va_start(arguments, format);\
-        vprintf_s(format, arguments);\
-        va_end(arguments);
+static void RunWriter()
+{
+  for(;;)
+  {
+    while(IsRingEmpty() == false)
+    {
+      LogEntry& entry = s_entries[s_read_position & (kLogRingEntries - 1)];
+      std::fwrite(entry._text, 1, entry._length, entry._stream);
+      entry._sequence.store(s_read_position + kLogRingEntries, std::memory_order_release);
+      ++s_read_position;
+      s_written_position.store(s_read_position, std::memory_order_release);
+    }
+
+    // Caught up, so push it all out before waiting
+    std::fflush(stdout);
+    std::fflush(stderr);
+
+    std::unique_lock<std::mutex> lock(s_writer_mutex);
+    s_is_writer_waiting.store(true, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    while(IsRingEmpty() == true && s_is_stopping.load(std::memory_order_relaxed) == false)
+    {
+      s_writer_condition.wait(lock);
+    }
+    s_is_writer_waiting.store(false, std::memory_order_relaxed);
+
+    if(IsRingEmpty() == true && s_is_stopping.load(std::memory_order_relaxed) == true)
+    {
+      return;
+    }
+  }
+}
+
+//! Registered with atexit when the writer starts
+static void StopWriter()
+{
+  Logger::Flush();
 
+  {
+    std::lock_guard<std::mutex> lock(s_writer_mutex);
+    s_is_stopping = true;
+    s_writer_condition.notify_one();
+  }
+  s_writer_thread.join();
+  s_is_stopped = true;
+}
+
+static void StartWriter()
+{
+  // Each entry is first free at its own position
+  for(uint64_t position = 0; position < kLogRingEntries; ++position)
+  {
+    s_entries[position]._sequence.store(position, std::memory_order_relaxed);
+  }
+
+  s_writer_thread = std::thread(RunWriter);
+  std::atexit(StopWriter);
+}
+
+static void EnqueueText(FILE* stream, const char* text, size_t length)
+{
+  if(s_is_stopped.load(std::memory_order_acquire) == true)
+  {
+    std::fwrite(text, 1, length, stream);
+    return;
+  }
+
+  std::call_once(s_writer_started, StartWriter);
+
+  uint64_t position = s_write_position.load(std::memory_order_relaxed);
+  for(;;)
+  {
+    LogEntry& entry = s_entries[position & (kLogRingEntries - 1)];
+    uint64_t sequence = entry._sequence.load(std::memory_order_acquire);
+    if(sequence == position)
+    {
+      if(s_write_position.compare_exchange_weak(position, position + 1, std::memory_order_relaxed) == true)
+      {
+        break;
+      }
+    }
+    else if(sequence < position)
+    {
+      // The ring is full, wait for the writer to free up this entry
+      WakeWriter();
+      std::this_thread::yield();
+      position = s_write_position.load(std::memory_order_relaxed);
+    }
+    else
+    {
+      // Another thread claimed it first
+      position = s_write_position.load(std::memory_order_relaxed);
+    }
+  }
+
+  LogEntry& entry = s_entries[position & (kLogRingEntries - 1)];
+  entry._stream = stream;
+  entry._length = length;
+  std::memcpy(entry._text, text, length);
+  entry._sequence.store(position + 1, std::memory_order_release);
+
+  WakeWriter();
+}
+
+static void EnqueueLongText(FILE* stream, const char* text, size_t length)
+{
+  // Too long for an entry, so keep it in order by writing it once everything before it is out
+  Logger::Flush();
+  std::fwrite(text, 1, length, stream);
+}
+
+static void EnqueueFormat(FILE* stream, bool add_newline, const char* format, va_list arguments)
+{
+  char text[kLogEntryTextSize];
+  va_list measure_arguments;
+  va_copy(measure_arguments, arguments);
+  int length = std::vsnprintf(text, kLogEntryTextSize, format, measure_arguments);
+  va_end(measure_arguments);
+  if(length < 0)
+  {
+    return;
+  }
+
+  if(static_cast<size_t>(length) + 1 < kLogEntryTextSize)
+  {
+    if(add_newline == true)
+    {
+      text[length++] = '\n';
+    }
+    EnqueueText(stream, text, static_cast<size_t>(length));
+    return;
+  }
+
+  std::vector<char> long_text(static_cast<size_t>(length) + 2);
+  std::vsnprintf(long_text.data(), long_text.size(), format, arguments);
+  if(add_newline == true)
+  {
+    long_text[length++] = '\n';
+  }
+  EnqueueLongText(stream, long_text.data(), static_cast<size_t>(length));
+}
+
+// --- Pubic Interface --- //
 void Logger::Write(const char* format, ...)
 {
-  LogFormatToConsole(format);
+  if(IsEnabled(kLogLevelInfo) == false)
+  {
+    return;
+  }
+
+  va_list arguments;
+  va_start(arguments, format);
+  EnqueueFormat(stdout, false, format, arguments);
+  va_end(arguments);
 }
 
 void Logger::WriteLine(const char* format, ...)
 {
-  LogFormatToConsole(format);
+  if(IsEnabled(kLogLevelInfo) == false)
+  {
+    return;
+  }
+
+  va_list arguments;
+  va_start(arguments, format);
+  EnqueueFormat(stdout, true, format, arguments);
+  va_end(arguments);
+}
+
+void Logger::WriteText(const char* text, size_t length)
+{
+  if(IsEnabled(kLogLevelInfo) == false)
+  {
+    return;
+  }
+
+  if(length < kLogEntryTextSize)
+  {
+    EnqueueText(stdout, text, length);
+  }
+  else
+  {
+    EnqueueLongText(stdout, text, length);
+  }
+}
+
+void Logger::WriteErrorLine(const char* format, ...)
+{
+  va_list arguments;
+  va_start(arguments, format);
+  EnqueueFormat(stderr, true, format, arguments);
+  va_end(arguments);
 
-  LogToConsole(std::endl);
+  Flush();
 }
 
 void Logger::NewLine()
 {
-  LogToConsole(std::endl);
+  NewLine(1);
 }
 
 void Logger::NewLine(int count)
 {
+  if(IsEnabled(kLogLevelInfo) == false)
+  {
+    return;
+  }
+
   for(int i = 0; i < count; ++i)
   {
-    LogToConsole(std::endl);
+    EnqueueText(stdout, "\n", 1);
   }
 }
 
+void Logger::Flush()
+{
+  if(s_is_stopped.load(std::memory_order_acquire) == true)
+  {
+    std::fflush(stdout);
+    std::fflush(stderr);
+    return;
+  }
+
+  uint64_t target_position = s_write_position.load(std::memory_order_acquire);
+  while(s_written_position.load(std::memory_order_acquire) < target_position)
+  {
+    WakeWriter();
+    std::this_thread::yield();
+  }
+
+  std::fflush(stdout);
+  std::fflush(stderr);
+}
+
+bool Logger::SetLevel(const char* level_name)
+{
+  static const char* const level_names[] = { "error", "info", "debug", "trace" };
+  for(int level = kLogLevelError; level <= kLogLevelTrace; ++level)
+  {
+    if(std::strcmp(level_name, level_names[level]) == 0)
+    {
+      SetLevel(level);
+      return true;
+    }
+  }
+
+  return false;
+}
+
 } // namepsace Sudoku
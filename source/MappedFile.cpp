@@ -0,0 +1,141 @@
+#include "MappedFile.h"
+
+#include <cstring>
+
+#if defined(_WIN32)
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace Utility
+{
+
+MappedFile::~MappedFile()
+{
+  Close();
+}
+
+// --- Pubic Interface --- //
+bool MappedFile::Open(const char* file_path)
+{
+  Close();
+
+#if defined(_WIN32)
+  HANDLE file_handle = CreateFileA(file_path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+  if(file_handle == INVALID_HANDLE_VALUE)
+  {
+    return false;
+  }
+  _file_handle = file_handle;
+
+  LARGE_INTEGER file_size;
+  if(GetFileSizeEx(file_handle, &file_size) == FALSE)
+  {
+    Close();
+    return false;
+  }
+  if(file_size.QuadPart == 0)
+  {
+    // Empty files can't be mapped
+    return true;
+  }
+
+  _mapping_handle = CreateFileMappingA(file_handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+  if(_mapping_handle == nullptr)
+  {
+    Close();
+    return false;
+  }
+
+  _data = static_cast<const char*>(MapViewOfFile(_mapping_handle, FILE_MAP_READ, 0, 0, 0));
+  if(_data == nullptr)
+  {
+    Close();
+    return false;
+  }
+  _size = static_cast<size_t>(file_size.QuadPart);
+#else
+  _file_descriptor = open(file_path, O_RDONLY);
+  if(_file_descriptor < 0)
+  {
+    return false;
+  }
+
+  struct stat file_status;
+  if(fstat(_file_descriptor, &file_status) != 0 || S_ISREG(file_status.st_mode) == false)
+  {
+    Close();
+    return false;
+  }
+  if(file_status.st_size == 0)
+  {
+    // Empty files can't be mapped
+    return true;
+  }
+
+  void* data = mmap(nullptr, static_cast<size_t>(file_status.st_size), PROT_READ, MAP_PRIVATE, _file_descriptor, 0);
+  if(data == MAP_FAILED)
+  {
+    Close();
+    return false;
+  }
+  _data = static_cast<const char*>(data);
+  _size = static_cast<size_t>(file_status.st_size);
+
+  // The file is read front to back once
+  madvise(data, _size, MADV_SEQUENTIAL);
+#endif
+
+  return true;
+}
+
+void MappedFile::Close()
+{
+#if defined(_WIN32)
+  if(_data != nullptr)
+  {
+    UnmapViewOfFile(_data);
+  }
+  if(_mapping_handle != nullptr)
+  {
+    CloseHandle(_mapping_handle);
+    _mapping_handle = nullptr;
+  }
+  if(_file_handle != nullptr)
+  {
+    CloseHandle(_file_handle);
+    _file_handle = nullptr;
+  }
+#else
+  if(_data != nullptr)
+  {
+    munmap(const_cast<char*>(_data), _size);
+  }
+  if(_file_descriptor >= 0)
+  {
+    close(_file_descriptor);
+    _file_descriptor = -1;
+  }
+#endif
+
+  _data = nullptr;
+  _size = 0;
+}
+
+size_t MappedFile::FindLineStart(const char* data, size_t size, size_t offset)
+{
+  if(offset == 0 || offset >= size)
+  {
+    return (offset == 0) ? 0 : size;
+  }
+
+  // offset is a line start if the character before it ends a line
+  const char* line_end = static_cast<const char*>(std::memchr(data + offset - 1, '\n', size - (offset - 1)));
+  return (line_end == nullptr) ? size : static_cast<size_t>(line_end - data) + 1;
+}
+
+} // namespace Utility
@@ -0,0 +1,209 @@
+#include "ParallelSudokuSolver.h"
+
+#include "PerformanceScopeTimer.h"
+
+namespace Sudoku
+{
+
+ParallelSudokuSolver::ParallelSudokuSolver(int thread_count)
+  : _thread_count(thread_count > 0 ? thread_count : 1)
+  , _is_cancelled(false)
+  , _found_solution_count(0)
+{
+  _workers.reset(new Worker[_thread_count]);
+  for(int i = 0; i < _thread_count; ++i)
+  {
+    _workers[i]._solver.reset(new SudokuSolver());
+    _workers[i]._solver->SetCancelFlag(&_is_cancelled);
+  }
+
+  // Splitting stops once there are kSearchPathsPerThread paths for every thread, and each guess adds at most kSudokuSize branches
+  int queue_capacity = (kSearchPathsPerThread * kSudokuSize) + 1;
+  _search_paths.reserve(_thread_count * queue_capacity);
+  if(_thread_count == 1)
+  {
+    // A single thread searches the branches itself, without a worker of its own
+    return;
+  }
+  _thread_pool.reset(new Utility::WorkStealingThreadPool<SudokuSolver::SearchPath>(_thread_count, queue_capacity, false, [this](int worker_index, SudokuSolver::SearchPath* search_path)
+  {
+    SearchBranch(worker_index, search_path);
+  }));
+}
+
+ParallelSudokuSolver::~ParallelSudokuSolver()
+{
+  // Stop the workers before the solvers they use go away
+  _thread_pool.reset();
+}
+
+// --- Pubic Interface --- //
+void ParallelSudokuSolver::LoadPuzzle(const int values[kSudokuSize][kSudokuSize])
+{
+  for(int row = 0; row < kSudokuSize; ++row)
+  {
+    for(int col = 0; col < kSudokuSize; ++col)
+    {
+      _values[row][col] = values[row][col];
+    }
+  }
+
+  // The workers are idle between searches
+  _root_solver.LoadPuzzle(values);
+  for(int i = 0; i < _thread_count; ++i)
+  {
+    _workers[i]._solver->LoadPuzzle(values);
+  }
+}
+
+bool ParallelSudokuSolver::SolvePuzzle()
+{
+  return CountSolutions(1) > 0;
+}
+
+uint64_t ParallelSudokuSolver::CountSolutions(uint64_t solution_limit)
+{
+  StartBudget();
+  ++_search_id;
+  _solution_limit = solution_limit;
+  _is_cancelled = false;
+  _found_solution_count = 0;
+  _has_solution = false;
+  for(int i = 0; i < _thread_count; ++i)
+  {
+    _workers[i]._solution_count = 0;
+  }
+
+  // Split the top of the search tree until every thread has enough branches to work on
+  _search_paths.clear();
+  if(_root_solver.PrepareSearch() == true)
+  {
+    TimePerformanceScope("CollectSearchPaths");
+    size_t target_path_count = static_cast<size_t>(_thread_count) * kSearchPathsPerThread;
+    for(int depth = 1; depth <= kMaxSplitDepth; ++depth)
+    {
+      size_t previous_path_count = _search_paths.size();
+      _root_solver.CollectSearchPaths(depth, _search_paths);
+      if(_search_paths.size() >= target_path_count || _search_paths.size() == previous_path_count)
+      {
+        // Either there's enough work, or every branch was solved or ruled out before reaching this depth
+        break;
+      }
+    }
+  }
+
+  _stats = _root_solver.GetStats();
+
+  if(_search_paths.empty() == true)
+  {
+    return 0;
+  }
+
+  _remaining_path_count = _search_paths.size();
+  for(SudokuSolver::SearchPath& search_path : _search_paths)
+  {
+    if(_thread_pool == nullptr)
+    {
+      SearchBranch(0, &search_path);
+      continue;
+    }
+    _thread_pool->Submit(&search_path);
+  }
+
+  {
+    TimePerformanceScope("WaitForBranches");
+    std::unique_lock<std::mutex> lock(_search_mutex);
+    _search_finished_condition.wait(lock, [this]() { return _remaining_path_count == 0; });
+  }
+
+  uint64_t solution_count = 0;
+  for(int i = 0; i < _thread_count; ++i)
+  {
+    solution_count += _workers[i]._solution_count;
+    if(_workers[i]._search_id == _search_id)
+    {
+      // A worker's solver keeps counting across every branch it searched since it was prepared, only the branches are added
+      SolverStats branch_stats = _workers[i]._solver->GetStats();
+      branch_stats.Subtract(_workers[i]._prepared_stats);
+      _stats.Add(branch_stats);
+      _is_budget_exceeded = _is_budget_exceeded == true || _workers[i]._solver->IsBudgetExceeded() == true;
+    }
+  }
+
+  // Branches that were already running can finish past the limit before they see the cancel
+  if(_solution_limit != 0 && solution_count > _solution_limit)
+  {
+    solution_count = _solution_limit;
+  }
+
+  return solution_count;
+}
+
+void ParallelSudokuSolver::SetBudget(uint64_t node_limit, uint64_t time_limit)
+{
+  ISudokuSolver::SetBudget(node_limit, time_limit);
+
+  // Every worker gets its share of the nodes, at least one so a limit stays a limit
+  uint64_t worker_node_limit = node_limit / _thread_count;
+  worker_node_limit = (node_limit != 0 && worker_node_limit == 0) ? 1 : worker_node_limit;
+  for(int i = 0; i < _thread_count; ++i)
+  {
+    _workers[i]._solver->SetBudget(worker_node_limit, time_limit);
+  }
+}
+
+// --- Private Interface --- //
+void ParallelSudokuSolver::SearchBranch(int worker_index, SudokuSolver::SearchPath* search_path)
+{
+  Worker& worker = _workers[worker_index];
+  if(_is_cancelled == false)
+  {
+    if(worker._search_id != _search_id)
+    {
+      worker._search_id = _search_id;
+      worker._is_prepared = worker._solver->PrepareSearch();
+      worker._prepared_stats = worker._solver->GetStats();
+    }
+
+    if(worker._is_prepared == true)
+    {
+      uint64_t solution_count = worker._solver->SearchFromPath(*search_path, _solution_limit);
+      worker._solution_count += solution_count;
+
+      if(solution_count > 0)
+      {
+        {
+          std::lock_guard<std::mutex> lock(_search_mutex);
+          if(_has_solution == false)
+          {
+            _has_solution = true;
+            worker._solver->CopySolution(_values);
+          }
+        }
+
+        if(_solution_limit != 0 && _found_solution_count.fetch_add(solution_count) + solution_count >= _solution_limit)
+        {
+          _is_cancelled = true;
+        }
+      }
+
+      if(worker._solver->IsBudgetExceeded() == true)
+      {
+        // Out of budget, so the rest of the search is too
+        _is_cancelled = true;
+      }
+    }
+  }
+
+  bool is_finished = false;
+  {
+    std::lock_guard<std::mutex> lock(_search_mutex);
+    is_finished = (--_remaining_path_count == 0);
+  }
+  if(is_finished == true)
+  {
+    _search_finished_condition.notify_one();
+  }
+}
+
+} // namespace Sudoku
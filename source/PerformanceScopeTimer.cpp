@@ -2,24 +2,274 @@
 
 #include "Logger.h"
 
-#include <Windows.h>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
 
 namespace Utility
 {
 
+// --- Constants
+//! Index of the node every thread's outermost scopes hang off
+#define kRootScopeNode 0
+#define kNoScopeNode -1
+
+//! A scope name at one place in the nesting, the same name under different parents gets its own node
+struct ScopeNode
+{
+  const char* _name;
+  int _parent;
+  int _first_child;
+  int _next_sibling;
+  uint64_t _count;
+  uint64_t _total_ns;
+  uint64_t _max_ns;
+};
+
+//! One finished scope, kept for the Chrome trace
+struct TraceEvent
+{
+  const char* _name;
+  uint64_t _start_ns;
+  uint64_t _duration_ns;
+};
+
+//! Everything one thread has recorded, only ever touched by that thread until the results are written at exit
+struct PerformanceScopeTimer::ThreadTimers
+{
+  int _thread_index = 0;
+  std::vector<ScopeNode> _nodes;
+  int _current_node = kRootScopeNode;
+  std::vector<TraceEvent> _trace_events;
+};
+
+//! The merged timings of a scope across every thread
+struct ScopeSummary
+{
+  std::string _name;
+  uint64_t _count = 0;
+  uint64_t _total_ns = 0;
+  uint64_t _max_ns = 0;
+  std::vector<ScopeSummary> _children;
+};
+
+static std::atomic<bool> s_is_enabled(false);
+static bool s_is_tracing = false;
+static std::string s_trace_file_path;
+static std::chrono::steady_clock::time_point s_start_time = std::chrono::steady_clock::now();
+//! The timers of every thread that has timed a scope, kept alive after their threads exit
+static std::mutex s_registry_mutex;
+static std::vector<std::shared_ptr<PerformanceScopeTimer::ThreadTimers>> s_thread_timers;
+
+static uint64_t GetElapsedNs()
+{
+  return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - s_start_time).count());
+}
+
+static void MergeScopes(const std::vector<ScopeNode>& nodes, int parent, ScopeSummary& summary)
+{
+  // New children go on the front of the list, so walk it backwards to keep the order they first ran in
+  std::vector<int> children;
+  for(int child = nodes[parent]._first_child; child != kNoScopeNode; child = nodes[child]._next_sibling)
+  {
+    children.push_back(child);
+  }
+
+  for(auto child_iter = children.rbegin(); child_iter != children.rend(); ++child_iter)
+  {
+    int child = *child_iter;
+    const ScopeNode& node = nodes[child];
+    ScopeSummary* child_summary = nullptr;
+    for(ScopeSummary& existing : summary._children)
+    {
+      if(existing._name == node._name)
+      {
+        child_summary = &existing;
+        break;
+      }
+    }
+    if(child_summary == nullptr)
+    {
+      summary._children.emplace_back();
+      child_summary = &summary._children.back();
+      child_summary->_name = node._name;
+    }
+
+    child_summary->_count += node._count;
+    child_summary->_total_ns += node._total_ns;
+    child_summary->_max_ns = (node._max_ns > child_summary->_max_ns) ? node._max_ns : child_summary->_max_ns;
+    MergeScopes(nodes, child, *child_summary);
+  }
+}
+
+static void WriteScopeSummary(const ScopeSummary& summary, int depth)
+{
+  for(const ScopeSummary& child : summary._children)
+  {
+    Sudoku::Logger::WriteErrorLine("%*s%-*s %12llu %14.3f %14.3f %14.3f", depth * 2, "", 40 - (depth * 2), child._name.c_str(), static_cast<unsigned long long>(child._count),
+      child._total_ns / 1000000.0, (child._total_ns / 1000.0) / child._count, child._max_ns / 1000.0);
+    WriteScopeSummary(child, depth + 1);
+  }
+}
+
+// --- Pubic Interface --- //
 PerformanceScopeTimer::PerformanceScopeTimer(const char* scope_name)
+  : _thread_timers(nullptr)
+{
+  if(s_is_enabled.load(std::memory_order_relaxed) == false)
+  {
+    return;
+  }
+
+  ThreadTimers& timers = GetThreadTimers();
+
+  // Scopes are found by their name under the current scope, the pointers of string literals usually match so the compare is rarely needed
+  int node_index = timers._nodes[timers._current_node]._first_child;
+  while(node_index != kNoScopeNode && timers._nodes[node_index]._name != scope_name && std::strcmp(timers._nodes[node_index]._name, scope_name) != 0)
+  {
+    node_index = timers._nodes[node_index]._next_sibling;
+  }
+
+  if(node_index == kNoScopeNode)
+  {
+    node_index = static_cast<int>(timers._nodes.size());
+    int next_sibling = timers._nodes[timers._current_node]._first_child;
+    timers._nodes.push_back({ scope_name, timers._current_node, kNoScopeNode, next_sibling, 0, 0, 0 });
+    timers._nodes[timers._current_node]._first_child = node_index;
+  }
+
+  _thread_timers = &timers;
+  _node_index = node_index;
+  timers._current_node = node_index;
+  _start_ns = GetElapsedNs();
+}
+
+PerformanceScopeTimer::~PerformanceScopeTimer()
 {
-  _scope_name = scope_name;
-  _start_time = GetTickCount64();
+  if(_thread_timers == nullptr)
+  {
+    return;
+  }
+
+  uint64_t duration_ns = GetElapsedNs() - _start_ns;
+
+  ScopeNode& node = _thread_timers->_nodes[_node_index];
+  ++node._count;
+  node._total_ns += duration_ns;
+  node._max_ns = (duration_ns > node._max_ns) ? duration_ns : node._max_ns;
+  _thread_timers->_current_node = node._parent;
+
+  if(s_is_tracing == true)
+  {
+    _thread_timers->_trace_events.push_back({ node._name, _start_ns, duration_ns });
+  }
+}
+
+void PerformanceScopeTimer::Enable(const char* trace_file_path)
+{
+  if(s_is_enabled.exchange(true) == true)
+  {
+    return;
+  }
+
+  if(trace_file_path != nullptr)
+  {
+    s_trace_file_path = trace_file_path;
+    s_is_tracing = true;
+  }
+
+  std::atexit(WriteResults);
+}
+
+bool PerformanceScopeTimer::IsEnabled()
+{
+  return s_is_enabled.load(std::memory_order_relaxed);
+}
+
+// --- Private Interface --- //
+PerformanceScopeTimer::ThreadTimers& PerformanceScopeTimer::GetThreadTimers()
+{
+  thread_local std::shared_ptr<ThreadTimers> thread_timers;
+  if(thread_timers == nullptr)
+  {
+    thread_timers = std::make_shared<ThreadTimers>();
+    thread_timers->_nodes.push_back({ "", kNoScopeNode, kNoScopeNode, kNoScopeNode, 0, 0, 0 });
+
+    std::lock_guard<std::mutex> lock(s_registry_mutex);
+    thread_timers->_thread_index = static_cast<int>(s_thread_timers.size());
+    s_thread_timers.push_back(thread_timers);
+  }
+
+  return *thread_timers;
+}
+
+void PerformanceScopeTimer::WriteResults()
+{
+  // Anything still being timed now won't be counted
+  s_is_enabled = false;
+
+  WriteSummary();
+
+  if(s_is_tracing == true && WriteChromeTrace(s_trace_file_path.c_str()) == false)
+  {
+    Sudoku::Logger::WriteErrorLine("Couldn't write the trace to \"%s\"", s_trace_file_path.c_str());
+  }
 }
 
-void PerformanceScopeTimer::ScopeComplete()
+void PerformanceScopeTimer::WriteSummary()
 {
-  uint64_t end_time = GetTickCount64();
+  std::lock_guard<std::mutex> lock(s_registry_mutex);
+
+  ScopeSummary summary;
+  for(const std::shared_ptr<ThreadTimers>& timers : s_thread_timers)
+  {
+    MergeScopes(timers->_nodes, kRootScopeNode, summary);
+  }
+
+  if(summary._children.empty() == true)
+  {
+    return;
+  }
+
+  Sudoku::Logger::WriteErrorLine("%-40s %12s %14s %14s %14s", "Scope", "Calls", "Total ms", "Mean us", "Max us");
+  WriteScopeSummary(summary, 0);
+}
+
+bool PerformanceScopeTimer::WriteChromeTrace(const char* file_path)
+{
+  FILE* file = nullptr;
+#if defined(_MSC_VER)
+  fopen_s(&file, file_path, "wb");
+#else
+  file = std::fopen(file_path, "wb");
+#endif
+  if(file == nullptr)
+  {
+    return false;
+  }
+
+  // Complete events, the timestamps are in microseconds
+  std::lock_guard<std::mutex> lock(s_registry_mutex);
+  std::fprintf(file, "{\"traceEvents\":[\n");
+  bool is_first_event = true;
+  for(const std::shared_ptr<ThreadTimers>& timers : s_thread_timers)
+  {
+    for(const TraceEvent& event : timers->_trace_events)
+    {
+      std::fprintf(file, "%s{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}", is_first_event ? "" : ",\n", event._name,
+        timers->_thread_index, event._start_ns / 1000.0, event._duration_ns / 1000.0);
+      is_first_event = false;
+    }
+  }
+  std::fprintf(file, "\n]}\n");
 
-  Sudoku::Logger::WriteLine("Start Tick: %u", _start_time);
-  Sudoku::Logger::WriteLine("End Tick: %u", end_time);
-  Sudoku::Logger::WriteLine("Scope - %s has finished (%u ms)", _scope_name.c_str(), end_time - _start_time);
+  return std::fclose(file) == 0;
 }
 
 } // namespace Utility
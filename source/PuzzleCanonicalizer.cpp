@@ -0,0 +1,350 @@
+#include "PuzzleCanonicalizer.h"
+
+#include <cstring>
+#include <utility>
+
+namespace Sudoku
+{
+
+// --- Constants
+#define kStackCount 3
+
+//! Every order of the 3 bands, stacks, or rows or columns within one
+static const uint8_t kPermutations[6][3] = { { 0, 1, 2 }, { 0, 2, 1 }, { 1, 0, 2 }, { 1, 2, 0 }, { 2, 0, 1 }, { 2, 1, 0 } };
+
+// --- Pubic Interface --- //
+PuzzleCanonicalizer::PuzzleCanonicalizer()
+  : _candidates(kMaxCanonicalCandidates),
+  _next_candidates(kMaxCanonicalCandidates)
+{
+}
+
+PuzzleCanonicalizer::~PuzzleCanonicalizer()
+{
+}
+
+bool PuzzleCanonicalizer::Canonicalize(const int values[kCanonicalSlots], CanonicalPuzzle& puzzle)
+{
+  // Relabeling assumes a value appears once in a row, column and group
+  if(HasValidGivens(values, kSudokuSize) == false)
+  {
+    return false;
+  }
+
+  // The puzzle as it is and transposed, 0 for an empty slot
+  uint8_t boards[2][kCanonicalSlots];
+  for(int slot = 0; slot < kCanonicalSlots; ++slot)
+  {
+    uint8_t value = (values[slot] > 0) ? static_cast<uint8_t>(values[slot]) : 0;
+    boards[0][slot] = value;
+    boards[1][((slot % kSudokuSize) * kSudokuSize) + (slot / kSudokuSize)] = value;
+  }
+
+  int candidate_count = 2;
+  for(int is_transposed = 0; is_transposed < 2; ++is_transposed)
+  {
+    _candidates[is_transposed] = Candidate();
+    _candidates[is_transposed]._is_transposed = is_transposed == 1;
+  }
+
+  // Each row is the one whose givens come first once the columns are sorted, out of the rest of the band or the first row of a band not used yet
+  for(int depth = 0; depth < kSudokuSize; ++depth)
+  {
+    int band_start = depth - (depth % kStackCount);
+    int next_count = 0;
+    int best_key = -1;
+    for(int index = 0; index < candidate_count; ++index)
+    {
+      const Candidate& candidate = _candidates[index];
+      const uint8_t* board = boards[candidate._is_transposed ? 1 : 0];
+      for(int row = 0; row < kSudokuSize; ++row)
+      {
+        bool is_used = false;
+        if(depth == band_start)
+        {
+          is_used = (candidate._used_bands & (1 << (row / kStackCount))) != 0;
+        }
+        else
+        {
+          is_used = row / kStackCount != candidate._rows[band_start] / kStackCount;
+          for(int i = band_start; i < depth; ++i)
+          {
+            is_used = is_used == true || candidate._rows[i] == row;
+          }
+        }
+        if(is_used == true)
+        {
+          continue;
+        }
+
+        uint16_t column_patterns[kSudokuSize];
+        for(int column = 0; column < kSudokuSize; ++column)
+        {
+          column_patterns[column] = static_cast<uint16_t>((candidate._column_patterns[column] << 1) | ((board[(row * kSudokuSize) + column] != 0) ? 1 : 0));
+        }
+
+        uint8_t order[kSudokuSize];
+        uint32_t stack_keys[kStackCount];
+        SortColumns(column_patterns, depth + 1, order, stack_keys);
+
+        // The rows above are the same for every candidate, so only this one is compared, the first column in the highest bit
+        int key = 0;
+        for(int column = 0; column < kSudokuSize; ++column)
+        {
+          key = (key << 1) | (column_patterns[order[column]] & 1);
+        }
+        if(key < best_key)
+        {
+          continue;
+        }
+        if(key > best_key)
+        {
+          best_key = key;
+          next_count = 0;
+        }
+        if(next_count == kMaxCanonicalCandidates)
+        {
+          return false;
+        }
+
+        Candidate& next_candidate = _next_candidates[next_count++];
+        next_candidate = candidate;
+        next_candidate._rows[depth] = static_cast<uint8_t>(row);
+        next_candidate._used_bands = static_cast<uint8_t>(candidate._used_bands | (1 << (row / kStackCount)));
+        std::memcpy(next_candidate._column_patterns, column_patterns, sizeof(column_patterns));
+      }
+    }
+
+    std::swap(_candidates, _next_candidates);
+    candidate_count = next_count;
+  }
+
+  // Every candidate left has the same pattern, the values pick between them and the column orders each one leaves tied
+  uint8_t best_values[kCanonicalSlots];
+  bool has_best = false;
+  _order_count = 0;
+  for(int index = 0; index < candidate_count; ++index)
+  {
+    const Candidate& candidate = _candidates[index];
+    if(PickValueOrder(candidate, boards[candidate._is_transposed ? 1 : 0], best_values, has_best, puzzle._transform) == false)
+    {
+      return false;
+    }
+  }
+
+  // Values missing from the puzzle take the labels left over
+  uint8_t next_label = 1;
+  for(int value = 1; value <= kSudokuSize; ++value)
+  {
+    next_label = static_cast<uint8_t>(next_label + ((puzzle._transform._labels[value] != 0) ? 1 : 0));
+  }
+  for(int value = 1; value <= kSudokuSize; ++value)
+  {
+    if(puzzle._transform._labels[value] == 0)
+    {
+      puzzle._transform._labels[value] = next_label++;
+    }
+  }
+
+  std::memcpy(puzzle._values, best_values, kCanonicalSlots);
+
+  // FNV-1a
+  puzzle._hash = 14695981039346656037ull;
+  for(int slot = 0; slot < kCanonicalSlots; ++slot)
+  {
+    puzzle._hash = (puzzle._hash ^ puzzle._values[slot]) * 1099511628211ull;
+  }
+
+  return true;
+}
+
+void PuzzleCanonicalizer::ToCanonical(const CanonicalTransform& transform, const int values[kCanonicalSlots], uint8_t canonical_values[kCanonicalSlots])
+{
+  for(int row = 0; row < kSudokuSize; ++row)
+  {
+    for(int column = 0; column < kSudokuSize; ++column)
+    {
+      int from_row = transform._rows[row];
+      int from_column = transform._columns[column];
+      int value = transform._is_transposed ? values[(from_column * kSudokuSize) + from_row] : values[(from_row * kSudokuSize) + from_column];
+      canonical_values[(row * kSudokuSize) + column] = (value > 0) ? transform._labels[value] : 0;
+    }
+  }
+}
+
+void PuzzleCanonicalizer::FromCanonical(const CanonicalTransform& transform, const uint8_t canonical_values[kCanonicalSlots], int values[kCanonicalSlots])
+{
+  int puzzle_values[kSudokuSize + 1] = {};
+  for(int value = 1; value <= kSudokuSize; ++value)
+  {
+    puzzle_values[transform._labels[value]] = value;
+  }
+
+  for(int row = 0; row < kSudokuSize; ++row)
+  {
+    for(int column = 0; column < kSudokuSize; ++column)
+    {
+      int from_row = transform._rows[row];
+      int from_column = transform._columns[column];
+      int slot = transform._is_transposed ? (from_column * kSudokuSize) + from_row : (from_row * kSudokuSize) + from_column;
+      uint8_t value = canonical_values[(row * kSudokuSize) + column];
+      values[slot] = (value != 0) ? puzzle_values[value] : kEmptySlot;
+    }
+  }
+}
+
+// --- Private Interface --- //
+void PuzzleCanonicalizer::SortColumns(const uint16_t column_patterns[kSudokuSize], int depth, uint8_t order[kSudokuSize], uint32_t stack_keys[kStackCount])
+{
+  // Within each stack the columns go from the most givens in the first rows to the least
+  uint8_t stack_columns[kStackCount][kStackCount];
+  uint32_t keys[kStackCount];
+  for(int stack = 0; stack < kStackCount; ++stack)
+  {
+    uint8_t* columns = stack_columns[stack];
+    for(int i = 0; i < kStackCount; ++i)
+    {
+      columns[i] = static_cast<uint8_t>((stack * kStackCount) + i);
+    }
+    for(int i = 0; i < kStackCount; ++i)
+    {
+      for(int j = i + 1; j < kStackCount; ++j)
+      {
+        if(column_patterns[columns[j]] > column_patterns[columns[i]])
+        {
+          std::swap(columns[i], columns[j]);
+        }
+      }
+    }
+
+    // The stack's givens row by row, the first row in the highest bits
+    keys[stack] = 0;
+    for(int shift = depth - 1; shift >= 0; --shift)
+    {
+      keys[stack] = (keys[stack] << 3) | (((column_patterns[columns[0]] >> shift) & 1) << 2) | (((column_patterns[columns[1]] >> shift) & 1) << 1) | ((column_patterns[columns[2]] >> shift) & 1);
+    }
+  }
+
+  uint8_t stacks[kStackCount] = { 0, 1, 2 };
+  for(int i = 0; i < kStackCount; ++i)
+  {
+    for(int j = i + 1; j < kStackCount; ++j)
+    {
+      if(keys[stacks[j]] > keys[stacks[i]])
+      {
+        std::swap(stacks[i], stacks[j]);
+      }
+    }
+  }
+
+  for(int i = 0; i < kStackCount; ++i)
+  {
+    stack_keys[i] = keys[stacks[i]];
+    for(int j = 0; j < kStackCount; ++j)
+    {
+      order[(i * kStackCount) + j] = stack_columns[stacks[i]][j];
+    }
+  }
+}
+
+bool PuzzleCanonicalizer::PickValueOrder(const Candidate& candidate, const uint8_t* board, uint8_t best_values[kCanonicalSlots], bool& has_best, CanonicalTransform& best)
+{
+  uint8_t order[kSudokuSize];
+  uint32_t stack_keys[kStackCount];
+  SortColumns(candidate._column_patterns, kSudokuSize, order, stack_keys);
+
+  // Stacks with the same pattern can swap, and so can columns of a stack with the same pattern
+  int stack_orders[6];
+  int stack_order_count = 0;
+  int column_orders[kStackCount][6];
+  int column_order_counts[kStackCount] = {};
+  for(int permutation = 0; permutation < 6; ++permutation)
+  {
+    const uint8_t* positions = kPermutations[permutation];
+    bool is_stack_tie = true;
+    for(int i = 0; i < kStackCount; ++i)
+    {
+      is_stack_tie = is_stack_tie == true && stack_keys[positions[i]] == stack_keys[i];
+    }
+    if(is_stack_tie == true)
+    {
+      stack_orders[stack_order_count++] = permutation;
+    }
+
+    for(int stack = 0; stack < kStackCount; ++stack)
+    {
+      const uint8_t* columns = order + (stack * kStackCount);
+      bool is_column_tie = true;
+      for(int i = 0; i < kStackCount; ++i)
+      {
+        is_column_tie = is_column_tie == true && candidate._column_patterns[columns[positions[i]]] == candidate._column_patterns[columns[i]];
+      }
+      if(is_column_tie == true)
+      {
+        column_orders[stack][column_order_counts[stack]++] = permutation;
+      }
+    }
+  }
+
+  for(int stack_order = 0; stack_order < stack_order_count; ++stack_order)
+  {
+    const uint8_t* stacks = kPermutations[stack_orders[stack_order]];
+    for(int first = 0; first < column_order_counts[stacks[0]]; ++first)
+    {
+      for(int second = 0; second < column_order_counts[stacks[1]]; ++second)
+      {
+        for(int third = 0; third < column_order_counts[stacks[2]]; ++third)
+        {
+          if(++_order_count > kMaxCanonicalCandidates)
+          {
+            return false;
+          }
+
+          int column_order[kStackCount] = { column_orders[stacks[0]][first], column_orders[stacks[1]][second], column_orders[stacks[2]][third] };
+          uint8_t columns[kSudokuSize];
+          for(int i = 0; i < kStackCount; ++i)
+          {
+            for(int j = 0; j < kStackCount; ++j)
+            {
+              columns[(i * kStackCount) + j] = order[(stacks[i] * kStackCount) + kPermutations[column_order[i]][j]];
+            }
+          }
+
+          // Every order has the givens in the same places, so only the relabeled values are compared, stopping as soon as this one is bigger
+          uint8_t labels[kSudokuSize + 1] = {};
+          uint8_t next_label = 1;
+          uint8_t values[kCanonicalSlots];
+          int comparison = (has_best == true) ? 0 : -1;
+          for(int slot = 0; slot < kCanonicalSlots && comparison <= 0; ++slot)
+          {
+            uint8_t value = board[(candidate._rows[slot / kSudokuSize] * kSudokuSize) + columns[slot % kSudokuSize]];
+            if(value != 0 && labels[value] == 0)
+            {
+              labels[value] = next_label++;
+            }
+            values[slot] = (value != 0) ? labels[value] : 0;
+            if(comparison == 0 && values[slot] != best_values[slot])
+            {
+              comparison = (values[slot] < best_values[slot]) ? -1 : 1;
+            }
+          }
+          if(comparison >= 0)
+          {
+            continue;
+          }
+
+          std::memcpy(best_values, values, kCanonicalSlots);
+          has_best = true;
+          best._is_transposed = candidate._is_transposed;
+          std::memcpy(best._rows, candidate._rows, sizeof(best._rows));
+          std::memcpy(best._columns, columns, sizeof(best._columns));
+          std::memcpy(best._labels, labels, sizeof(best._labels));
+        }
+      }
+    }
+  }
+
+  return true;
+}
+
+} // namespace Sudoku
@@ -0,0 +1,346 @@
+#include "PuzzleGenerator.h"
+
+#include "BinaryPuzzleFile.h"
+#include "PerformanceScopeTimer.h"
+
+#include <cstring>
+
+namespace Sudoku
+{
+
+// --- Constants
+//! Longest a generated puzzle gets written, as a line with its solution after it
+#define kGeneratedLineLength (((kSudokuSize * kSudokuSize) + 1) * 2)
+
+static const char* const kSymmetryNameList[] = kSymmetryNames;
+
+//! Returns a random number below bound, the tiny bias of the remainder doesn't matter here and keeps the sequence the same on every standard library
+static int RandomBelow(std::mt19937_64& random, int bound)
+{
+  return static_cast<int>(random() % static_cast<uint64_t>(bound));
+}
+
+//! Mixes the seed with the index of a puzzle, so neighbouring puzzles get unrelated random sequences
+static uint64_t MixSeed(uint64_t seed, uint64_t index)
+{
+  uint64_t mixed = seed + ((index + 1) * 0x9E3779B97F4A7C15ull);
+  mixed = (mixed ^ (mixed >> 30)) * 0xBF58476D1CE4E5B9ull;
+  mixed = (mixed ^ (mixed >> 27)) * 0x94D049BB133111EBull;
+  return mixed ^ (mixed >> 31);
+}
+
+//! Returns the slot that's emptied along with the given one, or the slot itself if it's emptied on its own
+static int GetSymmetricSlot(int symmetry, int slot)
+{
+  switch(symmetry)
+  {
+  case kSymmetryRotational:
+    return (kSudokuSize * kSudokuSize) - 1 - slot;
+  case kSymmetryMirror:
+    return ((slot / kSudokuSize) * kSudokuSize) + (kSudokuSize - 1 - (slot % kSudokuSize));
+  default:
+    return slot;
+  }
+}
+
+PuzzleGenerator::PuzzleGenerator(int thread_count, bool pin_threads)
+{
+  if(thread_count < 1)
+  {
+    thread_count = 1;
+  }
+
+  for(int i = 0; i < thread_count; ++i)
+  {
+    _workers.emplace_back(new Worker());
+  }
+
+  _block_count = (thread_count == 1) ? 1 : thread_count * kGeneratorBlocksPerThread;
+  _blocks.reset(new Block[_block_count]);
+  for(int i = 0; i < _block_count; ++i)
+  {
+    _blocks[i]._output.resize(kGeneratorBlockPuzzles * kGeneratedLineLength);
+  }
+
+  if(thread_count > 1)
+  {
+    _thread_pool.reset(new Utility::WorkStealingThreadPool<Block>(thread_count, _block_count, pin_threads, [this](int worker_index, Block* block)
+    {
+      GenerateBlock(worker_index, *block);
+
+      {
+        std::lock_guard<std::mutex> lock(_generated_mutex);
+        block->_is_generated = true;
+      }
+      _generated_condition.notify_one();
+    }));
+  }
+}
+
+PuzzleGenerator::~PuzzleGenerator()
+{
+  // Stop the workers before the blocks and solvers they use go away
+  _thread_pool.reset();
+}
+
+// --- Pubic Interface --- //
+bool PuzzleGenerator::Generate(uint64_t puzzle_count, FILE* output, bool is_binary)
+{
+  _results = GeneratorResults();
+  _output = output;
+  _output_failed = false;
+  _is_binary = is_binary;
+  _next_sequence = 0;
+  _next_write_sequence = 0;
+
+  std::chrono::steady_clock::time_point start_time = std::chrono::steady_clock::now();
+
+  if(_is_binary == true)
+  {
+    uint8_t header_bytes[kBinaryPuzzleHeaderSize];
+    BinaryPuzzleFile::WriteHeader(BinaryPuzzleFile::MakeHeader(kSudokuSize, _is_writing_solutions), header_bytes);
+    _output_failed = std::fwrite(header_bytes, 1, kBinaryPuzzleHeaderSize, _output) != kBinaryPuzzleHeaderSize;
+  }
+
+  for(uint64_t first_puzzle = 0; first_puzzle < puzzle_count; first_puzzle += kGeneratorBlockPuzzles)
+  {
+    uint64_t remaining_puzzles = puzzle_count - first_puzzle;
+    SubmitBlock(first_puzzle, (remaining_puzzles < kGeneratorBlockPuzzles) ? static_cast<int>(remaining_puzzles) : kGeneratorBlockPuzzles);
+  }
+  WriteGeneratedBlocks(0);
+
+  std::fflush(_output);
+
+  std::chrono::steady_clock::time_point end_time = std::chrono::steady_clock::now();
+  _results._elapsed_seconds = std::chrono::duration<double>(end_time - start_time).count();
+
+  return _output_failed == false;
+}
+
+void PuzzleGenerator::SetClueCount(int clue_count)
+{
+  _clue_count = (clue_count < kMinClueCount) ? kMinClueCount : (clue_count > kSudokuSize * kSudokuSize) ? kSudokuSize * kSudokuSize : clue_count;
+}
+
+int PuzzleGenerator::GetSymmetry(const char* symmetry_name)
+{
+  for(int symmetry = 0; symmetry < static_cast<int>(sizeof(kSymmetryNameList) / sizeof(kSymmetryNameList[0])); ++symmetry)
+  {
+    if(std::strcmp(symmetry_name, kSymmetryNameList[symmetry]) == 0)
+    {
+      return symmetry;
+    }
+  }
+
+  return -1;
+}
+
+// --- Private Interface --- //
+void PuzzleGenerator::GenerateBlock(int worker_index, Block& block)
+{
+  TimePerformanceScope("GenerateBlock");
+
+  Worker& worker = *_workers[worker_index];
+  int puzzle[kSudokuSize][kSudokuSize];
+  int solution[kSudokuSize][kSudokuSize];
+  int bits_per_slot = BinaryPuzzleFile::MakeHeader(kSudokuSize, false)._bits_per_slot;
+  size_t packed_size = BinaryPuzzleFile::GetPackedSize(kSudokuSize, bits_per_slot);
+  char* output = block._output.data();
+  for(int i = 0; i < block._puzzle_count; ++i)
+  {
+    worker._random.seed(MixSeed(_seed, block._first_puzzle + i));
+    int clue_count = GeneratePuzzle(worker, puzzle, solution, block._results._uniqueness_checks);
+
+    ++block._results._puzzle_count;
+    block._results._clue_count += clue_count;
+    block._results._target_reached_count += (clue_count <= _clue_count) ? 1 : 0;
+
+    if(_is_binary == true)
+    {
+      uint8_t* record = reinterpret_cast<uint8_t*>(output + block._output_size);
+      BinaryPuzzleFile::PackValues(&puzzle[0][0], kSudokuSize, bits_per_slot, record);
+      block._output_size += packed_size;
+      if(_is_writing_solutions == true)
+      {
+        BinaryPuzzleFile::PackValues(&solution[0][0], kSudokuSize, bits_per_slot, record + packed_size);
+        block._output_size += packed_size;
+      }
+      continue;
+    }
+
+    for(int slot = 0; slot < kSudokuSize * kSudokuSize; ++slot)
+    {
+      int value = puzzle[slot / kSudokuSize][slot % kSudokuSize];
+      output[block._output_size++] = (value != kEmptySlot) ? ValueToChar(value) : '.';
+    }
+    if(_is_writing_solutions == true)
+    {
+      output[block._output_size++] = ' ';
+      for(int slot = 0; slot < kSudokuSize * kSudokuSize; ++slot)
+      {
+        output[block._output_size++] = ValueToChar(solution[slot / kSudokuSize][slot % kSudokuSize]);
+      }
+    }
+    output[block._output_size++] = '\n';
+  }
+}
+
+int PuzzleGenerator::GeneratePuzzle(Worker& worker, int puzzle[kSudokuSize][kSudokuSize], int solution[kSudokuSize][kSudokuSize], uint64_t& uniqueness_checks)
+{
+  GenerateGrid(worker, solution);
+  std::memcpy(puzzle, solution, sizeof(int) * kSudokuSize * kSudokuSize);
+
+  // Slots are tried in a random order, each along with its symmetric slot
+  int slot_order[kSudokuSize * kSudokuSize];
+  int slot_count = 0;
+  for(int slot = 0; slot < kSudokuSize * kSudokuSize; ++slot)
+  {
+    if(GetSymmetricSlot(_symmetry, slot) >= slot)
+    {
+      slot_order[slot_count++] = slot;
+    }
+  }
+  for(int i = slot_count - 1; i > 0; --i)
+  {
+    int swap_index = RandomBelow(worker._random, i + 1);
+    int slot = slot_order[i];
+    slot_order[i] = slot_order[swap_index];
+    slot_order[swap_index] = slot;
+  }
+
+  int clue_count = kSudokuSize * kSudokuSize;
+  for(int i = 0; i < slot_count && clue_count > _clue_count; ++i)
+  {
+    int slot = slot_order[i];
+    int symmetric_slot = GetSymmetricSlot(_symmetry, slot);
+    int removed_count = (symmetric_slot == slot) ? 1 : 2;
+    if(clue_count - removed_count < _clue_count)
+    {
+      continue;
+    }
+
+    int& value = puzzle[slot / kSudokuSize][slot % kSudokuSize];
+    int& symmetric_value = puzzle[symmetric_slot / kSudokuSize][symmetric_slot % kSudokuSize];
+    int removed_value = value;
+    int removed_symmetric_value = symmetric_value;
+    value = kEmptySlot;
+    symmetric_value = kEmptySlot;
+
+    // Stopping at a second solution is all it takes to know the clue has to stay
+    ++uniqueness_checks;
+    worker._solver.LoadPuzzle(puzzle);
+    if(worker._solver.CountSolutions(2) == 1)
+    {
+      clue_count -= removed_count;
+    }
+    else
+    {
+      value = removed_value;
+      symmetric_value = removed_symmetric_value;
+    }
+  }
+
+  return clue_count;
+}
+
+void PuzzleGenerator::GenerateGrid(Worker& worker, int values[kSudokuSize][kSudokuSize])
+{
+  // The groups on the diagonal don't share a column or row, so any order of values in each is valid, and the solver fills in the rest
+  for(int row = 0; row < kSudokuSize; ++row)
+  {
+    for(int column = 0; column < kSudokuSize; ++column)
+    {
+      values[row][column] = kEmptySlot;
+    }
+  }
+
+  for(int group = 0; group < kSudokuSize; group += 4)
+  {
+    int group_values[kSudokuSize];
+    for(int i = 0; i < kSudokuSize; ++i)
+    {
+      group_values[i] = i + 1;
+    }
+    for(int i = kSudokuSize - 1; i > 0; --i)
+    {
+      int swap_index = RandomBelow(worker._random, i + 1);
+      int value = group_values[i];
+      group_values[i] = group_values[swap_index];
+      group_values[swap_index] = value;
+    }
+
+    int first_row = (group / 3) * 3;
+    int first_column = (group % 3) * 3;
+    for(int i = 0; i < kSudokuSize; ++i)
+    {
+      values[first_row + (i / 3)][first_column + (i % 3)] = group_values[i];
+    }
+  }
+
+  worker._solver.LoadPuzzle(values);
+  worker._solver.SolvePuzzle();
+  for(int row = 0; row < kSudokuSize; ++row)
+  {
+    for(int column = 0; column < kSudokuSize; ++column)
+    {
+      values[row][column] = worker._solver.GetValue(row, column);
+    }
+  }
+}
+
+void PuzzleGenerator::SubmitBlock(uint64_t first_puzzle, int puzzle_count)
+{
+  Block& block = _blocks[_next_sequence % _block_count];
+  block._first_puzzle = first_puzzle;
+  block._puzzle_count = puzzle_count;
+  block._output_size = 0;
+  block._results = GeneratorResults();
+  block._is_generated = false;
+
+  if(_thread_pool == nullptr)
+  {
+    GenerateBlock(0, block);
+    block._is_generated = true;
+  }
+  else
+  {
+    _thread_pool->Submit(&block);
+  }
+
+  // The next block reuses the slot of the block _block_count before it, which has to be written out first
+  ++_next_sequence;
+  WriteGeneratedBlocks(_block_count - 1);
+}
+
+void PuzzleGenerator::WriteGeneratedBlocks(uint64_t max_in_flight)
+{
+  while(_next_write_sequence < _next_sequence)
+  {
+    Block& block = _blocks[_next_write_sequence % _block_count];
+    bool must_wait = (_next_sequence - _next_write_sequence) > max_in_flight;
+    if(block._is_generated == false)
+    {
+      if(must_wait == false)
+      {
+        return;
+      }
+
+      TimePerformanceScope("WaitForBlock");
+      std::unique_lock<std::mutex> lock(_generated_mutex);
+      _generated_condition.wait(lock, [&block]() { return block._is_generated == true; });
+    }
+
+    if(block._output_size > 0 && std::fwrite(block._output.data(), 1, block._output_size, _output) != block._output_size)
+    {
+      _output_failed = true;
+    }
+
+    _results._puzzle_count += block._results._puzzle_count;
+    _results._clue_count += block._results._clue_count;
+    _results._target_reached_count += block._results._target_reached_count;
+    _results._uniqueness_checks += block._results._uniqueness_checks;
+    ++_next_write_sequence;
+  }
+}
+
+} // namespace Sudoku
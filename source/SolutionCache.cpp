@@ -0,0 +1,194 @@
+#include "SolutionCache.h"
+
+#include <cstring>
+
+namespace Sudoku
+{
+
+// --- Constants
+//! Ends the recently used lists
+#define kNoCacheEntry 0xFFFFFFFFu
+
+// --- Pubic Interface --- //
+SolutionCache::SolutionCache(size_t entry_count)
+  : _shards(new Shard[kSolutionCacheShards])
+{
+  _shard_capacity = (entry_count + kSolutionCacheShards - 1) / kSolutionCacheShards;
+  if(_shard_capacity == 0)
+  {
+    _shard_capacity = 1;
+  }
+
+  // At most half the index is ever used, which keeps the probes short
+  size_t index_size = 1;
+  while(index_size < _shard_capacity * 2)
+  {
+    index_size <<= 1;
+  }
+  _index_mask = index_size - 1;
+
+  for(int shard_index = 0; shard_index < kSolutionCacheShards; ++shard_index)
+  {
+    Shard& shard = _shards[shard_index];
+    shard._entries.resize(_shard_capacity);
+    shard._index.assign(index_size, 0);
+    shard._head = kNoCacheEntry;
+    shard._tail = kNoCacheEntry;
+  }
+}
+
+SolutionCache::~SolutionCache()
+{
+}
+
+bool SolutionCache::Find(const CanonicalPuzzle& puzzle, uint8_t& status, uint8_t solution[kCanonicalSlots])
+{
+  // The index uses the low bits of the hash, so the shard is picked with the high ones
+  Shard& shard = _shards[puzzle._hash >> 60];
+  std::lock_guard<std::mutex> lock(shard._mutex);
+
+  uint32_t entry_index = shard._index[FindIndexSlot(shard, puzzle._hash, puzzle._values)];
+  if(entry_index == 0)
+  {
+    return false;
+  }
+  --entry_index;
+
+  const Entry& entry = shard._entries[entry_index];
+  status = entry._status;
+  if(status == kCachedSolution || status == kCachedUniqueSolution)
+  {
+    std::memcpy(solution, entry._solution, kCanonicalSlots);
+  }
+
+  if(shard._head != entry_index)
+  {
+    Unlink(shard, entry_index);
+    PushFront(shard, entry_index);
+  }
+
+  return true;
+}
+
+void SolutionCache::Insert(const CanonicalPuzzle& puzzle, uint8_t status, const uint8_t* solution)
+{
+  Shard& shard = _shards[puzzle._hash >> 60];
+  std::lock_guard<std::mutex> lock(shard._mutex);
+
+  size_t index_slot = FindIndexSlot(shard, puzzle._hash, puzzle._values);
+  uint32_t entry_index = shard._index[index_slot];
+  if(entry_index != 0)
+  {
+    --entry_index;
+    Unlink(shard, entry_index);
+  }
+  else
+  {
+    if(shard._entry_count < _shard_capacity)
+    {
+      entry_index = shard._entry_count++;
+    }
+    else
+    {
+      // Reuses the least recently used entry, the index is searched again as removing it can move the free slot
+      entry_index = shard._tail;
+      Unlink(shard, entry_index);
+      RemoveFromIndex(shard, entry_index);
+      index_slot = FindIndexSlot(shard, puzzle._hash, puzzle._values);
+    }
+    shard._index[index_slot] = entry_index + 1;
+  }
+
+  Entry& entry = shard._entries[entry_index];
+  entry._hash = puzzle._hash;
+  std::memcpy(entry._puzzle, puzzle._values, kCanonicalSlots);
+  entry._status = status;
+  if(status == kCachedSolution || status == kCachedUniqueSolution)
+  {
+    std::memcpy(entry._solution, solution, kCanonicalSlots);
+  }
+  PushFront(shard, entry_index);
+}
+
+// --- Private Interface --- //
+size_t SolutionCache::FindIndexSlot(const Shard& shard, uint64_t hash, const uint8_t* puzzle) const
+{
+  size_t index_slot = hash & _index_mask;
+  for(;;)
+  {
+    uint32_t entry_index = shard._index[index_slot];
+    if(entry_index == 0)
+    {
+      return index_slot;
+    }
+
+    // Different puzzles can share a hash, so the whole puzzle is compared
+    const Entry& entry = shard._entries[entry_index - 1];
+    if(entry._hash == hash && std::memcmp(entry._puzzle, puzzle, kCanonicalSlots) == 0)
+    {
+      return index_slot;
+    }
+    index_slot = (index_slot + 1) & _index_mask;
+  }
+}
+
+void SolutionCache::RemoveFromIndex(Shard& shard, uint32_t entry_index)
+{
+  const Entry& removed = shard._entries[entry_index];
+  size_t index_slot = FindIndexSlot(shard, removed._hash, removed._puzzle);
+  shard._index[index_slot] = 0;
+
+  // Moves back every entry after the gap that can't be found past it any more
+  size_t next_slot = (index_slot + 1) & _index_mask;
+  while(shard._index[next_slot] != 0)
+  {
+    size_t home_slot = shard._entries[shard._index[next_slot] - 1]._hash & _index_mask;
+    if(((next_slot - home_slot) & _index_mask) >= ((next_slot - index_slot) & _index_mask))
+    {
+      shard._index[index_slot] = shard._index[next_slot];
+      shard._index[next_slot] = 0;
+      index_slot = next_slot;
+    }
+    next_slot = (next_slot + 1) & _index_mask;
+  }
+}
+
+void SolutionCache::Unlink(Shard& shard, uint32_t entry_index)
+{
+  Entry& entry = shard._entries[entry_index];
+  if(entry._previous != kNoCacheEntry)
+  {
+    shard._entries[entry._previous]._next = entry._next;
+  }
+  else
+  {
+    shard._head = entry._next;
+  }
+
+  if(entry._next != kNoCacheEntry)
+  {
+    shard._entries[entry._next]._previous = entry._previous;
+  }
+  else
+  {
+    shard._tail = entry._previous;
+  }
+}
+
+void SolutionCache::PushFront(Shard& shard, uint32_t entry_index)
+{
+  Entry& entry = shard._entries[entry_index];
+  entry._previous = kNoCacheEntry;
+  entry._next = shard._head;
+  if(shard._head != kNoCacheEntry)
+  {
+    shard._entries[shard._head]._previous = entry_index;
+  }
+  else
+  {
+    shard._tail = entry_index;
+  }
+  shard._head = entry_index;
+}
+
+} // namespace Sudoku
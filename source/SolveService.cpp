@@ -0,0 +1,840 @@
+#include "SolveService.h"
+
+#include "GridRenderer.h"
+#include "Logger.h"
+
+#include <cstdio>
+#include <cstring>
+
+#if defined(__linux__)
+#include <cerrno>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/timerfd.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+namespace Sudoku
+{
+
+// --- Constants
+#define kNoSolutionLine "No solution\n"
+#define kInvalidPuzzleLine "Invalid puzzle\n"
+#define kMultipleSolutionsLine "Multiple solutions\n"
+#define kInvalidGivensLine "Invalid givens\n"
+
+//! How a request turned out, the same as the batch line statuses
+#define kRequestSolved 0
+#define kRequestNoSolution 1
+#define kRequestInvalid 2
+#define kRequestMultipleSolutions 3
+#define kRequestInvalidGivens 4
+
+//! Bytes read from a client at once
+#define kServiceReadSize (1 << 16)
+//! Most events taken from epoll at once
+#define kServiceMaxEvents 64
+//! Room for the stats line, the histogram included
+#define kServiceStatsLength 2048
+
+//! Fills in a response that isn't a solution
+static void SetResponse(char* response, int& response_length, const char* text, size_t length)
+{
+  std::memcpy(response, text, length);
+  response_length = static_cast<int>(length);
+}
+
+//! Returns the latency below which the given fraction of requests were answered, as the top of its histogram bucket
+static uint64_t GetLatencyPercentile(const ServiceStats& stats, double fraction)
+{
+  uint64_t target = static_cast<uint64_t>(stats._request_count * fraction);
+  uint64_t count = 0;
+  for(int bucket = 0; bucket < kServiceLatencyBuckets - 1; ++bucket)
+  {
+    count += stats._latency_histogram[bucket];
+    if(count > target)
+    {
+      return ((1ull << bucket) < stats._max_latency_microseconds) ? (1ull << bucket) : stats._max_latency_microseconds;
+    }
+  }
+
+  return stats._max_latency_microseconds;
+}
+
+//! Counts one answered request towards the stats
+static void CountRequest(ServiceStats& stats, uint8_t status, uint64_t latency)
+{
+  ++stats._request_count;
+  stats._solved_count += (status == kRequestSolved) ? 1 : 0;
+  stats._no_solution_count += (status == kRequestNoSolution) ? 1 : 0;
+  stats._invalid_count += (status == kRequestInvalid) ? 1 : 0;
+  stats._multiple_solution_count += (status == kRequestMultipleSolutions) ? 1 : 0;
+  stats._invalid_givens_count += (status == kRequestInvalidGivens) ? 1 : 0;
+
+  int bucket = 0;
+  while(bucket < kServiceLatencyBuckets - 1 && (latency >> bucket) != 0)
+  {
+    ++bucket;
+  }
+  ++stats._latency_histogram[bucket];
+  stats._total_latency_microseconds += latency;
+  stats._max_latency_microseconds = (latency > stats._max_latency_microseconds) ? latency : stats._max_latency_microseconds;
+}
+
+// --- Pubic Interface --- //
+SolveService::SolveService(const char* engine_name, int thread_count, bool pin_threads)
+  : _is_stopping(false)
+{
+  if(thread_count < 1)
+  {
+    thread_count = 1;
+  }
+
+  _solver_pool.reset(new SolverPool(engine_name, thread_count));
+
+  _batch_count = thread_count * kServiceBatchesPerThread;
+  _batches.reset(new Batch[_batch_count]);
+  _free_batches.reserve(_batch_count);
+  _solved_batches.reserve(_batch_count);
+  _collected_batches.reserve(_batch_count);
+  for(int i = 0; i < _batch_count; ++i)
+  {
+    _free_batches.push_back(&_batches[i]);
+  }
+
+  _thread_pool.reset(new Utility::WorkStealingThreadPool<Batch>(thread_count, _batch_count, pin_threads, [this](int worker_index, Batch* batch)
+  {
+    SolveBatch(worker_index, *batch);
+
+    {
+      std::lock_guard<std::mutex> lock(_solved_mutex);
+      _solved_batches.push_back(batch);
+    }
+    _solved_condition.notify_one();
+
+#if defined(__linux__)
+    uint64_t wake_count = 1;
+    ssize_t written = write(_wake_handle, &wake_count, sizeof(wake_count));
+    (void)written;
+#endif
+  }));
+}
+
+SolveService::~SolveService()
+{
+  // Stop the workers before the batches and solvers they use go away
+  _thread_pool.reset();
+}
+
+bool SolveService::RunSocket(const char* socket_path)
+{
+#if defined(__linux__)
+  sockaddr_un address = {};
+  address.sun_family = AF_UNIX;
+  if(std::strlen(socket_path) >= sizeof(address.sun_path))
+  {
+    Logger::WriteErrorLine("The socket path \"%s\" is too long", socket_path);
+    return false;
+  }
+  std::strcpy(address.sun_path, socket_path);
+
+  _listen_handle = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+  if(_listen_handle < 0)
+  {
+    Logger::WriteErrorLine("Couldn't create a socket: %s", std::strerror(errno));
+    return false;
+  }
+
+  // A socket left behind by a service that didn't stop cleanly would make binding fail
+  unlink(socket_path);
+  bool is_served = false;
+  if(bind(_listen_handle, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 || listen(_listen_handle, SOMAXCONN) != 0)
+  {
+    Logger::WriteErrorLine("Couldn't listen on \"%s\": %s", socket_path, std::strerror(errno));
+  }
+  else
+  {
+    is_served = RunLoop(nullptr);
+    unlink(socket_path);
+  }
+
+  close(_listen_handle);
+  _listen_handle = -1;
+  return is_served;
+#else
+  (void)socket_path;
+  Logger::WriteErrorLine("The solve service is only available on Linux");
+  return false;
+#endif
+}
+
+bool SolveService::RunStdio()
+{
+#if defined(__linux__)
+  Client client;
+  client._input_handle = STDIN_FILENO;
+  client._output_handle = STDOUT_FILENO;
+  return RunLoop(&client) == true && client._is_failed == false;
+#else
+  Logger::WriteErrorLine("The solve service is only available on Linux");
+  return false;
+#endif
+}
+
+void SolveService::Stop()
+{
+  _is_stopping = true;
+
+#if defined(__linux__)
+  if(_wake_handle >= 0)
+  {
+    uint64_t wake_count = 1;
+    ssize_t written = write(_wake_handle, &wake_count, sizeof(wake_count));
+    (void)written;
+  }
+#endif
+}
+
+size_t SolveService::WriteStatsJson(char* buffer, size_t size) const
+{
+  return WriteStatsJson(_stats, buffer, size);
+}
+
+// --- Private Interface --- //
+size_t SolveService::WriteStatsJson(const ServiceStats& stats, char* buffer, size_t size)
+{
+  int length = std::snprintf(buffer, size, "{\"clients\":%llu,\"requests\":%llu,\"solved\":%llu,\"no_solution\":%llu,\"invalid\":%llu,\"multiple_solutions\":%llu,\"invalid_givens\":%llu,"
+    "\"batches\":%llu,\"mean_batch_size\":%.2f,\"elapsed_seconds\":%.3f,\"requests_per_second\":%.1f,\"mean_latency_us\":%.1f,\"p50_latency_us\":%llu,\"p90_latency_us\":%llu,"
+    "\"p99_latency_us\":%llu,\"max_latency_us\":%llu,\"latency_histogram_us\":{",
+    static_cast<unsigned long long>(stats._client_count), static_cast<unsigned long long>(stats._request_count), static_cast<unsigned long long>(stats._solved_count),
+    static_cast<unsigned long long>(stats._no_solution_count), static_cast<unsigned long long>(stats._invalid_count), static_cast<unsigned long long>(stats._multiple_solution_count),
+    static_cast<unsigned long long>(stats._invalid_givens_count), static_cast<unsigned long long>(stats._batch_count),
+    (stats._batch_count > 0) ? static_cast<double>(stats._request_count) / stats._batch_count : 0.0, stats._elapsed_seconds,
+    (stats._elapsed_seconds > 0.0) ? stats._request_count / stats._elapsed_seconds : 0.0,
+    (stats._request_count > 0) ? static_cast<double>(stats._total_latency_microseconds) / stats._request_count : 0.0,
+    static_cast<unsigned long long>(GetLatencyPercentile(stats, 0.5)), static_cast<unsigned long long>(GetLatencyPercentile(stats, 0.9)),
+    static_cast<unsigned long long>(GetLatencyPercentile(stats, 0.99)), static_cast<unsigned long long>(stats._max_latency_microseconds));
+
+  // Only the buckets that were hit, named by the latency they're under
+  bool is_first = true;
+  for(int bucket = 0; bucket < kServiceLatencyBuckets && length > 0 && static_cast<size_t>(length) < size; ++bucket)
+  {
+    if(stats._latency_histogram[bucket] == 0)
+    {
+      continue;
+    }
+
+    length += std::snprintf(buffer + length, size - length, "%s\"%s%llu\":%llu", is_first ? "" : ",", (bucket < kServiceLatencyBuckets - 1) ? "<" : ">=",
+      1ull << ((bucket < kServiceLatencyBuckets - 1) ? bucket : bucket - 1), static_cast<unsigned long long>(stats._latency_histogram[bucket]));
+    is_first = false;
+  }
+  if(length > 0 && static_cast<size_t>(length) < size)
+  {
+    length += std::snprintf(buffer + length, size - length, "}}\n");
+  }
+
+  return (length > 0 && static_cast<size_t>(length) < size) ? static_cast<size_t>(length) : 0;
+}
+
+#if defined(__linux__)
+bool SolveService::RunLoop(Client* stdio_client)
+{
+  _epoll_handle = epoll_create1(EPOLL_CLOEXEC);
+  _wake_handle = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  _timer_handle = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+
+  bool is_running = _epoll_handle >= 0 && _wake_handle >= 0 && _timer_handle >= 0;
+  int* handles[] = { &_wake_handle, &_timer_handle, &_listen_handle };
+  for(int* handle : handles)
+  {
+    if(is_running == true && *handle >= 0)
+    {
+      // Pointing at the member tells these events apart from the clients
+      epoll_event event = {};
+      event.events = EPOLLIN;
+      event.data.ptr = handle;
+      is_running = epoll_ctl(_epoll_handle, EPOLL_CTL_ADD, *handle, &event) == 0;
+    }
+  }
+  if(is_running == false)
+  {
+    Logger::WriteErrorLine("Couldn't set up epoll for the solve service: %s", std::strerror(errno));
+  }
+
+  if(is_running == true && stdio_client != nullptr)
+  {
+    _clients.push_back(stdio_client);
+    ++_stats._client_count;
+
+    epoll_event event = {};
+    event.events = EPOLLIN;
+    event.data.ptr = stdio_client;
+    if(epoll_ctl(_epoll_handle, EPOLL_CTL_ADD, stdio_client->_input_handle, &event) == 0)
+    {
+      stdio_client->_is_registered = true;
+    }
+    else
+    {
+      stdio_client->_is_always_readable = true;
+    }
+    stdio_client->_is_reading = true;
+  }
+
+  _start_time = std::chrono::steady_clock::now();
+  bool was_stopping = false;
+  epoll_event events[kServiceMaxEvents];
+  while(is_running == true)
+  {
+    bool is_stopping = _is_stopping;
+    if(is_stopping == true && was_stopping == false)
+    {
+      // Nothing more is read, but everything already read is answered
+      was_stopping = true;
+      if(_listen_handle >= 0)
+      {
+        epoll_ctl(_epoll_handle, EPOLL_CTL_DEL, _listen_handle, nullptr);
+      }
+      for(Client* client : _clients)
+      {
+        UpdateClientEvents(*client);
+      }
+    }
+
+    bool is_stdio_done = stdio_client != nullptr && (stdio_client->_is_input_closed == true || stdio_client->_is_failed == true || is_stopping == true) &&
+      stdio_client->_responses.empty() == true;
+    if((is_stopping == true || is_stdio_done == true) && _current_batch == nullptr && _batches_in_flight == 0)
+    {
+      break;
+    }
+
+    // Files given as stdin are always ready, so they're read without waiting
+    int timeout = -1;
+    for(Client* client : _clients)
+    {
+      timeout = (client->_is_always_readable == true && client->_is_reading == true) ? 0 : timeout;
+    }
+
+    int event_count = epoll_wait(_epoll_handle, events, kServiceMaxEvents, timeout);
+    if(event_count < 0)
+    {
+      if(errno == EINTR)
+      {
+        continue;
+      }
+      Logger::WriteErrorLine("Waiting on epoll failed: %s", std::strerror(errno));
+      break;
+    }
+
+    bool is_timer_due = false;
+    for(int index = 0; index < event_count; ++index)
+    {
+      void* tag = events[index].data.ptr;
+      if(tag == &_listen_handle)
+      {
+        AcceptClients();
+      }
+      else if(tag == &_wake_handle || tag == &_timer_handle)
+      {
+        uint64_t count = 0;
+        ssize_t read_size = read(*static_cast<int*>(tag), &count, sizeof(count));
+        (void)read_size;
+        is_timer_due = is_timer_due == true || tag == &_timer_handle;
+      }
+      else
+      {
+        Client& client = *static_cast<Client*>(tag);
+        if((events[index].events & (EPOLLIN | EPOLLHUP | EPOLLERR)) != 0 && client._is_reading == true)
+        {
+          ReadClient(client);
+        }
+        if((events[index].events & EPOLLOUT) != 0)
+        {
+          WriteClient(client);
+        }
+      }
+    }
+
+    for(Client* client : _clients)
+    {
+      if(client->_is_always_readable == true && client->_is_reading == true)
+      {
+        ReadClient(*client);
+      }
+    }
+
+    CollectSolvedBatches();
+
+    // Without a latency cap a batch is whatever was read this time round
+    if(_current_batch != nullptr)
+    {
+      int64_t remaining = std::chrono::duration_cast<std::chrono::microseconds>(_batch_deadline - std::chrono::steady_clock::now()).count();
+      if(_latency_cap == 0 || is_stopping == true || remaining <= 0 || (stdio_client != nullptr && stdio_client->_is_input_closed == true))
+      {
+        SubmitBatch();
+      }
+      else if(is_timer_due == true)
+      {
+        // The timer went off for a batch that was sent when it filled up
+        ArmBatchTimer(remaining);
+      }
+    }
+
+    for(size_t index = 0; index < _clients.size(); )
+    {
+      Client* client = _clients[index];
+      if(client != stdio_client && TryCloseClient(*client) == true)
+      {
+        delete client;
+        _clients[index] = _clients.back();
+        _clients.pop_back();
+        continue;
+      }
+      ++index;
+    }
+  }
+
+  _stats._elapsed_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - _start_time).count();
+
+  // Anything still connected once the service stops is dropped
+  for(Client* client : _clients)
+  {
+    if(client != stdio_client)
+    {
+      close(client->_input_handle);
+      delete client;
+    }
+  }
+  _clients.clear();
+  _pending_stats.clear();
+
+  int* owned_handles[] = { &_epoll_handle, &_wake_handle, &_timer_handle };
+  for(int* handle : owned_handles)
+  {
+    if(*handle >= 0)
+    {
+      close(*handle);
+      *handle = -1;
+    }
+  }
+
+  return is_running;
+}
+
+void SolveService::AcceptClients()
+{
+  while(true)
+  {
+    int handle = accept4(_listen_handle, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+    if(handle < 0)
+    {
+      // Out of handles is left for the next wake up, once some clients have gone
+      return;
+    }
+
+    Client* client = new Client();
+    client->_input_handle = handle;
+    client->_output_handle = handle;
+    client->_is_socket = true;
+
+    epoll_event event = {};
+    event.events = EPOLLIN;
+    event.data.ptr = client;
+    if(epoll_ctl(_epoll_handle, EPOLL_CTL_ADD, handle, &event) != 0)
+    {
+      close(handle);
+      delete client;
+      continue;
+    }
+    client->_is_registered = true;
+    client->_is_reading = true;
+
+    _clients.push_back(client);
+    ++_stats._client_count;
+  }
+}
+
+void SolveService::ReadClient(Client& client)
+{
+  char buffer[kServiceReadSize];
+  ssize_t read_size = client._is_socket ? recv(client._input_handle, buffer, sizeof(buffer), 0) : read(client._input_handle, buffer, sizeof(buffer));
+  if(read_size < 0)
+  {
+    if(errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)
+    {
+      return;
+    }
+    client._is_failed = true;
+  }
+
+  if(read_size <= 0)
+  {
+    // A last line without a newline still counts
+    if(client._line_length > 0 && client._is_failed == false)
+    {
+      HandleLine(client, client._line, client._line_length);
+      client._line_length = 0;
+    }
+    client._is_input_closed = true;
+    UpdateClientEvents(client);
+    return;
+  }
+
+  const char* data = buffer;
+  const char* data_end = buffer + read_size;
+  while(data < data_end)
+  {
+    const char* line_end = static_cast<const char*>(std::memchr(data, '\n', data_end - data));
+    const char* piece_end = (line_end != nullptr) ? line_end : data_end;
+
+    // Only the part of a line a puzzle needs is kept, the rest is skipped over
+    int kept_length = static_cast<int>(piece_end - data);
+    if(kept_length > static_cast<int>(sizeof(client._line)) - client._line_length)
+    {
+      kept_length = static_cast<int>(sizeof(client._line)) - client._line_length;
+    }
+    std::memcpy(client._line + client._line_length, data, kept_length);
+    client._line_length += kept_length;
+
+    if(line_end == nullptr)
+    {
+      break;
+    }
+    HandleLine(client, client._line, client._line_length);
+    client._line_length = 0;
+    data = line_end + 1;
+  }
+
+  // Stats requests are answered straight away, so they may be ready to go already
+  if(client._responses.empty() == false && client._responses.front()._is_ready == true)
+  {
+    WriteClient(client);
+    return;
+  }
+  UpdateClientEvents(client);
+}
+
+void SolveService::HandleLine(Client& client, const char* line, int length)
+{
+  if(length > 0 && line[length - 1] == '\r')
+  {
+    --length;
+  }
+  if(length == 0 || line[0] == '#')
+  {
+    return;
+  }
+
+  if(length == static_cast<int>(sizeof(kServiceStatsCommand)) - 1 && std::memcmp(line, kServiceStatsCommand, length) == 0)
+  {
+    // Answered once every request read before it has been, counting just those. Until then it holds the ones answered so far
+    client._responses.emplace_back();
+    Response& response = client._responses.back();
+    response._is_stats = true;
+    response._stats.reset(new ServiceStats(_stats));
+    if(_stats._request_count == _read_request_count)
+    {
+      response._stats->_elapsed_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - _start_time).count();
+      response._is_ready = true;
+      return;
+    }
+    _pending_stats.push_back({ &client, client._first_sequence + client._responses.size() - 1, _read_request_count, _read_request_count - _stats._request_count });
+    return;
+  }
+
+  if(_current_batch == nullptr)
+  {
+    _current_batch = TakeFreeBatch();
+    _current_batch->_request_count = 0;
+    _batch_deadline = std::chrono::steady_clock::now() + std::chrono::microseconds(_latency_cap);
+    if(_latency_cap > 0)
+    {
+      ArmBatchTimer(_latency_cap);
+    }
+  }
+
+  client._responses.emplace_back();
+  Request& request = _current_batch->_requests[_current_batch->_request_count++];
+  request._client = &client;
+  request._sequence = client._first_sequence + client._responses.size() - 1;
+  std::memcpy(request._line, line, length);
+  request._line_length = length;
+  request._read_time = std::chrono::steady_clock::now();
+  request._read_index = _read_request_count++;
+
+  if(_current_batch->_request_count == kServiceBatchSize)
+  {
+    SubmitBatch();
+  }
+}
+
+void SolveService::SubmitBatch()
+{
+  ++_batches_in_flight;
+  _thread_pool->Submit(_current_batch);
+  _current_batch = nullptr;
+}
+
+SolveService::Batch* SolveService::TakeFreeBatch()
+{
+  while(_free_batches.empty() == true)
+  {
+    {
+      std::unique_lock<std::mutex> lock(_solved_mutex);
+      _solved_condition.wait(lock, [this]() { return _solved_batches.empty() == false; });
+    }
+    CollectSolvedBatches();
+  }
+
+  Batch* batch = _free_batches.back();
+  _free_batches.pop_back();
+  return batch;
+}
+
+void SolveService::CollectSolvedBatches()
+{
+  {
+    std::lock_guard<std::mutex> lock(_solved_mutex);
+    if(_solved_batches.empty() == true)
+    {
+      return;
+    }
+    _collected_batches.swap(_solved_batches);
+  }
+
+  std::chrono::steady_clock::time_point ready_time = std::chrono::steady_clock::now();
+  for(Batch* batch : _collected_batches)
+  {
+    for(int index = 0; index < batch->_request_count; ++index)
+    {
+      const Request& request = batch->_requests[index];
+      Response& response = request._client->_responses[request._sequence - request._client->_first_sequence];
+      std::memcpy(response._text, request._response, request._response_length);
+      response._length = request._response_length;
+      response._is_ready = true;
+
+      uint64_t latency = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(ready_time - request._read_time).count());
+      CountRequest(_stats, request._status, latency);
+      for(PendingStats& pending : _pending_stats)
+      {
+        if(request._read_index < pending._read_count)
+        {
+          CountRequest(*pending._client->_responses[pending._sequence - pending._client->_first_sequence]._stats, request._status, latency);
+          --pending._missing_count;
+        }
+      }
+    }
+    ++_stats._batch_count;
+    for(PendingStats& pending : _pending_stats)
+    {
+      if(batch->_requests[0]._read_index < pending._read_count)
+      {
+        ++pending._client->_responses[pending._sequence - pending._client->_first_sequence]._stats->_batch_count;
+      }
+    }
+
+    // Only clients with the response at the front ready have anything to write yet
+    for(int index = 0; index < batch->_request_count; ++index)
+    {
+      Client& client = *batch->_requests[index]._client;
+      if(client._responses.empty() == false && client._responses.front()._is_ready == true)
+      {
+        WriteClient(client);
+      }
+    }
+
+    _free_batches.push_back(batch);
+    --_batches_in_flight;
+  }
+  _collected_batches.clear();
+
+  // Stats responses that have every request read before them answered are ready, and may be at the front
+  for(size_t index = 0; index < _pending_stats.size(); )
+  {
+    PendingStats pending = _pending_stats[index];
+    if(pending._missing_count > 0)
+    {
+      ++index;
+      continue;
+    }
+    _pending_stats.erase(_pending_stats.begin() + index);
+
+    Response& response = pending._client->_responses[pending._sequence - pending._client->_first_sequence];
+    response._stats->_elapsed_seconds = std::chrono::duration<double>(ready_time - _start_time).count();
+    response._is_ready = true;
+    if(pending._client->_responses.front()._is_ready == true)
+    {
+      WriteClient(*pending._client);
+    }
+  }
+}
+
+void SolveService::WriteClient(Client& client)
+{
+  while(client._responses.empty() == false && client._responses.front()._is_ready == true)
+  {
+    const Response& response = client._responses.front();
+    if(client._is_failed == false)
+    {
+      if(response._is_stats == true)
+      {
+        char stats[kServiceStatsLength];
+        size_t length = WriteStatsJson(*response._stats, stats, sizeof(stats));
+        client._output.insert(client._output.end(), stats, stats + length);
+      }
+      else
+      {
+        client._output.insert(client._output.end(), response._text, response._text + response._length);
+      }
+    }
+    client._responses.pop_front();
+    ++client._first_sequence;
+  }
+
+  while(client._is_failed == false && client._output_offset < client._output.size())
+  {
+    const char* data = client._output.data() + client._output_offset;
+    size_t length = client._output.size() - client._output_offset;
+    ssize_t written = client._is_socket ? send(client._output_handle, data, length, MSG_NOSIGNAL) : write(client._output_handle, data, length);
+    if(written < 0)
+    {
+      if(errno == EINTR)
+      {
+        continue;
+      }
+      if(errno != EAGAIN && errno != EWOULDBLOCK)
+      {
+        client._is_failed = true;
+      }
+      break;
+    }
+    client._output_offset += written;
+  }
+
+  if(client._is_failed == true || client._output_offset == client._output.size())
+  {
+    client._output.clear();
+    client._output_offset = 0;
+  }
+  UpdateClientEvents(client);
+}
+
+void SolveService::UpdateClientEvents(Client& client)
+{
+  client._is_reading = client._is_input_closed == false && client._is_failed == false && _is_stopping == false && client._responses.size() < kServiceMaxPendingRequests;
+  client._is_writing = client._is_socket == true && client._output_offset < client._output.size();
+  if(client._is_always_readable == true)
+  {
+    return;
+  }
+
+  epoll_event event = {};
+  event.events = (client._is_reading ? static_cast<uint32_t>(EPOLLIN) : 0u) | (client._is_writing ? static_cast<uint32_t>(EPOLLOUT) : 0u);
+  event.data.ptr = &client;
+  if(event.events == 0)
+  {
+    if(client._is_registered == true)
+    {
+      epoll_ctl(_epoll_handle, EPOLL_CTL_DEL, client._input_handle, nullptr);
+      client._is_registered = false;
+    }
+    return;
+  }
+
+  epoll_ctl(_epoll_handle, (client._is_registered == true) ? EPOLL_CTL_MOD : EPOLL_CTL_ADD, client._input_handle, &event);
+  client._is_registered = true;
+}
+
+bool SolveService::TryCloseClient(Client& client)
+{
+  bool is_done = (client._is_input_closed == true || client._is_failed == true) && client._responses.empty() == true && client._output.empty() == true;
+  if(is_done == false)
+  {
+    return false;
+  }
+
+  if(client._is_registered == true)
+  {
+    epoll_ctl(_epoll_handle, EPOLL_CTL_DEL, client._input_handle, nullptr);
+    client._is_registered = false;
+  }
+  if(client._is_socket == true)
+  {
+    close(client._input_handle);
+  }
+
+  return true;
+}
+
+void SolveService::ArmBatchTimer(int64_t microseconds)
+{
+  itimerspec timer = {};
+  timer.it_value.tv_sec = static_cast<time_t>(microseconds / 1000000);
+  timer.it_value.tv_nsec = static_cast<long>((microseconds % 1000000) * 1000);
+  timerfd_settime(_timer_handle, 0, &timer, nullptr);
+}
+#else
+bool SolveService::RunLoop(Client*) { return false; }
+void SolveService::AcceptClients() {}
+void SolveService::ReadClient(Client&) {}
+void SolveService::HandleLine(Client&, const char*, int) {}
+void SolveService::SubmitBatch() {}
+SolveService::Batch* SolveService::TakeFreeBatch() { return nullptr; }
+void SolveService::CollectSolvedBatches() {}
+void SolveService::WriteClient(Client&) {}
+void SolveService::UpdateClientEvents(Client&) {}
+bool SolveService::TryCloseClient(Client&) { return true; }
+void SolveService::ArmBatchTimer(int64_t) {}
+#endif
+
+void SolveService::SolveBatch(int worker_index, Batch& batch)
+{
+  (void)worker_index;
+
+  // One solver does the whole batch, so checking it out is paid once per batch
+  ISudokuSolver& solver = _solver_pool->Acquire();
+  int values[kPuzzleLineLength];
+  for(int index = 0; index < batch._request_count; ++index)
+  {
+    Request& request = batch._requests[index];
+    if(GetPuzzleLineSize(request._line, request._line_length) != kSudokuSize || ParsePuzzleLine(request._line, kSudokuSize, values) == false)
+    {
+      request._status = kRequestInvalid;
+      SetResponse(request._response, request._response_length, kInvalidPuzzleLine, sizeof(kInvalidPuzzleLine) - 1);
+      continue;
+    }
+    if(_is_checking_uniqueness == true && HasValidGivens(values, kSudokuSize) == false)
+    {
+      request._status = kRequestInvalidGivens;
+      SetResponse(request._response, request._response_length, kInvalidGivensLine, sizeof(kInvalidGivensLine) - 1);
+      continue;
+    }
+
+    solver.LoadPuzzleValues(values);
+    uint64_t solution_count = solver.CountSolutions(_is_checking_uniqueness ? 2 : 1);
+    if(solution_count == 0)
+    {
+      request._status = kRequestNoSolution;
+      SetResponse(request._response, request._response_length, kNoSolutionLine, sizeof(kNoSolutionLine) - 1);
+    }
+    else if(solution_count > 1)
+    {
+      request._status = kRequestMultipleSolutions;
+      SetResponse(request._response, request._response_length, kMultipleSolutionsLine, sizeof(kMultipleSolutionsLine) - 1);
+    }
+    else
+    {
+      request._status = kRequestSolved;
+      int solution[kPuzzleLineLength];
+      for(int slot = 0; slot < kPuzzleLineLength; ++slot)
+      {
+        solution[slot] = solver.GetValue(slot / kSudokuSize, slot % kSudokuSize);
+      }
+      request._response_length = static_cast<int>(GridRenderer::RenderCompact(solution, kSudokuSize, request._response));
+    }
+  }
+  _solver_pool->Release(solver);
+}
+
+} // namespace Sudoku
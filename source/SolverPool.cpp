@@ -0,0 +1,67 @@
+#include "SolverPool.h"
+
+namespace Sudoku
+{
+
+// --- Pubic Interface --- //
+SolverPool::SolverPool(const char* engine_name, int solver_count)
+{
+  _solvers.reserve(solver_count);
+  _free_solvers.reserve(solver_count);
+  for(int i = 0; i < solver_count; ++i)
+  {
+    std::unique_ptr<ISudokuSolver> solver = CreateSolver(engine_name, kSudokuSize, solver_count);
+    if(solver == nullptr)
+    {
+      break;
+    }
+
+    // An empty board has solutions, so this grows every buffer a search uses
+    solver->Reset();
+    solver->SolvePuzzle();
+    solver->Reset();
+
+    _free_solvers.push_back(solver.get());
+    _solvers.push_back(std::move(solver));
+  }
+}
+
+SolverPool::~SolverPool()
+{
+}
+
+ISudokuSolver& SolverPool::Acquire()
+{
+  std::unique_lock<std::mutex> lock(_mutex);
+  _released_condition.wait(lock, [this]() { return _free_solvers.empty() == false; });
+
+  ISudokuSolver* solver = _free_solvers.back();
+  _free_solvers.pop_back();
+  return *solver;
+}
+
+ISudokuSolver* SolverPool::TryAcquire()
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  if(_free_solvers.empty() == true)
+  {
+    return nullptr;
+  }
+
+  ISudokuSolver* solver = _free_solvers.back();
+  _free_solvers.pop_back();
+  return solver;
+}
+
+void SolverPool::Release(ISudokuSolver& solver)
+{
+  // Reset outside the lock, it only touches this solver
+  solver.Reset();
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _free_solvers.push_back(&solver);
+  }
+  _released_condition.notify_one();
+}
+
+} // namespace Sudoku
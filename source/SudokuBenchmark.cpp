@@ -0,0 +1,548 @@
+// SudokuBenchmark.cpp : Times every engine over the benchmark corpora, and writes the results out as JSON or CSV.
+//
+
+#include "BatchRunner.h"
+#include "BitSlicedSolver.h"
+#include "CandidateBoard.h"
+#include "DeductionStrategies.h"
+#include "ISudokuSolver.h"
+#include "Logger.h"
+#include "SolverPool.h"
+#include "SudokuSolver.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <string>
+#include <vector>
+
+#if defined(_MSC_VER)
+#include <malloc.h>
+#endif
+
+// --- Constants
+//! Corpora timed when none are given, from the easiest tier to the hardest
+static const char* kDefaultCorpora[] = { "../runtime/benchmark/easy.txt", "../runtime/benchmark/seventeen.txt", "../runtime/benchmark/hard.txt", "../runtime/benchmark/large.txt" };
+static const char* kDefaultEngines[] = { kBacktrackingEngineName, kDancingLinksEngineName, kParallelEngineName, kBitSlicedEngineName };
+
+// --- Allocation Counting
+//! Every heap allocation made by the process, so the timed passes can report how many each puzzle needed
+static std::atomic<uint64_t> s_allocation_count(0);
+
+void* operator new(std::size_t size)
+{
+  s_allocation_count.fetch_add(1, std::memory_order_relaxed);
+  void* memory = std::malloc(size > 0 ? size : 1);
+  if(memory == nullptr)
+  {
+    throw std::bad_alloc();
+  }
+  return memory;
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment)
+{
+  s_allocation_count.fetch_add(1, std::memory_order_relaxed);
+  // aligned_alloc wants the size to be a multiple of the alignment
+  size_t aligned_size = (size + static_cast<size_t>(alignment) - 1) & ~(static_cast<size_t>(alignment) - 1);
+#if defined(_MSC_VER)
+  void* memory = _aligned_malloc(aligned_size > 0 ? aligned_size : 1, static_cast<size_t>(alignment));
+#else
+  void* memory = std::aligned_alloc(static_cast<size_t>(alignment), aligned_size > 0 ? aligned_size : static_cast<size_t>(alignment));
+#endif
+  if(memory == nullptr)
+  {
+    throw std::bad_alloc();
+  }
+  return memory;
+}
+
+void operator delete(void* memory) noexcept
+{
+  std::free(memory);
+}
+
+void operator delete(void* memory, std::size_t) noexcept
+{
+  std::free(memory);
+}
+
+void operator delete(void* memory, std::align_val_t) noexcept
+{
+#if defined(_MSC_VER)
+  _aligned_free(memory);
+#else
+  std::free(memory);
+#endif
+}
+
+void operator delete(void* memory, std::size_t, std::align_val_t alignment) noexcept
+{
+  operator delete(memory, alignment);
+}
+
+// --- Benchmark
+//! The puzzles of one corpus, row by row
+struct Corpus
+{
+  std::string _name;
+  //! Every puzzle of a corpus is the same size of board
+  int _size = kSudokuSize;
+  std::vector<int> _values;
+  //! The same puzzles as they were written, _size x _size characters each
+  std::string _lines;
+  size_t _puzzle_count = 0;
+};
+
+//! Measurements of one engine over one corpus
+struct BenchmarkResult
+{
+  std::string _corpus_name;
+  const char* _engine_name = nullptr;
+  uint64_t _puzzle_count = 0;
+  uint64_t _solved_count = 0;
+  double _puzzles_per_second = 0.0;
+  double _mean_ns = 0.0;
+  uint64_t _p50_ns = 0;
+  uint64_t _p99_ns = 0;
+  uint64_t _max_ns = 0;
+  double _allocations_per_puzzle = 0.0;
+};
+
+//! Search nodes of the backtracking engine over one corpus, with the deduction strategies up to one of them enabled
+struct StrategyStepResult
+{
+  std::string _corpus_name;
+  //! The strategy added in this step, nullptr for the step with none
+  const char* _strategy_name = nullptr;
+  uint64_t _nodes = 0;
+  //! Nodes fewer than the step before it
+  int64_t _nodes_saved = 0;
+  //! Values the added strategy took away
+  uint64_t _eliminations = 0;
+  double _puzzles_per_second = 0.0;
+};
+
+//! Reads the puzzles of a file written one per line, the size of board of the first one. Returns false if it couldn't be opened
+static bool LoadCorpus(const char* file_path, Corpus& corpus)
+{
+  std::ifstream file(file_path);
+  if(file.is_open() == false)
+  {
+    return false;
+  }
+
+  // The corpus is named after its file, without the directory or extension
+  corpus._name = file_path;
+  size_t name_start = corpus._name.find_last_of("/\\");
+  if(name_start != std::string::npos)
+  {
+    corpus._name.erase(0, name_start + 1);
+  }
+  corpus._name = corpus._name.substr(0, corpus._name.find('.'));
+
+  std::string line;
+  int values[kMaxPuzzleLineLength];
+  while(std::getline(file, line))
+  {
+    if(line.empty() == true || line[0] == '#')
+    {
+      continue;
+    }
+
+    int size = Sudoku::GetPuzzleLineSize(line.c_str(), line.length());
+    if(corpus._puzzle_count == 0 && size != 0)
+    {
+      corpus._size = size;
+    }
+
+    if(size == corpus._size && Sudoku::ParsePuzzleLine(line.c_str(), size, values) == true)
+    {
+      corpus._values.insert(corpus._values.end(), values, values + (size * size));
+      corpus._lines.append(line, 0, size * size);
+      ++corpus._puzzle_count;
+    }
+  }
+
+  return true;
+}
+
+//! Solves every puzzle of the corpus one at a time, recording how long each took. Returns the number solved
+static uint64_t SolveCorpus(Sudoku::ISudokuSolver& solver, const Corpus& corpus, std::vector<uint64_t>& puzzle_ns)
+{
+  uint64_t solved_count = 0;
+  for(size_t puzzle = 0; puzzle < corpus._puzzle_count; ++puzzle)
+  {
+    std::chrono::steady_clock::time_point start_time = std::chrono::steady_clock::now();
+    solver.LoadPuzzleValues(&corpus._values[puzzle * corpus._size * corpus._size]);
+    bool is_solved = solver.SolvePuzzle();
+    std::chrono::steady_clock::time_point end_time = std::chrono::steady_clock::now();
+
+    puzzle_ns.push_back(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(end_time - start_time).count()));
+    solved_count += is_solved ? 1 : 0;
+  }
+
+  return solved_count;
+}
+
+//! Solves every puzzle of the corpus on a solver checked out of the pool for it, loaded straight from its line. Returns the number solved
+static uint64_t SolveCorpus(Sudoku::SolverPool& solver_pool, const Corpus& corpus, std::vector<uint64_t>& puzzle_ns)
+{
+  uint64_t solved_count = 0;
+  for(size_t puzzle = 0; puzzle < corpus._puzzle_count; ++puzzle)
+  {
+    std::chrono::steady_clock::time_point start_time = std::chrono::steady_clock::now();
+    Sudoku::ISudokuSolver& solver = solver_pool.Acquire();
+    bool is_solved = solver.Load(&corpus._lines[puzzle * kPuzzleLineLength]) == true && solver.SolvePuzzle() == true;
+    solver_pool.Release(solver);
+    std::chrono::steady_clock::time_point end_time = std::chrono::steady_clock::now();
+
+    puzzle_ns.push_back(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(end_time - start_time).count()));
+    solved_count += is_solved ? 1 : 0;
+  }
+
+  return solved_count;
+}
+
+//! Solves the corpus kBitSlicedLanes puzzles at a time, each puzzle of a group is charged an equal share of its time. Returns the number solved
+static uint64_t SolveCorpus(Sudoku::BitSlicedSolver& solver, const Corpus& corpus, std::vector<uint64_t>& puzzle_ns)
+{
+  int values[kBitSlicedLanes][kSudokuSize][kSudokuSize];
+  uint64_t solved_count = 0;
+  for(size_t first_puzzle = 0; first_puzzle < corpus._puzzle_count; first_puzzle += kBitSlicedLanes)
+  {
+    int puzzle_count = static_cast<int>(std::min<size_t>(kBitSlicedLanes, corpus._puzzle_count - first_puzzle));
+
+    std::chrono::steady_clock::time_point start_time = std::chrono::steady_clock::now();
+    std::memcpy(values, &corpus._values[first_puzzle * kPuzzleLineLength], puzzle_count * kPuzzleLineLength * sizeof(int));
+    uint32_t solved_puzzles = solver.SolvePuzzles(puzzle_count, values);
+    std::chrono::steady_clock::time_point end_time = std::chrono::steady_clock::now();
+
+    uint64_t group_ns = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(end_time - start_time).count());
+    puzzle_ns.insert(puzzle_ns.end(), puzzle_count, group_ns / puzzle_count);
+    for(; solved_puzzles != 0; solved_puzzles &= solved_puzzles - 1)
+    {
+      ++solved_count;
+    }
+  }
+
+  return solved_count;
+}
+
+//! Times the engine over the corpus, after warm_up_passes untimed passes so the solver has already grown its buffers. Pooled runs check a solver out of a SolverPool for every puzzle.
+//  Pools only hold 9x9 solvers, so corpora of other sizes are always timed on a solver of their own
+static BenchmarkResult RunBenchmark(const char* engine_name, const Corpus& corpus, int warm_up_passes, int timed_passes, bool is_pooled)
+{
+  BenchmarkResult result;
+  result._corpus_name = corpus._name;
+  result._engine_name = engine_name;
+
+  std::unique_ptr<Sudoku::ISudokuSolver> solver;
+  std::unique_ptr<Sudoku::BitSlicedSolver> bit_sliced_solver;
+  std::unique_ptr<Sudoku::SolverPool> solver_pool;
+  if(std::strcmp(engine_name, kBitSlicedEngineName) == 0)
+  {
+    bit_sliced_solver.reset(new Sudoku::BitSlicedSolver());
+  }
+  else if(is_pooled == true && corpus._size == kSudokuSize)
+  {
+    solver_pool.reset(new Sudoku::SolverPool(engine_name, 1));
+  }
+  else
+  {
+    solver = Sudoku::CreateSolver(engine_name, corpus._size);
+  }
+
+  std::vector<uint64_t> puzzle_ns;
+  puzzle_ns.reserve(corpus._puzzle_count * (warm_up_passes > timed_passes ? warm_up_passes : timed_passes));
+  for(int pass = 0; pass < warm_up_passes; ++pass)
+  {
+    if(bit_sliced_solver != nullptr)
+    {
+      SolveCorpus(*bit_sliced_solver, corpus, puzzle_ns);
+    }
+    else if(solver_pool != nullptr)
+    {
+      SolveCorpus(*solver_pool, corpus, puzzle_ns);
+    }
+    else
+    {
+      SolveCorpus(*solver, corpus, puzzle_ns);
+    }
+  }
+  puzzle_ns.clear();
+
+  uint64_t allocation_count = s_allocation_count.load();
+  std::chrono::steady_clock::time_point start_time = std::chrono::steady_clock::now();
+  for(int pass = 0; pass < timed_passes; ++pass)
+  {
+    result._solved_count += (bit_sliced_solver != nullptr) ? SolveCorpus(*bit_sliced_solver, corpus, puzzle_ns)
+      : (solver_pool != nullptr) ? SolveCorpus(*solver_pool, corpus, puzzle_ns) : SolveCorpus(*solver, corpus, puzzle_ns);
+  }
+  std::chrono::steady_clock::time_point end_time = std::chrono::steady_clock::now();
+  allocation_count = s_allocation_count.load() - allocation_count;
+
+  result._puzzle_count = puzzle_ns.size();
+  if(result._puzzle_count == 0)
+  {
+    return result;
+  }
+
+  double elapsed_seconds = std::chrono::duration<double>(end_time - start_time).count();
+  result._puzzles_per_second = (elapsed_seconds > 0.0) ? result._puzzle_count / elapsed_seconds : 0.0;
+  result._allocations_per_puzzle = static_cast<double>(allocation_count) / result._puzzle_count;
+
+  uint64_t total_ns = 0;
+  for(uint64_t ns : puzzle_ns)
+  {
+    total_ns += ns;
+  }
+  result._mean_ns = static_cast<double>(total_ns) / result._puzzle_count;
+
+  std::sort(puzzle_ns.begin(), puzzle_ns.end());
+  result._p50_ns = puzzle_ns[(puzzle_ns.size() - 1) * 50 / 100];
+  result._p99_ns = puzzle_ns[(puzzle_ns.size() - 1) * 99 / 100];
+  result._max_ns = puzzle_ns.back();
+
+  return result;
+}
+
+//! Solves the corpus once with no strategies, and again each time the next strategy of the pipeline is added, to show how much searching each one saves
+static void RunStrategyReport(const Corpus& corpus, std::vector<StrategyStepResult>& results)
+{
+  Sudoku::SudokuSolver solver;
+  uint64_t previous_nodes = 0;
+  for(int step = 0; step <= kDeductionStrategyCount; ++step)
+  {
+    StrategyStepResult result;
+    result._corpus_name = corpus._name;
+    result._strategy_name = (step > 0) ? Sudoku::GetDeductionStrategy(step - 1)._name : nullptr;
+    solver.SetDeductionStrategies((1u << step) - 1);
+
+    std::chrono::steady_clock::time_point start_time = std::chrono::steady_clock::now();
+    for(size_t puzzle = 0; puzzle < corpus._puzzle_count; ++puzzle)
+    {
+      solver.LoadPuzzleValues(&corpus._values[puzzle * kPuzzleLineLength]);
+      solver.SolvePuzzle();
+      result._nodes += solver.GetStats()._nodes;
+      result._eliminations += (step > 0) ? solver.GetStats()._strategy_eliminations[step - 1] : 0;
+    }
+    std::chrono::steady_clock::time_point end_time = std::chrono::steady_clock::now();
+
+    double elapsed_seconds = std::chrono::duration<double>(end_time - start_time).count();
+    result._puzzles_per_second = (elapsed_seconds > 0.0) ? corpus._puzzle_count / elapsed_seconds : 0.0;
+    result._nodes_saved = (step > 0) ? static_cast<int64_t>(previous_nodes) - static_cast<int64_t>(result._nodes) : 0;
+    previous_nodes = result._nodes;
+    results.push_back(result);
+  }
+}
+
+static void WriteStrategyReport(const std::vector<StrategyStepResult>& results, bool is_csv)
+{
+  if(is_csv == true)
+  {
+    std::printf("corpus,strategy,nodes,nodes_saved,eliminations,puzzles_per_sec\n");
+  }
+  else
+  {
+    std::printf("{\n  \"strategy_report\": [\n");
+  }
+
+  for(size_t i = 0; i < results.size(); ++i)
+  {
+    const StrategyStepResult& result = results[i];
+    const char* strategy_name = (result._strategy_name != nullptr) ? result._strategy_name : "none";
+    if(is_csv == true)
+    {
+      std::printf("%s,%s,%llu,%lld,%llu,%.1f\n", result._corpus_name.c_str(), strategy_name, static_cast<unsigned long long>(result._nodes), static_cast<long long>(result._nodes_saved),
+        static_cast<unsigned long long>(result._eliminations), result._puzzles_per_second);
+    }
+    else
+    {
+      std::printf("    { \"corpus\": \"%s\", \"strategy\": \"%s\", \"nodes\": %llu, \"nodes_saved\": %lld, \"eliminations\": %llu, \"puzzles_per_sec\": %.1f }%s\n",
+        result._corpus_name.c_str(), strategy_name, static_cast<unsigned long long>(result._nodes), static_cast<long long>(result._nodes_saved),
+        static_cast<unsigned long long>(result._eliminations), result._puzzles_per_second, (i + 1 < results.size()) ? "," : "");
+    }
+  }
+
+  if(is_csv == false)
+  {
+    std::printf("  ]\n}\n");
+  }
+}
+
+static void WriteJson(const std::vector<BenchmarkResult>& results, int timed_passes)
+{
+  std::printf("{\n  \"kernels\": \"%s\",\n  \"passes\": %d,\n  \"results\": [\n", Sudoku::GetCandidateKernels()._name, timed_passes);
+  for(size_t i = 0; i < results.size(); ++i)
+  {
+    const BenchmarkResult& result = results[i];
+    std::printf("    { \"corpus\": \"%s\", \"engine\": \"%s\", \"puzzles\": %llu, \"solved\": %llu, \"puzzles_per_sec\": %.1f, \"mean_ns\": %.1f, \"p50_ns\": %llu, \"p99_ns\": %llu, \"max_ns\": %llu, \"allocations_per_puzzle\": %.3f }%s\n",
+      result._corpus_name.c_str(), result._engine_name, static_cast<unsigned long long>(result._puzzle_count), static_cast<unsigned long long>(result._solved_count),
+      result._puzzles_per_second, result._mean_ns, static_cast<unsigned long long>(result._p50_ns), static_cast<unsigned long long>(result._p99_ns), static_cast<unsigned long long>(result._max_ns),
+      result._allocations_per_puzzle, (i + 1 < results.size()) ? "," : "");
+  }
+  std::printf("  ]\n}\n");
+}
+
+static void WriteCsv(const std::vector<BenchmarkResult>& results)
+{
+  std::printf("corpus,engine,puzzles,solved,puzzles_per_sec,mean_ns,p50_ns,p99_ns,max_ns,allocations_per_puzzle\n");
+  for(const BenchmarkResult& result : results)
+  {
+    std::printf("%s,%s,%llu,%llu,%.1f,%.1f,%llu,%llu,%llu,%.3f\n",
+      result._corpus_name.c_str(), result._engine_name, static_cast<unsigned long long>(result._puzzle_count), static_cast<unsigned long long>(result._solved_count),
+      result._puzzles_per_second, result._mean_ns, static_cast<unsigned long long>(result._p50_ns), static_cast<unsigned long long>(result._p99_ns), static_cast<unsigned long long>(result._max_ns),
+      result._allocations_per_puzzle);
+  }
+}
+
+// Usage: SudokuBenchmark [--engine <name>]... [--corpus <file>]... [--simd scalar|sse4.1|avx2] [--strategies all|none|<name>,<name>...] [--strategy-report] [--pooled] [--warm-up <passes>] [--passes <count>] [--format json|csv]
+int main(int argc, char* argv[])
+{
+  std::vector<const char*> engine_names;
+  std::vector<const char*> corpus_paths;
+  const char* kernels_name = nullptr;
+  const char* strategy_names = nullptr;
+  bool is_reporting_strategies = false;
+  bool is_pooled = false;
+  const char* format = "json";
+  int warm_up_passes = 1;
+  int timed_passes = 1;
+  for(int i = 1; i < argc; ++i)
+  {
+    if(std::strcmp(argv[i], "--engine") == 0 && i + 1 < argc)
+    {
+      engine_names.push_back(argv[++i]);
+    }
+    else if(std::strcmp(argv[i], "--corpus") == 0 && i + 1 < argc)
+    {
+      corpus_paths.push_back(argv[++i]);
+    }
+    else if(std::strcmp(argv[i], "--simd") == 0 && i + 1 < argc)
+    {
+      kernels_name = argv[++i];
+    }
+    else if(std::strcmp(argv[i], "--strategies") == 0 && i + 1 < argc)
+    {
+      strategy_names = argv[++i];
+    }
+    else if(std::strcmp(argv[i], "--strategy-report") == 0)
+    {
+      is_reporting_strategies = true;
+    }
+    else if(std::strcmp(argv[i], "--pooled") == 0)
+    {
+      is_pooled = true;
+    }
+    else if(std::strcmp(argv[i], "--warm-up") == 0 && i + 1 < argc)
+    {
+      warm_up_passes = std::max(0, std::atoi(argv[++i]));
+    }
+    else if(std::strcmp(argv[i], "--passes") == 0 && i + 1 < argc)
+    {
+      timed_passes = std::max(1, std::atoi(argv[++i]));
+    }
+    else if(std::strcmp(argv[i], "--format") == 0 && i + 1 < argc)
+    {
+      format = argv[++i];
+    }
+  }
+
+  if(engine_names.empty() == true)
+  {
+    engine_names.assign(std::begin(kDefaultEngines), std::end(kDefaultEngines));
+  }
+  if(corpus_paths.empty() == true)
+  {
+    corpus_paths.assign(std::begin(kDefaultCorpora), std::end(kDefaultCorpora));
+  }
+
+  if(std::strcmp(format, "json") != 0 && std::strcmp(format, "csv") != 0)
+  {
+    Sudoku::Logger::WriteErrorLine("Unknown format \"%s\", expected \"json\" or \"csv\"", format);
+    return 1;
+  }
+
+  if(kernels_name != nullptr && Sudoku::SelectCandidateKernels(kernels_name) == false)
+  {
+    Sudoku::Logger::WriteErrorLine("Unknown or unsupported SIMD kernels \"%s\", expected \"%s\", \"%s\" or \"%s\"", kernels_name, kScalarKernelsName, kSse41KernelsName, kAvx2KernelsName);
+    return 1;
+  }
+  if(strategy_names != nullptr && Sudoku::SelectDeductionStrategies(strategy_names) == false)
+  {
+    Sudoku::Logger::WriteErrorLine("Unknown deduction strategy in \"%s\"", strategy_names);
+    return 1;
+  }
+
+  for(const char* engine_name : engine_names)
+  {
+    if(Sudoku::CreateSolver(engine_name) == nullptr)
+    {
+      Sudoku::Logger::WriteErrorLine("Unknown engine \"%s\", expected \"%s\", \"%s\", \"%s\" or \"%s\"", engine_name, kBacktrackingEngineName, kDancingLinksEngineName, kParallelEngineName, kBitSlicedEngineName);
+      return 1;
+    }
+  }
+
+  // Picks its own strategies for every step, rather than timing the engines
+  if(is_reporting_strategies == true)
+  {
+    std::vector<StrategyStepResult> step_results;
+    for(const char* corpus_path : corpus_paths)
+    {
+      Corpus corpus;
+      if(LoadCorpus(corpus_path, corpus) == false)
+      {
+        Sudoku::Logger::WriteErrorLine("Couldn't open the corpus \"%s\"", corpus_path);
+        return 1;
+      }
+
+      // The deduction pipeline only runs on 9x9 boards
+      if(corpus._size == kSudokuSize)
+      {
+        RunStrategyReport(corpus, step_results);
+      }
+    }
+
+    WriteStrategyReport(step_results, std::strcmp(format, "csv") == 0);
+    return 0;
+  }
+
+  std::vector<BenchmarkResult> results;
+  for(const char* corpus_path : corpus_paths)
+  {
+    Corpus corpus;
+    if(LoadCorpus(corpus_path, corpus) == false)
+    {
+      Sudoku::Logger::WriteErrorLine("Couldn't open the corpus \"%s\"", corpus_path);
+      return 1;
+    }
+
+    for(const char* engine_name : engine_names)
+    {
+      // Only the backtracking engine solves boards other than 9x9, the rest skip those corpora
+      if(corpus._size == kSudokuSize || Sudoku::CreateSolver(engine_name, corpus._size) != nullptr)
+      {
+        results.push_back(RunBenchmark(engine_name, corpus, warm_up_passes, timed_passes, is_pooled));
+      }
+    }
+  }
+
+  if(std::strcmp(format, "csv") == 0)
+  {
+    WriteCsv(results);
+  }
+  else
+  {
+    WriteJson(results, timed_passes);
+  }
+
+  return 0;
+}
@@ -1,290 +1,356 @@
 #include "Logger.h"
 #include "SudokuSolver.h"
 
-#include <algorithm>
-#include <fstream>
-#include <string>
+#include "BitUtility.h"
+#include "DeductionStrategies.h"
+#include "PerformanceScopeTimer.h"
 
 namespace Sudoku
 {
 
 // --- Macros
-//! Expects a single char in the range of '0'-'9'
-#define SimpleCharToInt(c) static_cast<int>(c) - 48
-
-//! Expects a vector<Slot*>*, an integer to check against, and a bool to set if it was found
-#define SearchSlotsForNumber(slots_vector, number, was_found)\
-        for(auto iter = slots_vector->begin(); iter != slots_vector->end(); ++iter)\
-        {\
-          if((*iter)->_value == number)\
-          {\
-            was_found = true;\
-            break;\
-          }\
-        }
+//! Expects a slot index, the slot's possible values mask in the candidate board
+#define PossibleValues(slot) (&_candidate_board._cells[0][0])[kCandidateOffsets._offsets[slot]]
 
-//! Expects a vector<int>, an integer to check against, and a bool to set if it was found
-#define SearchVectorForNumber(vector, number, was_found)\
-        for(auto iter = vector.begin(); iter != vector.end(); ++iter)\
-        {\
-          if(*iter == number)\
-          {\
-            was_found = true;\
-            break;\
-          }\
-        }
+//! Expects a slot index, saves its current state to the trail so it can be restored when backtracking
+#define RecordSlot(slot) _trail.push_back({ static_cast<uint8_t>(slot), _puzzle_slots[slot]._value, PossibleValues(slot) })
 
-//! Expects a vector<Slot*>, an integer to check for, and a vector<Slot*> to store any updated slots that now only have one value
-#define RemovePossibleValue(vector, number, ready_to_solve_vector)\
-        for(auto slot_iter = vector->begin(); slot_iter != vector->end(); ++slot_iter)\
-        {\
-          for(auto possible_value_iter = (*slot_iter)->_possible_values.begin(); possible_value_iter != (*slot_iter)->_possible_values.end(); ++possible_value_iter)\
-          {\
-            if(*possible_value_iter == number)\
-            {\
-              (*slot_iter)->_possible_values.erase(possible_value_iter);\
-              if((*slot_iter)->_possible_values.size() == 1)\
-              {\
-                ready_to_solve_vector.push_back(*slot_iter);\
-              }\
-              break;\
-            }\
-          }\
-        }\
-
-//! Expects a Slot* to represent the current Slot, vector<int> for the slots possible numbers, a vector<Slot*>* for the group to check, and a bool to set if it was found
-#define CheckGroupForPossibleNumbers(self, possible_values_vector, slots_vector, was_found)\
-        for(auto values_iter = possible_values_vector.begin(); values_iter != possible_values_vector.end(); ++values_iter)\
-        {\
-          was_found = false;\
-          for(auto slot_iter = slots_vector->begin(); slot_iter != slots_vector->end(); ++slot_iter)\
-          {\
-            if(*slot_iter == self)\
-            {\
-              continue;\
-            }\
-            \
-            SearchVectorForNumber((*slot_iter)->_possible_values, *values_iter, was_found);\
-            if(was_found == true)\
-            {\
-              break;\
-            }\
-          }\
-          \
-          if(was_found == false)\
-          {\
-            self->_value = *values_iter;\
-            self->_possible_values.clear();\
-            break;\
-          }\
-        }
+//! Where the possible values of every slot live in the candidate board, counted in masks from its start
+struct CandidateOffsets
+{
+  uint8_t _offsets[kSudokuSize * kSudokuSize];
+};
 
-// --- Pubic Interface --- //
-bool SudokuSolver::LoadFromFile(const char* file_path)
+static constexpr CandidateOffsets BuildCandidateOffsets()
 {
-  std::ifstream file;
+  CandidateOffsets offsets = {};
+  for(int slot = 0; slot < kSudokuSize * kSudokuSize; ++slot)
+  {
+    offsets._offsets[slot] = static_cast<uint8_t>(((slot / kSudokuSize) * kCandidateLanes) + ColumnToLane(slot % kSudokuSize));
+  }
+  return offsets;
+}
 
-  file.open(file_path, std::ios::in);
+static constexpr CandidateOffsets kCandidateOffsets = BuildCandidateOffsets();
 
-  if(file.is_open() == false)
+//! Finds a naked single, or failing that a hidden single, among the possible values of every slot row by row. Returns false if there are none
+static bool FindLogicalSingle(const uint16_t candidates[kSudokuSize * kSudokuSize], SudokuSolver::LogicalStep& step)
+{
+  for(int slot = 0; slot < kSudokuSize * kSudokuSize; ++slot)
   {
-    // Couldn't open the file
-    return false;
+    if(Utility::PopCount(candidates[slot]) == 1)
+    {
+      step._slot = slot;
+      step._value = Utility::LowestBitIndex(candidates[slot]) + 1;
+      step._kind = kLogicalStepNakedSingle;
+      return true;
+    }
   }
 
-  std::string file_input;
-  int input_length = -1;
-  for(int line = 0; line < kSudokuSize; ++line)
+  const BoardGeometry<3>::Tables& tables = BoardGeometry<3>::kTables;
+  for(int unit = 0; unit < BoardGeometry<3>::kUnits; ++unit)
   {
-    std::getline(file, file_input);
-    input_length = static_cast<int>(file_input.length());
-    for(int index = 0; index < kSudokuSize; ++index)
+    // Values seen in exactly one slot of the unit
+    uint16_t seen_once = 0;
+    uint16_t seen_twice = 0;
+    for(int i = 0; i < kSudokuSize; ++i)
     {
-#if _DEBUG_SOLVING
-      _puzzle_slots[line][index]._grid_row = line;
-      _puzzle_slots[line][index]._grid_column = index;
-#endif
-      _puzzle_slots[line][index]._value = (index < input_length && file_input[index] >= '0' && file_input[index] <= '9') ? SimpleCharToInt(file_input[index]) : kEmptySlot;
+      uint16_t values = candidates[tables._unit_slots[unit][i]];
+      seen_twice |= seen_once & values;
+      seen_once |= values;
     }
-  }
 
-  DisplayPuzzle();
+    uint16_t hidden_values = seen_once & ~seen_twice;
+    if(hidden_values == 0)
+    {
+      continue;
+    }
 
-  return true;
+    uint16_t value = hidden_values & static_cast<uint16_t>(-hidden_values);
+    for(int i = 0; i < kSudokuSize; ++i)
+    {
+      if((candidates[tables._unit_slots[unit][i]] & value) != 0)
+      {
+        step._slot = tables._unit_slots[unit][i];
+        step._value = Utility::LowestBitIndex(value) + 1;
+        step._kind = kLogicalStepHiddenSingle;
+        return true;
+      }
+    }
+  }
+
+  return false;
 }
 
-bool SudokuSolver::Solve()
+// --- Pubic Interface --- //
+void SudokuSolver::LoadPuzzle(const int values[kSudokuSize][kSudokuSize])
 {
-  SetupDataGroups();
+  for(int slot = 0; slot < Geometry::kSlots; ++slot)
+  {
+    _puzzle_slots[slot]._value = static_cast<int8_t>(values[slot / kSudokuSize][slot % kSudokuSize]);
+  }
+}
 
-  DeterminePossibleValues();
+bool SudokuSolver::SolvePuzzle()
+{
+  return CountSolutions(1) > 0;
+}
 
-  FindSolution();
+uint64_t SudokuSolver::CountSolutions(uint64_t solution_limit)
+{
+  _solution_limit = solution_limit;
+  bool is_valid = false;
+  {
+    TimePerformanceScope("DeterminePossibleValues");
+    is_valid = DeterminePossibleValues();
+  }
 
-  Logger::NewLine();
-  Logger::WriteLine("Puzzle Solved:");
-  Logger::NewLine();
-  DisplayPuzzle();
+  if(is_valid == true)
+  {
+    TimePerformanceScope("FindSolution");
+    FindSolution();
+  }
+  else
+  {
+    // The givens already break the rules, so there's nothing to search
+    ResetSearch();
+  }
 
-  return true;
+  return _solution_count;
 }
 
-// --- Private Interface --- //
-void SudokuSolver::DisplayPuzzle() const
+void SudokuSolver::Reset()
 {
-  for(int row = 0; row < kSudokuSize; ++row)
+  for(int slot = 0; slot < Geometry::kSlots; ++slot)
   {
-    if(row != 0 && row % 3 == 0)
-    {
-      Logger::WriteLine(" -  -  -  |  -  -  -  |  -  -  - ");
-    }
+    _puzzle_slots[slot]._value = kEmptySlot;
+  }
 
-    for(int col = 0; col < kSudokuSize; ++col)
-    {
-      if(col != 0 && col % 3 == 0)
-      {
-        Logger::Write(" | ");
-      }
+  // Clears the trail and queue without giving up their storage
+  ResetSearch();
+}
 
-      if(_puzzle_slots[row][col]._value >= 0)
-      {
-        // Solved
-        Logger::Write("[%d]", _puzzle_slots[row][col]._value);
-      }
-      else
-      {
-        // Empty
-        Logger::Write("[ ]");
-      }
-    }
+bool SudokuSolver::PrepareSearch()
+{
+  TimePerformanceScope("PrepareSearch");
+
+  bool is_valid = DeterminePossibleValues();
+
+  ResetSearch();
+
+  ++_stats._nodes;
+  return is_valid == true && PropagateConstraints() == true;
+}
+
+void SudokuSolver::CollectSearchPaths(int depth, std::vector<SearchPath>& search_paths)
+{
+  search_paths.clear();
+
+  SearchPath current_path;
+  CollectSearchPaths(depth, current_path, search_paths);
+}
+
+uint64_t SudokuSolver::SearchFromPath(const SearchPath& search_path, uint64_t solution_limit)
+{
+  TimePerformanceScope("SearchFromPath");
+
+  _solution_limit = solution_limit;
+  _solution_count = 0;
+
+  // The path's values count as guesses already made
+  _search_depth = search_path._length;
+  _stats._max_depth = (static_cast<uint64_t>(_search_depth) > _stats._max_depth) ? _search_depth : _stats._max_depth;
+
+  size_t trail_mark = _trail.size();
+  bool is_valid = true;
+  for(int i = 0; i < search_path._length && is_valid == true; ++i)
+  {
+    is_valid = PlaceValue(search_path._slot_indices[i], search_path._values[i]) == true && PropagateConstraints() == true;
+  }
 
-    Logger::NewLine();
+  if(is_valid == true)
+  {
+    Search();
   }
+
+  UndoTrail(trail_mark);
+  _newly_single_slots.clear();
+
+  return _solution_count;
 }
 
-void SudokuSolver::SetupDataGroups()
+void SudokuSolver::CopySolution(int values[kSudokuSize][kSudokuSize]) const
 {
-  int row_group_index = 0;
-  int col_group_index = 0;
-  for(int row = 0; row < kSudokuSize; ++row)
+  for(int slot = 0; slot < Geometry::kSlots; ++slot)
   {
-    row_group_index = (row / 3) * 3;
+    values[slot / kSudokuSize][slot % kSudokuSize] = _solution_values[slot];
+  }
+}
 
-    for(int col = 0; col < kSudokuSize; ++col)
-    {
-      int col_group_index = (col / 3);
+bool SudokuSolver::StartEditing()
+{
+  bool is_valid = DeterminePossibleValues();
+  ResetSearch();
+  return is_valid;
+}
 
-      // TODO-OPT: Should probably separate the empty slots from the solved ones, to save time on iterating
-      // Add to group
-      _groups[row_group_index + col_group_index].push_back(&_puzzle_slots[row][col]);
-      _puzzle_slots[row][col]._group = &_groups[row_group_index + col_group_index];
+bool SudokuSolver::SetCell(int slot, int value)
+{
+  // Slots and values come straight from user input
+  if(slot < 0 || slot >= Geometry::kSlots || value < 1 || value > kSudokuSize)
+  {
+    return false;
+  }
 
-      // Add to the columns
-      _columns[col].push_back(&_puzzle_slots[row][col]);
-      _puzzle_slots[row][col]._column = &_columns[col];
+  int previous_value = _puzzle_slots[slot]._value;
+  if(previous_value != kEmptySlot)
+  {
+    ClearCell(slot);
+  }
 
-      // Add to the rows
-      _rows[row].push_back(&_puzzle_slots[row][col]);
-      _puzzle_slots[row][col]._row = &_rows[row];
+  if((GetUnplacedValues(slot) & ValueToMask(value)) == 0)
+  {
+    if(previous_value != kEmptySlot)
+    {
+      SetCell(slot, previous_value);
     }
+    return false;
   }
 
-#if _DEBUG_DATA
-  VisualizeDataGroups();
-#endif
+  SetSlotValue(slot, value);
+  const Geometry::Index* peers = Geometry::kTables._peers[slot];
+  for(int i = 0; i < Geometry::kPeerCount; ++i)
+  {
+    PossibleValues(peers[i]) &= ~ValueToMask(value);
+  }
+
+  return true;
 }
 
-void SudokuSolver::VisualizeDataGroups() const
+void SudokuSolver::ClearCell(int slot)
 {
-  Logger::NewLine();
+  if(slot < 0 || slot >= Geometry::kSlots)
+  {
+    return;
+  }
 
-  // Visualize the Groups
-  for(int i = 0; i < kSudokuSize; ++i)
+  int value = _puzzle_slots[slot]._value;
+  if(value == kEmptySlot)
   {
-    Logger::WriteLine("Group #%d:", i);
-    for(auto slot : _groups[i])
+    return;
+  }
+
+  const uint8_t* units = Geometry::kTables._slot_units[slot];
+  _unit_values._rows[units[0]] &= ~ValueToMask(value);
+  _unit_values._columns[units[1] - kSudokuSize] &= ~ValueToMask(value);
+  _unit_values._groups[units[2] - (kSudokuSize * 2)] &= ~ValueToMask(value);
+  _puzzle_slots[slot]._value = kEmptySlot;
+  PossibleValues(slot) = GetUnplacedValues(slot);
+
+  // Another peer may still hold the value, so each empty peer is worked out again rather than just given the value back
+  const Geometry::Index* peers = Geometry::kTables._peers[slot];
+  for(int i = 0; i < Geometry::kPeerCount; ++i)
+  {
+    if(_puzzle_slots[peers[i]]._value == kEmptySlot)
     {
-      Logger::Write("%d  ", slot->_value);
+      PossibleValues(peers[i]) = GetUnplacedValues(peers[i]);
     }
-    Logger::NewLine(2);
   }
+}
 
-  // Visualize the Columns
-  Logger::NewLine(2);
-  for(int i = 0; i < kSudokuSize; ++i)
+uint16_t SudokuSolver::GetCandidates(int slot) const
+{
+  if(slot < 0 || slot >= Geometry::kSlots)
   {
-    Logger::WriteLine("Column #%d:", i);
-    for(auto slot : _columns[i])
+    return 0;
+  }
+
+  return PossibleValues(slot);
+}
+
+bool SudokuSolver::NextLogicalStep(LogicalStep& step) const
+{
+  uint16_t candidates[Geometry::kSlots];
+  for(int slot = 0; slot < Geometry::kSlots; ++slot)
+  {
+    candidates[slot] = PossibleValues(slot);
+  }
+
+  step._strategy_index = -1;
+  if(FindLogicalSingle(candidates, step) == true)
+  {
+    return true;
+  }
+
+  // Cheapest first, starting over from the first strategy whenever one takes values away
+  int index = 0;
+  while(index < kDeductionStrategyCount)
+  {
+    uint16_t removed[Geometry::kSlots] = {};
+    if((_strategies & (1u << index)) == 0 || GetDeductionStrategy(index).Apply(candidates, removed) == false)
     {
-      Logger::Write("%d  ", slot->_value);
+      ++index;
+      continue;
     }
-    Logger::NewLine(2);
+
+    for(int slot = 0; slot < Geometry::kSlots; ++slot)
+    {
+      candidates[slot] &= ~removed[slot];
+    }
+    step._strategy_index = index;
+    if(FindLogicalSingle(candidates, step) == true)
+    {
+      return true;
+    }
+    index = 0;
   }
 
-  // Visualize the Rows
-  Logger::NewLine(2);
-  for(int i = 0; i < kSudokuSize; ++i)
+  return false;
+}
+
+// --- Private Interface --- //
+void SudokuSolver::VisualizeDataGroups() const
+{
+  const Geometry::Tables& tables = Geometry::kTables;
+  const char* unit_names[3] = { "Row", "Column", "Group" };
+
+  // Visualize the Rows, Columns and Groups
+  Logger::NewLine();
+  for(int unit = 0; unit < Geometry::kUnits; ++unit)
   {
-    Logger::WriteLine("Row #%d:", i);
-    for(auto slot : _rows[i])
+    Logger::WriteLine("%s #%d:", unit_names[unit / kSudokuSize], unit % kSudokuSize);
+    for(int i = 0; i < kSudokuSize; ++i)
     {
-      Logger::Write("%d  ", slot->_value);
+      Logger::Write("%d  ", _puzzle_slots[tables._unit_slots[unit][i]]._value);
     }
     Logger::NewLine(2);
   }
 }
 
-void SudokuSolver::DeterminePossibleValues()
+bool SudokuSolver::DeterminePossibleValues()
 {
-  bool number_found = false;
-
-  for(int row = 0; row < kSudokuSize; ++row)
+  // Mark the values that have already been placed
+  CandidateBoard placed_values = {};
+  for(int slot = 0; slot < Geometry::kSlots; ++slot)
   {
-    for(int col = 0; col < kSudokuSize; ++col)
+    if(_puzzle_slots[slot]._value != kEmptySlot)
     {
-      if(_puzzle_slots[row][col]._value != kEmptySlot)
-      {
-        continue;
-      }
-
-      for(int possible_number = 1; possible_number <= kSudokuSize; ++possible_number)
-      {
-        number_found = false;
-
-        // Search the Group
-        SearchSlotsForNumber(_puzzle_slots[row][col]._group, possible_number, number_found);
-        if(number_found == true)
-        {
-          // Early out
-          continue;
-        }
+      (&placed_values._cells[0][0])[kCandidateOffsets._offsets[slot]] = ValueToMask(_puzzle_slots[slot]._value);
+    }
+  }
 
-        // Search the Column
-        SearchSlotsForNumber(_puzzle_slots[row][col]._column, possible_number, number_found);
-        if(number_found == true)
-        {
-          // Early out
-          continue;
-        }
+  // Anything not used by the slot's group, column or row is still possible
+  bool is_valid = _kernels->ComputeCandidates(placed_values, _candidate_board, _unit_values);
 
-        // Search the Row
-        SearchSlotsForNumber(_puzzle_slots[row][col]._row, possible_number, number_found);
-        if(number_found == true)
-        {
-          // Early out
-          continue;
-        }
+  if(Logger::IsEnabled(kLogLevelDebug) == true)
+  {
+    VisualizeDataGroups();
 
-        // Add the possible number
-        _puzzle_slots[row][col]._possible_values.push_back(possible_number);
-      }
-    }
+    //! Change the parameters to visualize whatever slot you want to see
+    VisualizePossibleValues(0, 2);
   }
 
-#if _DEBUG_DATA
-  //! Change the parameters to visualize whatever slot you want to see
-  VisualizePossibleValues(0, 2);
-#endif
+  return is_valid;
 }
 
 void SudokuSolver::VisualizePossibleValues(int row, int column) const
@@ -292,195 +358,353 @@ void SudokuSolver::VisualizePossibleValues(int row, int column) const
   Logger::NewLine();
 
   Logger::WriteLine("Possible Values for Slot [%d][%d]:", row, column);
-  for(auto possible_value : _puzzle_slots[row][column]._possible_values)
+  for(int possible_value = 1; possible_value <= kSudokuSize; ++possible_value)
   {
-    Logger::Write("%d ", possible_value);
+    if((PossibleValues((row * kSudokuSize) + column) & ValueToMask(possible_value)) != 0)
+    {
+      Logger::Write("%d ", possible_value);
+    }
   }
 
   Logger::NewLine();
 }
 
-void SudokuSolver::FindSolution()
+bool SudokuSolver::FindSolution()
+{
+  ResetSearch();
+
+  LogTraceLine("Beginning to solve the puzzle ...");
+
+  Search();
+
+  if(_solution_count > 0)
+  {
+    // Counting more than one solution unwinds the search, so put the first one back
+    for(int slot = 0; slot < Geometry::kSlots; ++slot)
+    {
+      _puzzle_slots[slot]._value = _solution_values[slot];
+      PossibleValues(slot) = 0;
+    }
+  }
+
+  return _solution_count > 0;
+}
+
+void SudokuSolver::ResetSearch()
 {
-  // A vector with all of the empty slots
-  std::vector<Slot*> empty_slots;
-  empty_slots.reserve(kSudokuSize * kSudokuSize); // The maximum we'll ever need
-  // A vector for any slots that were updated, and now only have 1 possible value
-  std::vector<Slot*> newly_single_slots;
-  newly_single_slots.reserve(8); // Probably won't have more than this at one time?
+  // Every placement records itself plus at most the 20 slots that share a group, column or row with it
+  _trail.clear();
+  _trail.reserve(kSudokuSize * kSudokuSize * 21);
+  _newly_single_slots.clear();
+  _newly_single_slots.reserve(kSudokuSize * kSudokuSize);
+  _stats = SolverStats();
+  _search_depth = 0;
+  _solution_count = 0;
+  StartBudget();
+}
 
-  // Find all the empty slots that need to be solved
-  for(int row = 0; row < kSudokuSize; ++row)
+bool SudokuSolver::Search()
+{
+  ++_stats._nodes;
+
+  if(IsOverBudget() == true || (_cancel_flag != nullptr && _cancel_flag->load(std::memory_order_relaxed) == true))
   {
-    for(int col = 0; col < kSudokuSize; ++col)
+    // Stop searching, the same as if the solution limit was reached
+    return true;
+  }
+
+  if(PropagateConstraints() == false)
+  {
+    return false;
+  }
+
+  int branch_slot = FindBranchSlot();
+  if(branch_slot == Geometry::kSlots)
+  {
+    // Every slot has been filled
+    if(_solution_count == 0)
     {
-      if(_puzzle_slots[row][col]._value == kEmptySlot)
+      for(int slot = 0; slot < Geometry::kSlots; ++slot)
       {
-        empty_slots.push_back(&_puzzle_slots[row][col]);
+        _solution_values[slot] = _puzzle_slots[slot]._value;
       }
     }
+
+    ++_solution_count;
+    return _solution_limit != 0 && _solution_count >= _solution_limit;
   }
 
-  // Sort the vector by number of possible values
-  struct {
-    bool operator()(Slot* a, Slot* b)
+  uint16_t remaining_values = PossibleValues(branch_slot);
+  while(remaining_values != 0)
+  {
+    int value = Utility::LowestBitIndex(remaining_values) + 1;
+    remaining_values &= remaining_values - 1;
+
+    LogTraceLine("Guessing Slot[%d,%d] with value: %d", branch_slot / kSudokuSize, branch_slot % kSudokuSize, value);
+
+    ++_stats._guesses;
+    ++_search_depth;
+    _stats._max_depth = (static_cast<uint64_t>(_search_depth) > _stats._max_depth) ? _search_depth : _stats._max_depth;
+
+    size_t trail_mark = _trail.size();
+    if(PlaceValue(branch_slot, value) == true && Search() == true)
     {
-      // TODO-OPT: Might be more efficient to sort the other way, so the less possibilities are at the end, so removing is cheaper?
-      return a->_possible_values.size() < b->_possible_values.size();
+      return true;
     }
-  } SlotPossibleValuesSort;
-  std::sort(empty_slots.begin(), empty_slots.end(), SlotPossibleValuesSort);
 
-  // Start solving away
-#if _DEBUG_SOLVING
-  Logger::NewLine();
-  Logger::WriteLine("Beginning to solve the puzzle ...");
-#endif
+    UndoTrail(trail_mark);
+    _newly_single_slots.clear();
+    --_search_depth;
+    ++_stats._backtracks;
+  }
 
-  int back_slot_offset = 0;
-  while(empty_slots.empty() == false)
+  return false;
+}
+
+int SudokuSolver::FindBranchSlot() const
+{
+  // Branch on the empty slot with the fewest possible values
+  int branch_slot = Geometry::kSlots;
+  int branch_count = kSudokuSize + 1;
+  for(int slot = 0; slot < Geometry::kSlots; ++slot)
   {
-    if(empty_slots[0]->_possible_values.size() == 1)
+    if(_puzzle_slots[slot]._value != kEmptySlot)
     {
-      // Only one possible value
-      empty_slots[0]->_value = empty_slots[0]->_possible_values[0];
-      empty_slots[0]->_possible_values.clear();
+      continue;
+    }
 
-      // Remove that value from any associated spots that may also share that number
-      RemovePossibleValue(empty_slots[0]->_group, empty_slots[0]->_value, newly_single_slots);
-      RemovePossibleValue(empty_slots[0]->_column, empty_slots[0]->_value, newly_single_slots);
-      RemovePossibleValue(empty_slots[0]->_row, empty_slots[0]->_value, newly_single_slots);
+    int count = Utility::PopCount(PossibleValues(slot));
+    if(count < branch_count)
+    {
+      branch_slot = slot;
+      branch_count = count;
+      if(count == 2)
+      {
+        // Can't do any better than this
+        break;
+      }
+    }
+  }
 
-#if _DEBUG_SOLVING
-      Logger::WriteLine("Solved Slot[%d,%d] with value: %d", empty_slots[0]->_grid_row, empty_slots[0]->_grid_column, empty_slots[0]->_value);
-#endif
+  return branch_slot;
+}
 
-      // Remove this slot from the empty slots
-      empty_slots.erase(empty_slots.begin());
+void SudokuSolver::CollectSearchPaths(int depth, SearchPath& current_path, std::vector<SearchPath>& search_paths)
+{
+  int branch_slot = FindBranchSlot();
+  if(depth == 0 || branch_slot == Geometry::kSlots || current_path._length == kMaxSearchPathLength)
+  {
+    search_paths.push_back(current_path);
+    return;
+  }
+
+  uint16_t remaining_values = PossibleValues(branch_slot);
+  while(remaining_values != 0)
+  {
+    int value = Utility::LowestBitIndex(remaining_values) + 1;
+    remaining_values &= remaining_values - 1;
+
+    size_t trail_mark = _trail.size();
+    if(PlaceValue(branch_slot, value) == true && PropagateConstraints() == true)
+    {
+      current_path._slot_indices[current_path._length] = static_cast<uint8_t>(branch_slot);
+      current_path._values[current_path._length] = static_cast<uint8_t>(value);
+      ++current_path._length;
+      CollectSearchPaths(depth - 1, current_path, search_paths);
+      --current_path._length;
     }
-    else if(newly_single_slots.empty() == false)
+
+    UndoTrail(trail_mark);
+    _newly_single_slots.clear();
+  }
+}
+
+bool SudokuSolver::PropagateConstraints()
+{
+  bool is_valid = true;
+  bool made_progress = true;
+  while(is_valid == true && made_progress == true)
+  {
+    made_progress = false;
+    ++_stats._propagation_rounds;
+
+    // Handle any slots that were left with a single possible value
+    while(is_valid == true && _newly_single_slots.empty() == false)
     {
-#if _DEBUG_SOLVING
-      Logger::WriteLine("Handling the Newly Single Slots ...");
-#endif
-      do {
-        // In rare cases, this slot could have been solved after it was added to the newly_single_slots vector, if so, just remove this slot
-        if(newly_single_slots[0]->_value == kEmptySlot)
-        {
-          // Only one possible value
-          newly_single_slots[0]->_value = newly_single_slots[0]->_possible_values[0];
-          newly_single_slots[0]->_possible_values.clear();
-
-          // Remove that value from any associated spots that may also share that number
-          RemovePossibleValue(newly_single_slots[0]->_group, newly_single_slots[0]->_value, newly_single_slots);
-          RemovePossibleValue(newly_single_slots[0]->_column, newly_single_slots[0]->_value, newly_single_slots);
-          RemovePossibleValue(newly_single_slots[0]->_row, newly_single_slots[0]->_value, newly_single_slots);
-
-#if _DEBUG_SOLVING
-          Logger::WriteLine("Solved Slot[%d,%d] with value: %d", newly_single_slots[0]->_grid_row, newly_single_slots[0]->_grid_column, newly_single_slots[0]->_value);
-#endif
-
-          // Remove it from the empty slots vector
-          // TODO-OPT: there's gotta be a better way than doing this
-          for(size_t i = 0; i < empty_slots.size(); ++i)
-          {
-            if(empty_slots[i] == newly_single_slots[0])
-            {
-              empty_slots.erase(empty_slots.begin() + i);
-              --i;
-            }
-          }
-        }
+      int slot = _newly_single_slots.back();
+      _newly_single_slots.pop_back();
+
+      // This slot could have been solved, or lost its last value, after it was added
+      if(_puzzle_slots[slot]._value == kEmptySlot && Utility::PopCount(PossibleValues(slot)) == 1)
+      {
+        is_valid = PlaceValue(slot, Utility::LowestBitIndex(PossibleValues(slot)) + 1);
+        ++_stats._naked_singles;
+      }
+    }
 
-        // Remove this slot from the vector
-        newly_single_slots.erase(newly_single_slots.begin());
-      } while(newly_single_slots.empty() == false);
+    if(is_valid == false)
+    {
+      break;
     }
-    else
+
+    // Find every naked and hidden single on the board at once, the queue is empty so this pass sees every placement so far
+    uint16_t single_lanes[kSudokuSize];
+    is_valid = _kernels->FindSingles(_candidate_board, _unit_values, _singles, single_lanes);
+    for(int row = 0; row < kSudokuSize && is_valid == true; ++row)
     {
-#if _DEBUG_SOLVING
-      Logger::WriteLine("Beginning slot has more than 1 possible value, checking slots against their groups ...");
-#endif
-      
-      bool was_found = false;
-      do {
-#if _DEBUG_SOLVING
-        //Logger::WriteLine("Checking Slot[%d,%d] for possible solutions ...", empty_slots[0]->_grid_row, empty_slots[0]->_grid_column);
-#endif
-
-        was_found = false;
-        // Check the 3x3 group
-        CheckGroupForPossibleNumbers(empty_slots[0], empty_slots[0]->_possible_values, empty_slots[0]->_group, was_found);
-
-        if(was_found == false)
+      uint16_t lanes = single_lanes[row];
+      while(lanes != 0 && is_valid == true)
+      {
+        int lane = Utility::LowestBitIndex(lanes);
+        lanes &= lanes - 1;
+
+        // A single placed earlier in this pass can take the value away, and then it has nowhere left to go
+        int slot = (row * kSudokuSize) + LaneToColumn(lane);
+        uint16_t single_value = _singles._cells[row][lane];
+        if(Utility::PopCount(PossibleValues(slot)) == 1)
         {
-          // Remove that value from any associated spots that may also share that number
-          RemovePossibleValue(empty_slots[0]->_column, empty_slots[0]->_value, newly_single_slots);
-          RemovePossibleValue(empty_slots[0]->_row, empty_slots[0]->_value, newly_single_slots);
+          ++_stats._naked_singles;
+        }
+        else
+        {
+          ++_stats._hidden_singles;
+        }
+        is_valid = (PossibleValues(slot) & single_value) != 0 && PlaceValue(slot, Utility::LowestBitIndex(single_value) + 1);
+        made_progress = true;
+      }
+    }
 
-#if _DEBUG_SOLVING
-          Logger::WriteLine("Solved Slot[%d,%d] with value: %d", empty_slots[0]->_grid_row, empty_slots[0]->_grid_column, empty_slots[0]->_value);
-#endif
+    // Singles have stalled, so try the deduction strategies before the search has to guess
+    if(is_valid == true && made_progress == false && _strategies != 0)
+    {
+      is_valid = ApplyDeductionStrategies(made_progress);
+    }
+  }
 
-          // Remove this slot from the empty slots
-          empty_slots.erase(empty_slots.begin());
-          continue;
-        }
+  if(is_valid == false)
+  {
+    _newly_single_slots.clear();
+  }
 
-        // Check the Column group
-        CheckGroupForPossibleNumbers(empty_slots[0], empty_slots[0]->_possible_values, empty_slots[0]->_column, was_found);
-        if(was_found == false)
-        {
-          // Remove that value from any associated spots that may also share that number
-          RemovePossibleValue(empty_slots[0]->_group, empty_slots[0]->_value, newly_single_slots);
-          RemovePossibleValue(empty_slots[0]->_row, empty_slots[0]->_value, newly_single_slots);
+  return is_valid;
+}
 
-#if _DEBUG_SOLVING
-          Logger::WriteLine("Solved Slot[%d,%d] with value: %d", empty_slots[0]->_grid_row, empty_slots[0]->_grid_column, empty_slots[0]->_value);
-#endif
+bool SudokuSolver::ApplyDeductionStrategies(bool& made_progress)
+{
+  uint16_t candidates[Geometry::kSlots];
+  for(int slot = 0; slot < Geometry::kSlots; ++slot)
+  {
+    candidates[slot] = PossibleValues(slot);
+  }
 
-          // Remove this slot from the empty slots
-          empty_slots.erase(empty_slots.begin());
-          continue;
-        }
+  // Cheapest first, going back to singles as soon as one strategy takes anything away
+  for(int index = 0; index < kDeductionStrategyCount; ++index)
+  {
+    uint16_t removed[Geometry::kSlots] = {};
+    if((_strategies & (1u << index)) == 0 || GetDeductionStrategy(index).Apply(candidates, removed) == false)
+    {
+      continue;
+    }
 
-        // Check the Row group
-        CheckGroupForPossibleNumbers(empty_slots[0], empty_slots[0]->_possible_values, empty_slots[0]->_row, was_found);
-        if(was_found == false)
-        {
-          // Remove that value from any associated spots that may also share that number
-          RemovePossibleValue(empty_slots[0]->_group, empty_slots[0]->_value, newly_single_slots);
-          RemovePossibleValue(empty_slots[0]->_column, empty_slots[0]->_value, newly_single_slots);
+    bool is_valid = true;
+    for(int slot = 0; slot < Geometry::kSlots; ++slot)
+    {
+      if(removed[slot] == 0)
+      {
+        continue;
+      }
 
-#if _DEBUG_SOLVING
-          Logger::WriteLine("Solved Slot[%d,%d] with value: %d", empty_slots[0]->_grid_row, empty_slots[0]->_grid_column, empty_slots[0]->_value);
-#endif
+      RecordSlot(slot);
+      PossibleValues(slot) &= ~removed[slot];
+      _stats._strategy_eliminations[index] += Utility::PopCount(removed[slot]);
+      if(PossibleValues(slot) == 0)
+      {
+        is_valid = false;
+      }
+      else if(Utility::PopCount(PossibleValues(slot)) == 1)
+      {
+        _newly_single_slots.push_back(static_cast<uint8_t>(slot));
+      }
+    }
 
-          // Remove this slot from the empty slots
-          empty_slots.erase(empty_slots.begin());
-          continue;
-        }
-        else
-        {
-          // That slot's not ready to be solved yet, swap it to the end of the vector
-          if(back_slot_offset == empty_slots.size() - 2)
-          {
-            back_slot_offset = 0;
-          }
-          std::iter_swap(empty_slots.begin(), empty_slots.begin() + (empty_slots.size() - 1 - back_slot_offset));
-          ++back_slot_offset;
-        }
+    made_progress = true;
+    return is_valid;
+  }
 
-      } while(newly_single_slots.empty() == true && empty_slots.empty() == false);
+  return true;
+}
 
-      if(newly_single_slots.empty() == true && empty_slots.empty() == false && empty_slots[0]->_possible_values.size() > 1)
+bool SudokuSolver::PlaceValue(int slot, int value)
+{
+  RecordSlot(slot);
+  SetSlotValue(slot, value);
+
+  LogTraceLine("Solved Slot[%d,%d] with value: %d", slot / kSudokuSize, slot % kSudokuSize, value);
+
+  // Remove that value from any associated spots that may also share that number
+  bool is_valid = true;
+  const uint8_t* peers = Geometry::kTables._peers[slot];
+  for(int i = 0; i < Geometry::kPeerCount; ++i)
+  {
+    int peer = peers[i];
+    if((PossibleValues(peer) & ValueToMask(value)) != 0)
+    {
+      RecordSlot(peer);
+      PossibleValues(peer) &= ~ValueToMask(value);
+      ++_stats._eliminations;
+      if(PossibleValues(peer) == 0)
+      {
+        is_valid = false;
+      }
+      else if(Utility::PopCount(PossibleValues(peer)) == 1)
       {
-        // TODO - still no single possible value slots
-        int debug = 0;
-        debug = 0;
+        _newly_single_slots.push_back(static_cast<uint8_t>(peer));
       }
     }
   }
+
+  return is_valid;
+}
+
+void SudokuSolver::UndoTrail(size_t trail_mark)
+{
+  const Geometry::Tables& tables = Geometry::kTables;
+
+  while(_trail.size() > trail_mark)
+  {
+    const TrailEntry& entry = _trail.back();
+    Slot& slot = _puzzle_slots[entry._slot];
+    if(entry._value == kEmptySlot && slot._value != kEmptySlot)
+    {
+      // The slot was solved after this entry, so its value is no longer placed
+      const uint8_t* units = tables._slot_units[entry._slot];
+      _unit_values._rows[units[0]] &= ~ValueToMask(slot._value);
+      _unit_values._columns[units[1] - kSudokuSize] &= ~ValueToMask(slot._value);
+      _unit_values._groups[units[2] - (kSudokuSize * 2)] &= ~ValueToMask(slot._value);
+    }
+
+    slot._value = entry._value;
+    PossibleValues(entry._slot) = entry._possible_values;
+    _trail.pop_back();
+  }
+}
+
+void SudokuSolver::SetSlotValue(int slot, int value)
+{
+  _puzzle_slots[slot]._value = static_cast<int8_t>(value);
+  PossibleValues(slot) = 0;
+
+  const uint8_t* units = Geometry::kTables._slot_units[slot];
+  _unit_values._rows[units[0]] |= ValueToMask(value);
+  _unit_values._columns[units[1] - kSudokuSize] |= ValueToMask(value);
+  _unit_values._groups[units[2] - (kSudokuSize * 2)] |= ValueToMask(value);
+}
+
+uint16_t SudokuSolver::GetUnplacedValues(int slot) const
+{
+  const uint8_t* units = Geometry::kTables._slot_units[slot];
+  uint16_t placed_values = _unit_values._rows[units[0]] | _unit_values._columns[units[1] - kSudokuSize] | _unit_values._groups[units[2] - (kSudokuSize * 2)];
+  return Geometry::kAllValues & ~placed_values;
 }
 
 } // namespace Sudoku
@@ -0,0 +1,39 @@
+#include "ThreadUtility.h"
+
+#include <thread>
+
+#if defined(_WIN32)
+#include <Windows.h>
+#elif defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace Utility
+{
+
+int GetHardwareThreadCount()
+{
+  unsigned int thread_count = std::thread::hardware_concurrency();
+  return thread_count > 0 ? static_cast<int>(thread_count) : 1;
+}
+
+bool PinCurrentThread(int core_index)
+{
+#if defined(_WIN32)
+  if(core_index >= static_cast<int>(sizeof(DWORD_PTR) * 8))
+  {
+    return false;
+  }
+  return SetThreadAffinityMask(GetCurrentThread(), static_cast<DWORD_PTR>(1) << core_index) != 0;
+#elif defined(__linux__)
+  cpu_set_t cpu_set;
+  CPU_ZERO(&cpu_set);
+  CPU_SET(core_index, &cpu_set);
+  return pthread_setaffinity_np(pthread_self(), sizeof(cpu_set), &cpu_set) == 0;
+#else
+  return false;
+#endif
+}
+
+} // namespace Utility